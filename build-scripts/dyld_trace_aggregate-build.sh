@@ -0,0 +1,12 @@
+#!/bin/sh
+
+# Builds dyld_trace_aggregate, which only needs a C++17 compiler and the standard library, so this
+# works on any platform, not just Darwin.  Set CXX to pick the compiler, and OUTPUT for where to put it
+
+set -e
+
+SRCROOT=${SRCROOT:-$(cd "$(dirname "$0")/.." && pwd)}
+CXX=${CXX:-c++}
+OUTPUT=${OUTPUT:-dyld_trace_aggregate}
+
+${CXX} -std=c++17 -O2 -Wall -pthread -I"${SRCROOT}/other-tools" "${SRCROOT}/other-tools/dyld_trace_aggregate.cpp" -o "${OUTPUT}"
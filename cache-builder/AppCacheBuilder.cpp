@@ -218,6 +218,17 @@ void AppCacheBuilder::forEachRegion(void (^callback)(const Region& region)) cons
     // We don't count this as its not a real region
 }
 
+// Runs the work for each index on the dispatch pool, unless the options ask for serial passes.
+// Every caller writes only to state owned by its index, so both give the same output
+void AppCacheBuilder::parallelApply(size_t count, void (^work)(size_t index)) const {
+    if ( appCacheOptions.serialPasses ) {
+        for ( size_t i = 0; i != count; ++i )
+            work(i);
+    } else {
+        dispatch_apply(count, DISPATCH_APPLY_AUTO, work);
+    }
+}
+
 uint64_t AppCacheBuilder::numRegions() const {
     __block uint64_t count = 0;
 
@@ -1286,8 +1297,18 @@ void AppCacheBuilder::assignSegmentAddresses() {
 void AppCacheBuilder::copyRawSegments() {
     const bool log = false;
 
-    // Call the base class to copy segment data
-    CacheBuilder::copyRawSegments();
+    // Each kext copies to its own segments, so they can all be copied in parallel
+    parallelApply(sortedDylibs.size(), ^(size_t index) {
+        const AppCacheDylibInfo& dylib = sortedDylibs[index];
+        for (const SegmentMappingInfo& info : dylib.cacheLocation) {
+            if (log) fprintf(stderr, "copy %s segment %15.*s (0x%08X bytes) from %p to %p (logical addr 0x%llX) for %s\n",
+                             _options.archs->name(), (int)info.segName.size(), info.segName.data(),
+                             info.copySegmentSize, info.srcSegment, info.dstSegment, info.dstCacheUnslidAddress, dylib.input->mappedFile.runtimePath.c_str());
+            ::memcpy(info.dstSegment, info.srcSegment, info.copySegmentSize);
+        }
+    });
+
+    copyCoalescedSections();
 
     // The copy any custom sections
     for (const CustomSegment& segment : customSegments) {
@@ -1302,6 +1323,37 @@ void AppCacheBuilder::copyRawSegments() {
     }
 }
 
+// This is CacheBuilder::adjustAllImagesForNewSegmentLocations(), but each kext is adjusted in parallel.
+// The ASLR tracker isn't thread safe, so each kext records its fixups in its own tracker, and those are
+// added to the main tracker in kext order once all kexts are done
+void AppCacheBuilder::adjustAllKextsForNewSegmentLocations() {
+    std::vector<cache_builder::ASLR_Tracker> kextTrackersOwner(sortedDylibs.size());
+    auto& kextTrackers = kextTrackersOwner;
+    for (cache_builder::ASLR_Tracker& kextTracker : kextTrackers)
+        kextTracker.startRecording();
+
+    parallelApply(sortedDylibs.size(), ^(size_t index) {
+        const AppCacheDylibInfo& dylib = sortedDylibs[index];
+        Diagnostics& dylibDiag = *dylib.errors;
+        if ( dylibDiag.hasError() )
+            return;
+        adjustDylibSegments(dylib, dylibDiag, cacheBaseAddress, kextTrackers[index], nullptr, &dylib._coalescer);
+    });
+
+    bool badDylib = false;
+    for (uint64_t i = 0; i != sortedDylibs.size(); ++i) {
+        if ( sortedDylibs[i].errors->hasError() ) {
+            badDylib = true;
+            continue;
+        }
+        _aslrTracker.addRecorded(kextTrackers[i]);
+    }
+
+    if ( badDylib && !_diagnostics.hasError() ) {
+        _diagnostics.error("One or more binaries has an error which prevented linking.  See other errors.");
+    }
+}
+
 static uint8_t getFixupLevel(AppCacheBuilder::Options::AppCacheKind kind) {
     uint8_t currentLevel = (uint8_t)~0U;
     switch (kind) {
@@ -3714,7 +3766,7 @@ void AppCacheBuilder::processFixups()
             dylibDatas.emplace_back((DylibData){ ma, dylibDiag, dylibID });
         });
 
-        dispatch_apply(dylibDatas.size(), DISPATCH_APPLY_AUTO, ^(size_t index) {
+        parallelApply(dylibDatas.size(), ^(size_t index) {
             DylibData& dylibData = dylibDatas[index];
             processBinary(dylibData.dylibDiag, dylibData.ma, dylibData.dylibID, currentLevel);
         });
@@ -3789,7 +3841,7 @@ void AppCacheBuilder::processFixups()
             });
         });
 
-        dispatch_apply(dylibFixups.size(), DISPATCH_APPLY_AUTO, ^(size_t index) {
+        parallelApply(dylibFixups.size(), ^(size_t index) {
             DylibFixups& dylibFixup = dylibFixups[index];
             dylibFixup.processFixups(dylibsToSymbols, symbolMap, kernelID, _aslrTracker);
         });
@@ -4133,12 +4185,14 @@ void AppCacheBuilder::writeFixups()
             startsInSegment->segment_offset     = segmentFixups.unslidLoadAddress - baseAddress;
             startsInSegment->max_valid_pointer  = 0; // FIXME: Needed in 32-bit only
             startsInSegment->page_count         = (segmentFixups.sizeInUse + startsInSegment->page_size - 1) / startsInSegment->page_size;
-            for (uint64_t pageIndex = 0; pageIndex != startsInSegment->page_count; ++pageIndex) {
+            // Chains never cross pages, and the tracker is only read here, so each page is chained in parallel
+            uint8_t* segmentBuffer = segmentFixups.segmentBuffer;
+            parallelApply(startsInSegment->page_count, ^(size_t pageIndex) {
                 startsInSegment->page_start[pageIndex] = DYLD_CHAINED_PTR_START_NONE;
                 uint8_t* lastLoc = nullptr;
                 // Note we always walk in 1-byte at a time as x86_64 has unaligned fixups
                 for (uint64_t pageOffset = 0; pageOffset != startsInSegment->page_size; pageOffset += 1) {
-                    uint8_t* fixupLoc = segmentFixups.segmentBuffer + (pageIndex * startsInSegment->page_size) + pageOffset;
+                    uint8_t* fixupLoc = segmentBuffer + (pageIndex * startsInSegment->page_size) + pageOffset;
                     uint8_t fixupLevel = currentLevel;
                     if ( !_aslrTracker.has(fixupLoc, &fixupLevel) )
                         continue;
@@ -4195,7 +4249,7 @@ void AppCacheBuilder::writeFixups()
                         assert(locBits->target == targetVMOffset && "target truncated");
                     }
                 }
-            }
+            });
         }
 
         chainedFixupsBufferEnd = byteBuffer.begin();
@@ -5378,11 +5432,12 @@ void AppCacheBuilder::buildAppCache(const std::vector<InputDylib>& dylibs)
             _aslrTracker.setDataRegion(firstDataRegion->buffer, size);
         }
     }
-    adjustAllImagesForNewSegmentLocations(cacheBaseAddress, nullptr);
+    adjustAllKextsForNewSegmentLocations();
     if ( _diagnostics.hasError() )
         return;
 
     // Once we have the final addresses, we can emit the prelink info segment
+    uint64_t t3a = mach_absolute_time();
     generatePrelinkInfo();
     if ( _diagnostics.hasError() )
         return;
@@ -5527,12 +5582,13 @@ void AppCacheBuilder::buildAppCache(const std::vector<InputDylib>& dylibs)
     if ( _options.verbose ) {
         fprintf(stderr, "time to layout cache: %ums\n", absolutetime_to_milliseconds(t2-t1));
         fprintf(stderr, "time to copy cached dylibs into buffer: %ums\n", absolutetime_to_milliseconds(t3-t2));
-        fprintf(stderr, "time to adjust segments for new split locations: %ums\n", absolutetime_to_milliseconds(t4-t3));
+        fprintf(stderr, "time to adjust segments for new split locations: %ums\n", absolutetime_to_milliseconds(t3a-t3));
+        fprintf(stderr, "time to generate prelink info: %ums\n", absolutetime_to_milliseconds(t4-t3a));
         fprintf(stderr, "time to bind all images: %ums\n", absolutetime_to_milliseconds(t5-t4));
         fprintf(stderr, "time to optimize Objective-C: %ums\n", absolutetime_to_milliseconds(t6-t5));
         fprintf(stderr, "time to do stub elimination: %ums\n", absolutetime_to_milliseconds(t7-t6));
         fprintf(stderr, "time to optimize LINKEDITs: %ums\n", absolutetime_to_milliseconds(t8-t7));
-        fprintf(stderr, "time to compute slide info: %ums\n", absolutetime_to_milliseconds(t10-t9));
+        fprintf(stderr, "time to write fixup chains: %ums\n", absolutetime_to_milliseconds(t10-t9));
         fprintf(stderr, "time to compute UUID and codesign cache file: %ums\n", absolutetime_to_milliseconds(t11-t10));
     }
 }
@@ -53,8 +53,9 @@ public:
             allExceptKernel // Strip everything other than the static kernel
         };
 
-        AppCacheKind    cacheKind = AppCacheKind::none;
-        StripMode       stripMode = StripMode::none;
+        AppCacheKind    cacheKind       = AppCacheKind::none;
+        StripMode       stripMode       = StripMode::none;
+        bool            serialPasses    = false;    // Run the per-kext passes on one thread, eg, to compare against the parallel output
     };
     AppCacheBuilder(const DyldSharedCache::CreateOptions& dyldCacheOptions, const Options& appCacheOptions,
                     const dyld3::closure::FileSystem& fileSystem);
@@ -155,6 +156,7 @@ private:
     void                                allocateBuffer();
     void                                assignSegmentRegionsAndOffsets();
     void                                copyRawSegments();
+    void                                adjustAllKextsForNewSegmentLocations();
     void                                assignSegmentAddresses();
     void                                generateCacheHeader();
     void                                generatePrelinkInfo();
@@ -174,6 +176,7 @@ private:
     uint64_t                            numWritablePagesToFixup(uint64_t numBytesToFixup) const;
     bool                                fixupsArePerKext() const;
     void                                forEachRegion(void (^callback)(const Region& region)) const;
+    void                                parallelApply(size_t count, void (^work)(size_t index)) const;
 
     bool                                hasSancovGateSection() const;
 
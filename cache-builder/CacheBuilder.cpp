@@ -63,6 +63,13 @@ void CacheBuilder::copyRawSegments()
         }
     });
 
+    copyCoalescedSections();
+}
+
+void CacheBuilder::copyCoalescedSections()
+{
+    const bool log = false;
+
     // Copy the coalesced __TEXT sections
     for ( const auto* coalescedSection : { &_objcCoalescedClassNames, &_objcCoalescedMethodNames, &_objcCoalescedMethodTypes } ) {
         if ( coalescedSection->bufferSize == 0 )
@@ -265,6 +265,7 @@ protected:
                                                    const CacheBuilder::DylibSectionCoalescer* sectionCoalescer)) = 0;
 
     void        copyRawSegments();
+    void        copyCoalescedSections();
     void        adjustAllImagesForNewSegmentLocations(uint64_t cacheBaseAddress,
                                                       LOH_Tracker* lohTracker);
 
@@ -41,6 +41,7 @@
 #include "DyldSharedCache.h"
 #include "CacheBuilder.h"
 #include "MachOLoaded.h"
+#include "LinkeditMerger.h"
 
 #define ALIGN_AS_TYPE(value, type) \
         ((value + alignof(type) - 1) & (-alignof(type)))
@@ -195,17 +196,20 @@ public:
     uint32_t        linkeditSize() { return _linkeditSize; }
     uint64_t        linkeditAddr() { return _linkeditAddr; }
     const char*     dylibID() { return _dylibID; }
-    void            copyWeakBindingInfo(uint8_t* newLinkEditContent, uint32_t& offset);
-    void            copyLazyBindingInfo(uint8_t* newLinkEditContent, uint32_t& offset);
-    void            copyBindingInfo(uint8_t* newLinkEditContent, uint32_t& offset);
-    void            copyExportInfo(uint8_t* newLinkEditContent, uint32_t& offset);
-    void            copyExportedSymbols(uint8_t* newLinkEditContent, SortedStringPool& stringPool, uint32_t& offset, uint32_t& symbolIndex);
-    void            copyImportedSymbols(uint8_t* newLinkEditContent, SortedStringPool& stringPool, uint32_t& offset, uint32_t& symbolIndex);
-    void            copyLocalSymbols(uint8_t* newLinkEditContent, SortedStringPool& stringPool, uint32_t& offset, uint32_t& symbolIndex,
+    void            addWeakBindingInfo(LinkeditMerger& merger, LinkeditMerger::RegionIndex region);
+    void            addLazyBindingInfo(LinkeditMerger& merger, LinkeditMerger::RegionIndex region);
+    void            addBindingInfo(LinkeditMerger& merger, LinkeditMerger::RegionIndex region);
+    void            addExportInfo(LinkeditMerger& merger, LinkeditMerger::RegionIndex region);
+    void            addFunctionStarts(LinkeditMerger& merger, LinkeditMerger::RegionIndex region);
+    void            addDataInCode(LinkeditMerger& merger, LinkeditMerger::RegionIndex region);
+    void            addSymbols(LinkeditMerger& merger, LinkeditMerger::RegionIndex region, const macho_nlist<P>* newSymbolTable);
+    void            addIndirectSymbolTable(LinkeditMerger& merger, LinkeditMerger::RegionIndex region);
+    uint32_t        maxSymbolCount();
+    void            copyExportedSymbols(macho_nlist<P>* newSymbolTable, SortedStringPool& stringPool, uint32_t& symbolIndex);
+    void            copyImportedSymbols(macho_nlist<P>* newSymbolTable, SortedStringPool& stringPool, uint32_t& symbolIndex);
+    void            copyLocalSymbols(macho_nlist<P>* newSymbolTable, SortedStringPool& stringPool, uint32_t& symbolIndex,
                                      UnmappedLocalsOptimizer *locals);
-    void            copyFunctionStarts(uint8_t* newLinkEditContent, uint32_t& offset);
-    void            copyDataInCode(uint8_t* newLinkEditContent, uint32_t& offset);
-    void            copyIndirectSymbolTable(uint8_t* newLinkEditContent, uint32_t& offset);
+    void            copyIndirectSymbolTable(uint8_t* newIndirectTable) const;
     void            updateLoadCommands(uint32_t linkeditStartOffset, uint64_t mergedLinkeditAddr, uint64_t newLinkeditSize,
                                        uint32_t sharedSymbolTableStartOffset, uint32_t sharedSymbolTableCount,
                                        uint32_t sharedSymbolStringsOffset, uint32_t sharedSymbolStringsSize);
@@ -555,89 +559,96 @@ void LinkeditOptimizer<P>::updateLoadCommands(uint32_t mergedLinkeditStartOffset
 }
 
 template <typename P>
-void LinkeditOptimizer<P>::copyWeakBindingInfo(uint8_t* newLinkEditContent, uint32_t& offset)
+void LinkeditOptimizer<P>::addWeakBindingInfo(LinkeditMerger& merger, LinkeditMerger::RegionIndex region)
 {
     if ( _dyldInfo == nullptr )
         return;
     unsigned size = _dyldInfo->weak_bind_size();
     if ( size != 0 ) {
-        ::memcpy(&newLinkEditContent[offset], &_linkeditBias[_dyldInfo->weak_bind_off()], size);
-        _newWeakBindingInfoOffset = offset;
+        merger.addPiece(region, &_linkeditBias[_dyldInfo->weak_bind_off()], size, &_newWeakBindingInfoOffset);
         _newWeakBindingSize = size;
-        offset += size;
     }
 }
 
 
 template <typename P>
-void LinkeditOptimizer<P>::copyLazyBindingInfo(uint8_t* newLinkEditContent, uint32_t& offset)
+void LinkeditOptimizer<P>::addLazyBindingInfo(LinkeditMerger& merger, LinkeditMerger::RegionIndex region)
 {
     if ( _dyldInfo == nullptr )
         return;
     unsigned size = _dyldInfo->lazy_bind_size();
-    if ( size != 0 ) {
-        ::memcpy(&newLinkEditContent[offset], &_linkeditBias[_dyldInfo->lazy_bind_off()], size);
-        _newLazyBindingInfoOffset = offset;
-        offset += size;
-    }
+    if ( size != 0 )
+        merger.addPiece(region, &_linkeditBias[_dyldInfo->lazy_bind_off()], size, &_newLazyBindingInfoOffset);
 }
 
 template <typename P>
-void LinkeditOptimizer<P>::copyBindingInfo(uint8_t* newLinkEditContent, uint32_t& offset)
+void LinkeditOptimizer<P>::addBindingInfo(LinkeditMerger& merger, LinkeditMerger::RegionIndex region)
 {
     if ( _dyldInfo == nullptr )
         return;
     unsigned size = _dyldInfo->bind_size();
-    if ( size != 0 ) {
-        ::memcpy(&newLinkEditContent[offset], &_linkeditBias[_dyldInfo->bind_off()], size);
-        _newBindingInfoOffset = offset;
-        offset += size;
-    }
+    if ( size != 0 )
+        merger.addPiece(region, &_linkeditBias[_dyldInfo->bind_off()], size, &_newBindingInfoOffset);
 }
 
 template <typename P>
-void LinkeditOptimizer<P>::copyExportInfo(uint8_t* newLinkEditContent, uint32_t& offset)
+void LinkeditOptimizer<P>::addExportInfo(LinkeditMerger& merger, LinkeditMerger::RegionIndex region)
 {
     if ( (_dyldInfo == nullptr) && (_exportTrieCmd == nullptr) )
         return;
 
     uint32_t exportOffset = _exportTrieCmd ? _exportTrieCmd->dataoff() : _dyldInfo->export_off();
     uint32_t exportSize   = _exportTrieCmd ? _exportTrieCmd->datasize() : _dyldInfo->export_size();
-    if ( exportSize != 0 ) {
-        ::memcpy(&newLinkEditContent[offset], &_linkeditBias[exportOffset], exportSize);
-        _newExportInfoOffset = offset;
-        offset += exportSize;
-    }
+    if ( exportSize != 0 )
+        merger.addPiece(region, &_linkeditBias[exportOffset], exportSize, &_newExportInfoOffset);
 }
 
 
 template <typename P>
-void LinkeditOptimizer<P>::copyFunctionStarts(uint8_t* newLinkEditContent, uint32_t& offset)
+void LinkeditOptimizer<P>::addFunctionStarts(LinkeditMerger& merger, LinkeditMerger::RegionIndex region)
 {
     if ( _functionStartsCmd == nullptr )
         return;
-    unsigned size = _functionStartsCmd->datasize();
-    ::memcpy(&newLinkEditContent[offset], &_linkeditBias[_functionStartsCmd->dataoff()], size);
-    _newFunctionStartsOffset = offset;
-    offset += size;
+    merger.addPiece(region, &_linkeditBias[_functionStartsCmd->dataoff()], _functionStartsCmd->datasize(), &_newFunctionStartsOffset);
 }
 
 template <typename P>
-void LinkeditOptimizer<P>::copyDataInCode(uint8_t* newLinkEditContent, uint32_t& offset)
+void LinkeditOptimizer<P>::addDataInCode(LinkeditMerger& merger, LinkeditMerger::RegionIndex region)
 {
     if ( _dataInCodeCmd == nullptr )
         return;
-    unsigned size = _dataInCodeCmd->datasize();
-    ::memcpy(&newLinkEditContent[offset], &_linkeditBias[_dataInCodeCmd->dataoff()], size);
-    _newDataInCodeOffset = offset;
-    offset += size;
+    merger.addPiece(region, &_linkeditBias[_dataInCodeCmd->dataoff()], _dataInCodeCmd->datasize(), &_newDataInCodeOffset);
+}
+
+// The locals, exports, and imports of this image were copied consecutively to the shared symbol table
+template <typename P>
+void LinkeditOptimizer<P>::addSymbols(LinkeditMerger& merger, LinkeditMerger::RegionIndex region, const macho_nlist<P>* newSymbolTable)
+{
+    uint32_t symbolCount = _newLocalSymbolCount + _newExportedSymbolCount + _newImportedSymbolCount;
+    merger.addPiece(region, &newSymbolTable[_newLocalSymbolsStartIndex], symbolCount * sizeof(macho_nlist<P>));
 }
 
+// Every image gets a piece, even if empty, so that the piece index matches the image index
+template <typename P>
+void LinkeditOptimizer<P>::addIndirectSymbolTable(LinkeditMerger& merger, LinkeditMerger::RegionIndex region)
+{
+    uint32_t size = (_dynSymTabCmd != nullptr) ? (_dynSymTabCmd->nindirectsyms() * sizeof(uint32_t)) : 0;
+    merger.addPiece(region, nullptr, size, &_newIndirectSymbolTableOffset);
+}
 
+// An upper bound on how many entries the copy*Symbols() methods add to the shared symbol table
 template <typename P>
-void LinkeditOptimizer<P>::copyLocalSymbols(uint8_t* newLinkEditContent, SortedStringPool& stringPool,
-                                            uint32_t& offset, uint32_t& symbolIndex,
-                                            UnmappedLocalsOptimizer *locals)
+uint32_t LinkeditOptimizer<P>::maxSymbolCount()
+{
+    if ( _dynSymTabCmd == nullptr )
+        return 0;
+    return _dynSymTabCmd->nlocalsym() + _dynSymTabCmd->nextdefsym() + _dynSymTabCmd->nundefsym();
+}
+
+
+template <typename P>
+void LinkeditOptimizer<P>::copyLocalSymbols(macho_nlist<P>* newSymbolTable, SortedStringPool& stringPool,
+                                            uint32_t& symbolIndex, UnmappedLocalsOptimizer *locals)
 {
     LocalSymbolInfo* localInfo = nullptr;
     if ( locals != nullptr ) {
@@ -672,14 +683,12 @@ void LinkeditOptimizer<P>::copyLocalSymbols(uint8_t* newLinkEditContent, SortedS
          if ( (entry->n_type() & N_STAB) != 0)
             continue;
         const char* name = &strings[entry->n_strx()];
-        macho_nlist<P>* newSymbolEntry = (macho_nlist<P>*)&newLinkEditContent[offset];
-        *newSymbolEntry = *entry;
+        newSymbolTable[symbolIndex] = *entry;
         if ( locals != nullptr ) {
             // if removing local symbols, change __text symbols to "<redacted>" so backtraces don't have bogus names
             if ( entry->n_sect() == 1 ) {
                 stringPool.add(symbolIndex, "<redacted>");
                 ++symbolIndex;
-                offset += sizeof(macho_nlist<P>);
             }
             // copy local symbol to unmmapped locals area
             locals->symbolsStringPool.add(locals->unmappedSymbolsNListCount, name);
@@ -692,7 +701,6 @@ void LinkeditOptimizer<P>::copyLocalSymbols(uint8_t* newLinkEditContent, SortedS
         else {
             stringPool.add(symbolIndex, name);
             ++symbolIndex;
-            offset += sizeof(macho_nlist<P>);
        }
     }
     _newLocalSymbolCount = symbolIndex - _newLocalSymbolsStartIndex;
@@ -704,7 +712,7 @@ void LinkeditOptimizer<P>::copyLocalSymbols(uint8_t* newLinkEditContent, SortedS
 
 
 template <typename P>
-void LinkeditOptimizer<P>::copyExportedSymbols(uint8_t* newLinkEditContent, SortedStringPool& stringPool, uint32_t& offset, uint32_t& symbolIndex)
+void LinkeditOptimizer<P>::copyExportedSymbols(macho_nlist<P>* newSymbolTable, SortedStringPool& stringPool, uint32_t& symbolIndex)
 {
     _newExportedSymbolsStartIndex = symbolIndex;
     _newExportedSymbolCount = 0;
@@ -734,19 +742,18 @@ void LinkeditOptimizer<P>::copyExportedSymbols(uint8_t* newLinkEditContent, Sort
             continue;
         if ( strncmp(name, "$ld$", 4) == 0 )
             continue;
-        macho_nlist<P>* newSymbolEntry = (macho_nlist<P>*)&newLinkEditContent[offset];
+        macho_nlist<P>* newSymbolEntry = &newSymbolTable[symbolIndex];
         *newSymbolEntry = *entry;
         newSymbolEntry->set_n_strx(0);
         stringPool.add(symbolIndex, name);
         _oldToNewSymbolIndexes[oldSymbolIndex] = symbolIndex - _newLocalSymbolsStartIndex;
         ++symbolIndex;
-        offset += sizeof(macho_nlist<P>);
     }
     _newExportedSymbolCount = symbolIndex - _newExportedSymbolsStartIndex;
 }
 
 template <typename P>
-void LinkeditOptimizer<P>::copyImportedSymbols(uint8_t* newLinkEditContent, SortedStringPool& stringPool, uint32_t& offset, uint32_t& symbolIndex)
+void LinkeditOptimizer<P>::copyImportedSymbols(macho_nlist<P>* newSymbolTable, SortedStringPool& stringPool, uint32_t& symbolIndex)
 {
     _newImportedSymbolsStartIndex = symbolIndex;
     _newImportedSymbolCount = 0;
@@ -772,34 +779,35 @@ void LinkeditOptimizer<P>::copyImportedSymbols(uint8_t* newLinkEditContent, Sort
         if ( (entry->n_type() & N_TYPE) != N_UNDF)
             continue;
         const char* name = &strings[entry->n_strx()];
-        macho_nlist<P>* newSymbolEntry = (macho_nlist<P>*)&newLinkEditContent[offset];
+        macho_nlist<P>* newSymbolEntry = &newSymbolTable[symbolIndex];
         *newSymbolEntry = *entry;
         newSymbolEntry->set_n_strx(0);
         stringPool.add(symbolIndex, name);
         _oldToNewSymbolIndexes[oldSymbolIndex] = symbolIndex - _newLocalSymbolsStartIndex;
         ++symbolIndex;
-        offset += sizeof(macho_nlist<P>);
     }
     _newImportedSymbolCount = symbolIndex - _newImportedSymbolsStartIndex;
 }
 
+// Note this is called in parallel with other images, so must not modify any state
 template <typename P>
-void LinkeditOptimizer<P>::copyIndirectSymbolTable(uint8_t* newLinkEditContent, uint32_t& offset)
+void LinkeditOptimizer<P>::copyIndirectSymbolTable(uint8_t* newIndirectTableContent) const
 {
-    _newIndirectSymbolTableOffset = offset;
-
     if ( _dynSymTabCmd == nullptr )
         return;
 
-     const uint32_t* const indirectTable = (uint32_t*)&_linkeditBias[_dynSymTabCmd->indirectsymoff()];
-    uint32_t* newIndirectTable = (uint32_t*)&newLinkEditContent[offset];
+    const uint32_t* const indirectTable = (uint32_t*)&_linkeditBias[_dynSymTabCmd->indirectsymoff()];
+    uint32_t* newIndirectTable = (uint32_t*)newIndirectTableContent;
     for (uint32_t i=0; i < _dynSymTabCmd->nindirectsyms(); ++i) {
         uint32_t symbolIndex = E::get32(indirectTable[i]);
-        if ( (symbolIndex == INDIRECT_SYMBOL_ABS) || (symbolIndex == INDIRECT_SYMBOL_LOCAL) )
+        if ( (symbolIndex == INDIRECT_SYMBOL_ABS) || (symbolIndex == INDIRECT_SYMBOL_LOCAL) ) {
             E::set32(newIndirectTable[i], symbolIndex);
-        else
-            E::set32(newIndirectTable[i], _oldToNewSymbolIndexes[symbolIndex]);
-        offset += sizeof(uint32_t);
+        }
+        else {
+            // Symbols which were dropped from the symbol table map to 0, as they did before
+            auto it = _oldToNewSymbolIndexes.find(symbolIndex);
+            E::set32(newIndirectTable[i], (it != _oldToNewSymbolIndexes.end()) ? it->second : 0);
+        }
     }
 }
 
@@ -811,102 +819,88 @@ void LinkeditOptimizer<P>::mergeLinkedits(Diagnostics& diagnostics,
                                           DyldSharedCache::LocalSymbolsMode localSymbolMode,
                                           std::vector<LinkeditOptimizer<P>*>& optimizers)
 {
-    // allocate space for new linkedit data
     uint64_t totalUnoptLinkeditsSize = readOnlyRegion.sizeInUse - nonLinkEditReadOnlySize;
-    uint8_t* newLinkEdit = (uint8_t*)calloc(totalUnoptLinkeditsSize, 1);
     SortedStringPool stringPool;
-    uint32_t offset = 0;
 
     diagnostics.verbose("Merged LINKEDIT:\n");
 
-    // copy weak binding info
-    uint32_t startWeakBindInfosOffset = offset;
-    for (LinkeditOptimizer<P>* op : optimizers) {
-        // Skip chained fixups as the in-place linked list isn't valid any more
-        const dyld3::MachOFile* mf = (dyld3::MachOFile*)op->machHeader();
-        if (!mf->hasChainedFixups())
-            op->copyWeakBindingInfo(newLinkEdit, offset);
-    }
-    diagnostics.verbose("  weak bindings size:      %5uKB\n", (uint32_t)(offset-startWeakBindInfosOffset)/1024);
-
-    // copy export info
-    uint32_t startExportInfosOffset = offset;
-    for (LinkeditOptimizer<P>* op : optimizers) {
-        op->copyExportInfo(newLinkEdit, offset);
-    }
-    diagnostics.verbose("  exports info size:       %5uKB\n", (uint32_t)(offset-startExportInfosOffset)/1024);
-
-    // in theory, an optimized cache can drop the binding info
-    if ( true ) {
-        // copy binding info
-        uint32_t startBindingsInfosOffset = offset;
-        for (LinkeditOptimizer<P>* op : optimizers) {
-            // Skip chained fixups as the in-place linked list isn't valid any more
-            const dyld3::MachOFile* mf = (dyld3::MachOFile*)op->machHeader();
-            if (!mf->hasChainedFixups())
-                op->copyBindingInfo(newLinkEdit, offset);
-        }
-        diagnostics.verbose("  bindings size:           %5uKB\n", (uint32_t)(offset-startBindingsInfosOffset)/1024);
-
-       // copy lazy binding info
-        uint32_t startLazyBindingsInfosOffset = offset;
-        for (LinkeditOptimizer<P>* op : optimizers) {
-            // Skip chained fixups as the in-place linked list isn't valid any more
-            const dyld3::MachOFile* mf = (dyld3::MachOFile*)op->machHeader();
-            if (!mf->hasChainedFixups())
-                op->copyLazyBindingInfo(newLinkEdit, offset);
-        }
-        diagnostics.verbose("  lazy bindings size:      %5uKB\n", (offset-startLazyBindingsInfosOffset)/1024);
-    }
+    // The symbol table has to be built serially, as the string pool and unmapped locals are shared.
+    // Build it first in to its own buffer, so that its size is known when laying out the rest of LINKEDIT
+    uint32_t maxSymbolCount = 0;
+    for (LinkeditOptimizer<P>* op : optimizers)
+        maxSymbolCount += op->maxSymbolCount();
+    std::vector<macho_nlist<P>> newSymbolTable(maxSymbolCount);
 
     bool unmapLocals = ( localSymbolMode == DyldSharedCache::LocalSymbolsMode::unmap );
 
     uint32_t symbolIndex = 0;
-    const uint32_t sharedSymbolTableStartOffset = offset;
     uint32_t sharedSymbolTableExportsCount = 0;
     uint32_t sharedSymbolTableImportsCount = 0;
     for (LinkeditOptimizer<P>* op : optimizers) {
-         op->copyLocalSymbols(newLinkEdit, stringPool, offset, symbolIndex,
+         op->copyLocalSymbols(newSymbolTable.data(), stringPool, symbolIndex,
                               unmapLocals ? localSymbolsOptimizer : nullptr);
         uint32_t x = symbolIndex;
-        op->copyExportedSymbols(newLinkEdit, stringPool, offset, symbolIndex);
+        op->copyExportedSymbols(newSymbolTable.data(), stringPool, symbolIndex);
         sharedSymbolTableExportsCount += (symbolIndex-x);
         uint32_t y = symbolIndex;
-        op->copyImportedSymbols(newLinkEdit, stringPool, offset, symbolIndex);
+        op->copyImportedSymbols(newSymbolTable.data(), stringPool, symbolIndex);
         sharedSymbolTableImportsCount += (symbolIndex-y);
     }
     uint32_t sharedSymbolTableCount = symbolIndex;
-    const uint32_t sharedSymbolTableEndOffset = offset;
 
-    // copy function starts
-    uint32_t startFunctionStartsOffset = offset;
-    for (LinkeditOptimizer<P>* op : optimizers) {
-        op->copyFunctionStarts(newLinkEdit, offset);
-    }
-    diagnostics.verbose("  function starts size:    %5uKB\n", (offset-startFunctionStartsOffset)/1024);
-
-    // copy data-in-code info
-    uint32_t startDataInCodeOffset = offset;
-    for (LinkeditOptimizer<P>* op : optimizers) {
-        op->copyDataInCode(newLinkEdit, offset);
-    }
-    diagnostics.verbose("  data in code size:       %5uKB\n", (offset-startDataInCodeOffset)/1024);
+    // Pass 1: add every image's pieces to each region, then lay them all out
+    LinkeditMerger merger;
+    const LinkeditMerger::RegionIndex weakBindRegion        = merger.addRegion("weak bindings size:");
+    const LinkeditMerger::RegionIndex exportsRegion         = merger.addRegion("exports info size:");
+    const LinkeditMerger::RegionIndex bindRegion            = merger.addRegion("bindings size:");
+    const LinkeditMerger::RegionIndex lazyBindRegion        = merger.addRegion("lazy bindings size:");
+    const LinkeditMerger::RegionIndex symbolTableRegion     = merger.addRegion("symbol table size:");
+    const LinkeditMerger::RegionIndex functionStartsRegion  = merger.addRegion("function starts size:");
+    const LinkeditMerger::RegionIndex dataInCodeRegion      = merger.addRegion("data in code size:");
+    const LinkeditMerger::RegionIndex indirectSymbolsRegion = merger.addRegion("indirect symbols size:");
+    // if indirect table has odd number of entries, end will not be 8-byte aligned
+    const LinkeditMerger::RegionIndex stringPoolRegion      = merger.addRegion("symbol string pool size:", sizeof(typename P::uint_t));
 
-    // copy indirect symbol tables
     for (LinkeditOptimizer<P>* op : optimizers) {
-        op->copyIndirectSymbolTable(newLinkEdit, offset);
-    }
-    // if indirect table has odd number of entries, end will not be 8-byte aligned
-    if ( (offset % sizeof(typename P::uint_t)) != 0 )
-        offset += 4;
-
-    // copy string pool
-    uint32_t sharedSymbolStringsOffset = offset;
-    uint32_t sharedSymbolStringsSize = stringPool.copyPoolAndUpdateOffsets((char*)&newLinkEdit[sharedSymbolStringsOffset], (macho_nlist<P>*)&newLinkEdit[sharedSymbolTableStartOffset]);
-    offset += sharedSymbolStringsSize;
-    uint32_t newLinkeditUnalignedSize = offset;
-    uint64_t newLinkeditAlignedSize = align(offset, 14);
-    diagnostics.verbose("  symbol table size:       %5uKB (%d exports, %d imports)\n", (sharedSymbolTableEndOffset-sharedSymbolTableStartOffset)/1024, sharedSymbolTableExportsCount, sharedSymbolTableImportsCount);
+        // Skip chained fixups as the in-place linked list isn't valid any more
+        const dyld3::MachOFile* mf = (dyld3::MachOFile*)op->machHeader();
+        if (!mf->hasChainedFixups()) {
+            op->addWeakBindingInfo(merger, weakBindRegion);
+            // in theory, an optimized cache can drop the binding info
+            op->addBindingInfo(merger, bindRegion);
+            op->addLazyBindingInfo(merger, lazyBindRegion);
+        }
+        op->addExportInfo(merger, exportsRegion);
+        op->addSymbols(merger, symbolTableRegion, newSymbolTable.data());
+        op->addFunctionStarts(merger, functionStartsRegion);
+        op->addDataInCode(merger, dataInCodeRegion);
+        op->addIndirectSymbolTable(merger, indirectSymbolsRegion);
+    }
+    merger.addPiece(stringPoolRegion, nullptr, stringPool.size());
+
+    uint32_t newLinkeditUnalignedSize = (uint32_t)merger.layout();
+    uint64_t newLinkeditAlignedSize = align(newLinkeditUnalignedSize, 14);
+    assert(newLinkeditAlignedSize <= totalUnoptLinkeditsSize);
+    uint8_t* newLinkEdit = (uint8_t*)calloc(newLinkeditAlignedSize, 1);
+
+    // The string pool has to be written before the symbol table is copied, as it sets the n_strx of each symbol
+    const uint32_t sharedSymbolTableStartOffset = (uint32_t)merger.regionOffset(symbolTableRegion);
+    const uint32_t sharedSymbolStringsOffset    = (uint32_t)merger.regionOffset(stringPoolRegion);
+    uint32_t sharedSymbolStringsSize = stringPool.copyPoolAndUpdateOffsets((char*)&newLinkEdit[sharedSymbolStringsOffset], newSymbolTable.data());
+    assert(sharedSymbolStringsSize == merger.regionSize(stringPoolRegion));
+
+    // Pass 2: copy every image's pieces in parallel
+    merger.copy(newLinkEdit);
+    const std::vector<LinkeditOptimizer<P>*>& constOptimizers = optimizers;
+    merger.forEachPiece(indirectSymbolsRegion, newLinkEdit, ^(size_t index, uint8_t* content, uint64_t size) {
+        constOptimizers[index]->copyIndirectSymbolTable(content);
+    });
+
+    for ( LinkeditMerger::RegionIndex region : { weakBindRegion, exportsRegion, bindRegion, lazyBindRegion,
+                                                 functionStartsRegion, dataInCodeRegion } ) {
+        diagnostics.verbose("  %-24s %5uKB\n", merger.regionName(region), (uint32_t)merger.regionSize(region)/1024);
+    }
+    diagnostics.verbose("  symbol table size:       %5uKB (%d exports, %d imports)\n", (uint32_t)merger.regionSize(symbolTableRegion)/1024, sharedSymbolTableExportsCount, sharedSymbolTableImportsCount);
     diagnostics.verbose("  symbol string pool size: %5uKB\n", sharedSymbolStringsSize/1024);
 
     // overwrite mapped LINKEDIT area in cache with new merged LINKEDIT content
@@ -107,6 +107,7 @@ static void exit_usage(const char* missingOption = nullptr) {
     fprintf(stderr, "Common options:\n");
     fprintf(stderr, "  -arch xxx        the arch to use to create the app cache\n");
     fprintf(stderr, "  -platform xxx    the platform to use to create the app cache\n");
+    fprintf(stderr, "  -serial-passes   run the per-kext passes on one thread, to compare against the default parallel output\n");
 
     exit(1);
 }
@@ -148,6 +149,7 @@ struct CreateKernelCollectionOptions {
     std::vector<const char*>                bundleIDs;
     bool                                    verbose                 = false;
     bool                                    printJSONErrors         = false;
+    bool                                    serialPasses            = false;
     CollectionKind                          collectionKind          = unknownKC;
     StripMode                               stripMode               = unknownStripMode;
     std::vector<SectionData>                sections;
@@ -294,6 +296,10 @@ static bool parseArgs(int argc, const char* argv[], OptionsVariants& options) {
             exitOrGetState<CreateKernelCollectionOptions>(options, arg).verbose = true;
             continue;
         }
+        if (strcmp(arg, "-serial-passes") == 0) {
+            exitOrGetState<CreateKernelCollectionOptions>(options, arg).serialPasses = true;
+            continue;
+        }
         if (strcmp(arg, "-json-errors") == 0) {
             exitOrGetState<CreateKernelCollectionOptions>(options, arg).printJSONErrors = true;
             continue;
@@ -1020,8 +1026,9 @@ createKernelCollectionForArch(const CreateKernelCollectionOptions& options, cons
     KernelCollectionBuilder* kcb = nullptr;
     {
         CFStringRef archStringRef = CFStringCreateWithCString(kCFAllocatorDefault, arch, kCFStringEncodingASCII);
-        BuildOptions_v1 buildOptions = { 1, options.collectionKind, options.stripMode, archStringRef, options.verbose };
-        kcb = createKernelCollectionBuilder(&buildOptions);
+        BuildOptions_v2 buildOptions = { 2, options.collectionKind, options.stripMode, archStringRef, options.verbose,
+                                         options.serialPasses };
+        kcb = createKernelCollectionBuilder((const BuildOptions_v1*)&buildOptions);
         CFRelease(archStringRef);
     }
 
@@ -689,7 +689,7 @@ static void buildCacheFromJSONManifest(Diagnostics& diags, const SharedCacheBuil
     }
 
     // Parse the rest of the options node.
-    BuildOptions_v3 buildOptions;
+    BuildOptions_v4 buildOptions;
     buildOptions.version                            = json::parseRequiredInt(diags, json::getRequiredValue(diags, buildOptionsNode, "version"));
     buildOptions.updateName                         = json::parseRequiredString(diags, json::getRequiredValue(diags, buildOptionsNode, "updateName")).c_str();
     buildOptions.deviceName                         = json::parseRequiredString(diags, json::getRequiredValue(diags, buildOptionsNode, "deviceName")).c_str();
@@ -727,6 +727,18 @@ static void buildCacheFromJSONManifest(Diagnostics& diags, const SharedCacheBuil
             buildOptions.printStats = json::parseRequiredBool(diags, *printStatsNode);
     }
 
+    // compactLocalSymbols and parallelObjCClosures were added in version 4
+    buildOptions.compactLocalSymbols = false;
+    buildOptions.parallelObjCClosures = false;
+    if ( buildOptions.version >= 4 ) {
+        const json::Node* compactLocalSymbolsNode = json::getOptionalValue(diags, buildOptionsNode, "compactLocalSymbols");
+        if ( compactLocalSymbolsNode != nullptr )
+            buildOptions.compactLocalSymbols = json::parseRequiredBool(diags, *compactLocalSymbolsNode);
+        const json::Node* parallelObjCClosuresNode = json::getOptionalValue(diags, buildOptionsNode, "parallelObjCClosures");
+        if ( parallelObjCClosuresNode != nullptr )
+            buildOptions.parallelObjCClosures = json::parseRequiredBool(diags, *parallelObjCClosuresNode);
+    }
+
     if (diags.hasError())
         return;
 
@@ -37,10 +37,10 @@
 using mach_o::Platform;
 
 static const uint64_t kMinBuildVersion = 1; //The minimum version BuildOptions struct we can support
-static const uint64_t kMaxBuildVersion = 1; //The maximum version BuildOptions struct we can support
+static const uint64_t kMaxBuildVersion = 2; //The maximum version BuildOptions struct we can support
 
 static const uint32_t MajorVersion = 1;
-static const uint32_t MinorVersion = 0;
+static const uint32_t MinorVersion = 1;
 
 struct KernelCollectionBuilder {
 
@@ -59,6 +59,7 @@ struct KernelCollectionBuilder {
 
     const char*                                 arch = "";
     BuildOptions_v1                             options;
+    bool                                        serialPasses = false;   // From BuildOptions_v2
     std::list<Diagnostics>                      inputFileDiags;
     std::vector<AppCacheBuilder::InputDylib>    inputFiles;
     dyld3::closure::LoadedFileInfo              kernelCollectionFileInfo;
@@ -131,6 +132,8 @@ struct KernelCollectionBuilder* createKernelCollectionBuilder(const struct Build
         builder->error("Builder version %llu is greater than maximum supported version of %llu", options->version, kMaxBuildVersion);
         return builder;
     }
+    if ( options->version >= 2 )
+        builder->serialPasses = ((const BuildOptions_v2*)options)->serialPasses;
     if ( options->arch == nullptr ) {
         builder->error("arch must not be null");
         return builder;
@@ -588,6 +591,7 @@ bool runKernelCollectionBuilder(struct KernelCollectionBuilder* builder) {
     AppCacheBuilder::Options appCacheOptions;
     appCacheOptions.cacheKind = cacheKind(builder->options.collectionKind);
     appCacheOptions.stripMode = stripMode(builder->options.stripMode);
+    appCacheOptions.serialPasses = builder->serialPasses;
 
     const dyld3::closure::FileSystemNull builderFileSystem;
 
@@ -90,6 +90,17 @@ struct BuildOptions_v1
     bool                                        verboseDiagnostics;
 };
 
+struct BuildOptions_v2
+{
+    uint64_t                                    version;                        // Future proofing, set to 2
+    CollectionKind                              collectionKind;
+    StripMode                                   stripMode;
+// Valid archs are one of: "arm64", "arm64e", "x86_64", "x86_64h"
+    const CFStringRef                           arch;
+    bool                                        verboseDiagnostics;
+    bool                                        serialPasses;                   // Run the per-kext passes on one thread.  The output is the same as the default parallel passes
+};
+
 
 struct CollectionFileResult_v1
 {
@@ -130,6 +130,29 @@ struct BuildOptions_v3
     bool                                        printStats;
 };
 
+// This is available when getVersion() returns 1.8 or higher
+struct BuildOptions_v4
+{
+    uint64_t                                    version;                        // Future proofing, set to 4
+    const char *                                updateName;                     // BuildTrain+UpdateNumber
+    const char *                                deviceName;
+    enum Disposition                            disposition;                    // Internal, Customer, etc.
+    enum Platform                               platform;                       // Enum: unknown, macOS, iOS, ...
+    const char **                               archs;
+    uint64_t                                    numArchs;
+    bool                                        verboseDiagnostics;
+    bool                                        isLocallyBuiltCache;
+    // Added in v2
+    bool                                        optimizeForSize;
+    // Added in v3
+    bool                                        filesRemovedFromDisk;
+    bool                                        timePasses;
+    bool                                        printStats;
+    // Added in v4
+    bool                                        compactLocalSymbols;            // Use the compact format for the .symbols file
+    bool                                        parallelObjCClosures;           // Visit objc images on multiple threads when building executable closures
+};
+
 enum FileBehavior
 {
     AddFile                                     = 0,        // New file: uid, gid, mode, data, cdhash fields must be set
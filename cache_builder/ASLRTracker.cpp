@@ -54,6 +54,12 @@ void ASLR_Tracker::add(void* loc, uint8_t level)
 {
     if (!_enabled)
         return;
+#if BUILDING_APP_CACHE_UTIL
+    if ( _recording ) {
+        _recordedFixups.push_back({ loc, level });
+        return;
+    }
+#endif
     uint8_t* p = (uint8_t*)loc;
     assert(p >= _regionStart);
     assert(p < _regionEnd);
@@ -70,6 +76,9 @@ void ASLR_Tracker::remove(void* loc)
 {
     if (!_enabled)
         return;
+#if BUILDING_APP_CACHE_UTIL
+    assert(!_recording);
+#endif
     uint8_t* p = (uint8_t*)loc;
     assert(p >= _regionStart);
     assert(p < _regionEnd);
@@ -151,6 +160,22 @@ void ASLR_Tracker::setAuthData(void* p, uint16_t diversity, bool hasAddrDiv, uin
     _authDataMap[p] = {diversity, hasAddrDiv, key};
 }
 
+void ASLR_Tracker::addRecorded(const ASLR_Tracker& recorder)
+{
+    assert(recorder._recording);
+    assert(!_recording);
+    for ( const std::pair<void*, uint8_t>& locAndLevel : recorder._recordedFixups )
+        add(locAndLevel.first, locAndLevel.second);
+    for ( const auto& locAndTarget : recorder._rebaseTarget32 )
+        _rebaseTarget32[locAndTarget.first] = locAndTarget.second;
+    for ( const auto& locAndTarget : recorder._rebaseTarget64 )
+        _rebaseTarget64[locAndTarget.first] = locAndTarget.second;
+    for ( const auto& locAndHigh8 : recorder._high8Map )
+        _high8Map[locAndHigh8.first] = locAndHigh8.second;
+    for ( const auto& locAndAuth : recorder._authDataMap )
+        _authDataMap[locAndAuth.first] = locAndAuth.second;
+}
+
 bool ASLR_Tracker::hasHigh8(void* p, uint8_t* highByte) const
 {
     auto pos = _high8Map.find(p);
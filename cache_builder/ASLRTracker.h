@@ -66,6 +66,11 @@ public:
     bool                hasAuthData(void* p, uint16_t* diversity, bool* hasAddrDiv, uint8_t* key) const;
     void                setHigh8(void* p, uint8_t high8);
     void                setAuthData(void* p, uint16_t diversity, bool hasAddrDiv, uint8_t key);
+
+    // Kernel collections adjust kexts in parallel.  Each kext uses its own tracker which records
+    // its fixups, then those are added to the main tracker, in kext order, with addRecorded()
+    void                startRecording() { _recording = true; }
+    void                addRecorded(const ASLR_Tracker& recorder);
 #endif
 
 #if BUILDING_CACHE_BUILDER || BUILDING_CACHE_BUILDER_UNIT_TESTS
@@ -107,6 +112,10 @@ private:
     // For kernel collections to work out which other collection a given
     // fixup is relative to
     std::vector<uint8_t> _cacheLevels;
+
+    // Set on the per-kext trackers, which have no region and so can't use the bitmap
+    bool                                    _recording = false;
+    std::vector<std::pair<void*, uint8_t>>  _recordedFixups;
 #endif
 
     std::unordered_map<void*, uint32_t> _rebaseTarget32;
@@ -66,6 +66,8 @@ struct BuilderOptions
     bool                                        forceDevelopmentSubCacheSuffix;
     CacheKind                                   kind;
     LocalSymbolsMode                            localSymbolsMode;
+    bool                                        compactLocalSymbols = false;
+    bool                                        parallelObjCClosures = false;
 
     // Logging/printing
     std::string                                 logPrefix;
@@ -660,6 +660,30 @@ const char* FunctionVariantsPatchTableChunk::name() const
 }
 
 
+//
+// MARK: --- ExportFiltersChunk methods ---
+//
+
+ExportFiltersChunk::ExportFiltersChunk()
+: Chunk(Kind::cacheExportFilters, Alignment::struct64)
+{
+}
+
+ExportFiltersChunk::~ExportFiltersChunk()
+{
+}
+
+void ExportFiltersChunk::dump() const
+{
+    printf("ExportFiltersChunk\n");
+}
+
+const char* ExportFiltersChunk::name() const
+{
+    return "export filters";
+}
+
+
 //
 // MARK: --- PrebuiltLoaderChunk methods ---
 //
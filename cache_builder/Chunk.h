@@ -94,6 +94,9 @@ struct Chunk
         // A buffer to hold the list of function variants to patch at launch
         cacheFunctionVariantsPatchTable,
 
+        // A buffer to hold the bloom filters of each cache dylib's exports
+        cacheExportFilters,
+
          // A buffer to hold the PrebuiltLoaderSet for the cache dylibs
         dylibPrebuiltLoaders,
 
@@ -642,6 +645,25 @@ private:
 };
 
 
+struct ExportFiltersChunk : Chunk
+{
+public:
+    ExportFiltersChunk();
+    virtual ~ExportFiltersChunk();
+    ExportFiltersChunk(const ExportFiltersChunk&) = delete;
+    ExportFiltersChunk(ExportFiltersChunk&&) = delete;
+    ExportFiltersChunk& operator=(const ExportFiltersChunk&) = delete;
+    ExportFiltersChunk& operator=(ExportFiltersChunk&&) = delete;
+
+    // Virtual methods
+    const char* name() const override final;
+
+private:
+    __attribute__((used))
+    virtual void dump() const override final;
+};
+
+
 struct PrebuiltLoaderChunk : Chunk
 {
 public:
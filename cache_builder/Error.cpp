@@ -42,23 +42,9 @@
 namespace error {
 
 
-Error::Error(Error&& other)
+void Error::release()
 {
-    _buffer = other._buffer;
-    other._buffer = nullptr;
-}
-
-Error& Error::operator=(Error&& other)
-{
-    _buffer = other._buffer;
-    other._buffer = nullptr;
-    return *this;
-}
-
-Error::~Error()
-{
-   if ( _buffer )
-        _simple_sfree(_buffer);
+    _simple_sfree(_buffer);
     _buffer = nullptr;
 }
 
@@ -46,10 +46,10 @@ public:
                     Error() = default;
                     Error(const char* format, ...)  __attribute__((format(printf, 2, 3)));
                     Error(const Error&) = delete;  // can't copy
-                    Error(Error&&); // can move
+                    Error(Error&& other) : _buffer(other._buffer) { other._buffer = nullptr; } // can move
                     Error& operator=(const Error&) = delete; //  can't copy assign
                     Error& operator=(Error&&); // can move
-                    ~Error();
+                    ~Error() { if ( _buffer != nullptr ) release(); } // success path is inline and never allocates
 
 
     bool            hasError() const { return (_buffer != nullptr); }
@@ -61,10 +61,22 @@ public:
     static Error    none() { return Error(); }
 
 private:
+    void            release();
 
     void*           _buffer = nullptr;
 };
 
+inline Error& Error::operator=(Error&& other)
+{
+    if ( this != &other ) {
+        if ( _buffer != nullptr )
+            release();
+        _buffer       = other._buffer;
+        other._buffer = nullptr;
+    }
+    return *this;
+}
+
 } // namespace error
 
 #endif /* Error_hpp */
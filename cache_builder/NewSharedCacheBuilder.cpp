@@ -34,6 +34,9 @@
 #include "Array.h"
 #include "DyldSharedCache.h"
 #include "dyld_cache_format.h"
+#include "CompactLocalSymbols.h"
+#include "ExportBloomFilter.h"
+#include "LinkeditMerger.h"
 #include "OptimizerObjC.h"
 #include "ObjCVisitor.h"
 #include "Trie.hpp"
@@ -305,6 +308,7 @@ Error SharedCacheBuilder::estimateGlobalOptimizations()
     this->calculateCacheDylibsTrie();
     this->estimatePatchTableSize();
     this->estimateFunctionVariantsSize();
+    this->estimateExportFiltersSize();
     this->estimateCacheLoadersSize();
     this->estimatePrewarmingSize();
 
@@ -691,6 +695,7 @@ Error SharedCacheBuilder::postDylibEmitChunks()
         return error;
 
     this->emitFunctionVariants();
+    this->emitExportFilters();
 
     // Note, this must be after we emit the patch table
     if ( Error error = this->emitCacheDylibsPrebuiltLoaders(); error.hasError() )
@@ -728,7 +733,8 @@ Error SharedCacheBuilder::postDylibEmitChunks()
     this->computeSlideInfo();
 
     this->emitSymbolTable();
-    this->emitUnmappedLocalSymbols();
+    if ( Error error = this->emitUnmappedLocalSymbols(); error.hasError() )
+        return error;
 
     return Error();
 }
@@ -2288,21 +2294,32 @@ void SharedCacheBuilder::findObjCCategories()
     Stats        stats(this->config);
     Timer::Scope timedScope(this->config, "findObjCCategories time");
 
-    // Reserve space for 15k categories, as we have 10k as of writing
-    const uint32_t numCategoriesToReserve = 1 << 14;
-    this->objcCategoryOptimizer.categories.reserve(numCategoriesToReserve);
-    size_t objcIndex = 0;
-    for (size_t cacheIndex = 0; cacheIndex < this->cacheDylibs.size(); cacheIndex++) {
-        CacheDylib& cacheDylib = this->cacheDylibs[cacheIndex];
-        if ( !cacheDylib.inputHdr->hasObjC() )
-            continue;
+    struct MissingClass
+    {
+        std::string_view className;
+        std::string_view categoryName;
+    };
+
+    struct DylibCategories
+    {
+        bool                                            excluded = false;
+        std::vector<ObjCCategoryOptimizer::Category>    categories;
+        std::vector<MissingClass>                       missingClasses;
+    };
+
+    // Each dylib is visited in parallel, in to its own results.  The results are then merged in
+    // objc dylib order, so that the categories are in the same order as if we'd walked in serial
+    BLOCK_ACCCESSIBLE_ARRAY(DylibCategories, dylibCategories, this->objcOptimizer.objcDylibs.size());
+    Error err = parallel::forEach(this->objcOptimizer.objcDylibs, ^(size_t objcIndex, CacheDylib*& cacheDylibPtr) {
+        CacheDylib& cacheDylib = *cacheDylibPtr;
+        DylibCategories& results = dylibCategories[objcIndex];
 
         // Skip dylibs with opcode fixups, as the Category visitor operates on chained fixups to find classes
         if ( cacheDylib.inputMF->hasOpcodeFixups() ) {
-            this->objcCategoryOptimizer.excludedDylibs.insert(objcIndex);
-            objcIndex++;
-            continue;
+            results.excluded = true;
+            return Error();
         }
+
         struct BindTarget {
             std::string_view        symbolName;
             std::optional<uint32_t> targetDylibIndex;
@@ -2375,7 +2392,7 @@ void SharedCacheBuilder::findObjCCategories()
                         if ( foundSymbol.foundInDylib == nullptr ) {
                             // Ignore category if class is missing. Usually due to a weak-link
                             if ( !bindTarget.isWeakImport ) {
-                                this->warning("Class %s could not be found for category %s in %s.", bindTarget.symbolName.data(), objCCategoryInfo.name.data(), cacheDylib.installName.data());
+                                results.missingClasses.push_back({ bindTarget.symbolName, objCCategoryInfo.name });
                             }
                             return;
                         }
@@ -2429,9 +2446,35 @@ void SharedCacheBuilder::findObjCCategories()
                 if ( numProperties > 0 )
                     objCCategoryInfo.cPropertyListVMAddress = objcPropertyList.getVMAddress().value();
             }
-            this->objcCategoryOptimizer.categories.push_back(std::move(objCCategoryInfo));
+            results.categories.push_back(std::move(objCCategoryInfo));
         });
-        objcIndex++;
+
+        return Error();
+    });
+
+    assert(!err.hasError());
+
+    // Merge the results in serial
+
+    // Reserve space for 15k categories, as we have 10k as of writing
+    const uint32_t numCategoriesToReserve = 1 << 14;
+    this->objcCategoryOptimizer.categories.reserve(numCategoriesToReserve);
+
+    for ( uint32_t objcIndex = 0; objcIndex != this->objcOptimizer.objcDylibs.size(); ++objcIndex ) {
+        DylibCategories& results = dylibCategories[objcIndex];
+        if ( results.excluded ) {
+            this->objcCategoryOptimizer.excludedDylibs.insert(objcIndex);
+            continue;
+        }
+
+        const CacheDylib& cacheDylib = *this->objcOptimizer.objcDylibs[objcIndex];
+        for ( const MissingClass& missingClass : results.missingClasses ) {
+            this->warning("Class %s could not be found for category %s in %s.", missingClass.className.data(),
+                          missingClass.categoryName.data(), cacheDylib.installName.data());
+        }
+
+        for ( ObjCCategoryOptimizer::Category& category : results.categories )
+            this->objcCategoryOptimizer.categories.push_back(std::move(category));
     }
 
     if ( this->config.log.printStats ) {
@@ -2596,11 +2639,20 @@ void SharedCacheBuilder::estimateSwiftHashTableSizes()
 
     this->swiftOptimizer.optsHeaderByteSize = sizeof(SwiftOptimizationHeader);
 
-    __block uint32_t numTypeConformances = 0;
-    __block uint32_t numMetadataConformances = 0;
-    __block uint32_t numForeignConformances = 0;
+    struct ConformanceCounts
+    {
+        uint32_t numTypeConformances     = 0;
+        uint32_t numMetadataConformances = 0;
+        uint32_t numForeignConformances  = 0;
+    };
+
+    // Count the conformances in each dylib in parallel, then sum them up afterwards
+    BLOCK_ACCCESSIBLE_ARRAY(ConformanceCounts, dylibCounts, this->cacheDylibs.size());
+    Error err = parallel::forEach(this->cacheDylibs, ^(size_t index, CacheDylib& cacheDylib) {
+        __block uint32_t numTypeConformances = 0;
+        __block uint32_t numMetadataConformances = 0;
+        __block uint32_t numForeignConformances = 0;
 
-    for ( const CacheDylib& cacheDylib : this->cacheDylibs ) {
         __block SwiftVisitor swiftVisitor = makeInputDylibSwiftVisitor(cacheDylib);
 
         swiftVisitor.forEachProtocolConformance(^(const SwiftConformance &swiftConformance,
@@ -2638,6 +2690,20 @@ void SharedCacheBuilder::estimateSwiftHashTableSizes()
                     break;
             }
         });
+
+        dylibCounts[index] = { numTypeConformances, numMetadataConformances, numForeignConformances };
+        return Error();
+    });
+
+    assert(!err.hasError());
+
+    uint32_t numTypeConformances = 0;
+    uint32_t numMetadataConformances = 0;
+    uint32_t numForeignConformances = 0;
+    for ( uint32_t i = 0; i != this->cacheDylibs.size(); ++i ) {
+        numTypeConformances     += dylibCounts[i].numTypeConformances;
+        numMetadataConformances += dylibCounts[i].numMetadataConformances;
+        numForeignConformances  += dylibCounts[i].numForeignConformances;
     }
 
     auto& optimizer = this->swiftOptimizer;
@@ -2832,6 +2898,54 @@ void SharedCacheBuilder::estimateFunctionVariantsSize()
 
 }
 
+void SharedCacheBuilder::estimateExportFiltersSize()
+{
+    Stats        stats(this->config);
+    Timer::Scope timedScope(this->config, "estimateExportFiltersSize time");
+
+    // The filters only depend on the names in each exports trie.  The cache builder only ever removes names
+    // from a trie (see adjustExportsTrie()), so a filter built from the input dylib is valid for the cache dylib too.
+    // Build them all now, so that the size is exact, and copy them in to the cache later
+    this->exportFiltersOptimizer.filters.resize(this->cacheDylibs.size());
+    Error err = parallel::forEach(this->cacheDylibs, ^(size_t index, CacheDylib& cacheDylib) {
+        __block const uint8_t* trieStart = nullptr;
+        __block const uint8_t* trieEnd   = nullptr;
+        Diagnostics diag;
+        cacheDylib.inputMF->withFileLayout(diag, ^(const mach_o::Layout& layout) {
+            if ( layout.linkedit.exportsTrie.hasValue() ) {
+                trieStart = layout.linkedit.exportsTrie.buffer;
+                trieEnd   = trieStart + layout.linkedit.exportsTrie.bufferSize;
+            }
+        });
+        if ( trieStart == nullptr )
+            return Error();
+
+        // dylibs with no filter are always searched, so just skip any trie we can't walk
+        __block uint64_t nameCount = 0;
+        if ( !ExportBloomFilter::forEachTrieName(trieStart, trieEnd, ^(const char* name) { ++nameCount; }) || (nameCount == 0) )
+            return Error();
+
+        std::vector<uint64_t>& filter = this->exportFiltersOptimizer.filters[index];
+        filter.resize(ExportBloomFilter::wordCountFor(nameCount));
+        uint64_t* words     = filter.data();
+        uint32_t  wordCount = (uint32_t)filter.size();
+        ExportBloomFilter::forEachTrieName(trieStart, trieEnd, ^(const char* name) {
+            ExportBloomFilter::add(words, wordCount, name);
+        });
+        return Error();
+    });
+    assert(!err.hasError());
+
+    uint64_t size = alignTo((uint64_t)offsetof(dyld_cache_export_filters, entries[this->cacheDylibs.size()]), 8);
+    for ( const std::vector<uint64_t>& filter : this->exportFiltersOptimizer.filters )
+        size += filter.size() * sizeof(uint64_t);
+    this->exportFiltersOptimizer.exportFiltersByteSize = size;
+
+    if ( this->config.log.printStats ) {
+        stats.add("  export filters size: %lld\n", this->exportFiltersOptimizer.exportFiltersByteSize);
+    }
+}
+
 void SharedCacheBuilder::estimatePrewarmingSize()
 {
     // Skip everything if the JSON file is empty
@@ -3097,6 +3211,9 @@ void SharedCacheBuilder::addGlobalOptimizationsToSubCache(SubCache& subCache)
     // Add function-variants table
     subCache.addFunctionVariantsChunk(this->functionVariantsOptimizer);
 
+    // Add export bloom filters
+    subCache.addExportFiltersChunk(this->exportFiltersOptimizer);
+
     // Add cache dylib Loader's
     subCache.addCacheDylibsLoaderChunk(this->prebuiltLoaderBuilder);
 
@@ -3611,287 +3728,317 @@ void SharedCacheBuilder::computeLargeSubCache()
         this->addFinalChunksToSubCache(subCache);
 }
 
-Error SharedCacheBuilder::copyLocalSymbols(SubCache& subCache,
-                                           const std::span<LinkeditDataChunk*> symbolStringChunks,
-                                           const FileToDylibMap& fileToDylibMap,
-                                           const FileToSymbolInfoMap& fileToSymbolInfoMap,
-                                           const uint32_t redactedStringOffset,
-                                           uint32_t& stringBufferSize,
-                                           uint32_t& sourceStringSize,
-                                           uint32_t& sourceStringCount)
+Error SharedCacheBuilder::copyLocalSymbols(DylibSymbolStrings& symbols)
 {
     // Locals last, as they are special and possibly stripped/unmapped
     if ( options.localSymbolsMode == cache_builder::LocalSymbolsMode::strip )
         return Error();
 
-    // Map from strings to their offsets in to the new string buffer
-    auto& stringMap = subCache.symbolStringsOptimizer.stringMap;
-
-    for ( LinkeditDataChunk* chunk : symbolStringChunks ) {
-        const MachOFile* mf = chunk->inputFile->mf;
-        CacheDylib* dylib = fileToDylibMap.at(chunk->inputFile);
-
-        UnmappedSymbolsOptimizer::LocalSymbolInfo* symbolInfo = nullptr;
-        if ( options.localSymbolsMode == cache_builder::LocalSymbolsMode::unmap ) {
-            symbolInfo = fileToSymbolInfoMap.at(chunk->inputFile);
-
-            if ( config.layout.is64 )
-                symbolInfo->nlistStartIndex = (uint32_t)this->unmappedSymbolsOptimizer.symbolNlistChunk.nlist64.size();
-            else
-                symbolInfo->nlistStartIndex = (uint32_t)this->unmappedSymbolsOptimizer.symbolNlistChunk.nlist32.size();
-        }
-
-        __block Diagnostics diag;
-        mf->withFileLayout(diag, ^(const mach_o::Layout &layout) {
-            mach_o::SymbolTable symbolTable(layout);
-
-            dylib->optimizedSymbols.localsStartIndex = 0;
-            symbolTable.forEachLocalSymbol(diag, ^(const char *symbolName, uint64_t n_value, uint8_t n_type, uint8_t n_sect, uint16_t n_desc, bool& stop) {
-                // Note we don't need to check for stabs, exports, etc.  forEachLocalSymbol() did that for us
-                std::string_view symbolString(symbolName);
-                sourceStringSize += symbolString.size() + 1;
-                ++sourceStringCount;
-
-                uint32_t symbolStringOffset = ~0U;
-                if ( options.localSymbolsMode == cache_builder::LocalSymbolsMode::unmap ) {
-                    // copy all local symbol to unmmapped locals area
-                    auto itAndInserted = this->unmappedSymbolsOptimizer.stringMap.insert({ symbolString, this->unmappedSymbolsOptimizer.stringBufferSize });
-                    // If we inserted the string, then account for the space
-                    if ( itAndInserted.second )
-                        this->unmappedSymbolsOptimizer.stringBufferSize += symbolString.size() + 1;
-
-                    // Add this to the list for the unmapped locals nlist
-                    if ( config.layout.is64 ) {
-                        struct nlist_64 newSymbol;
-                        newSymbol.n_un.n_strx   = itAndInserted.first->second;
-                        newSymbol.n_type        = n_type;
-                        newSymbol.n_sect        = n_sect;
-                        newSymbol.n_desc        = n_desc;
-                        newSymbol.n_value       = n_value;
-                        this->unmappedSymbolsOptimizer.symbolNlistChunk.nlist64.push_back(newSymbol);
-                    } else {
-                        struct nlist newSymbol;
-                        newSymbol.n_un.n_strx   = itAndInserted.first->second;
-                        newSymbol.n_type        = n_type;
-                        newSymbol.n_sect        = n_sect;
-                        newSymbol.n_desc        = n_desc;
-                        newSymbol.n_value       = (uint32_t)n_value;
-                        this->unmappedSymbolsOptimizer.symbolNlistChunk.nlist32.push_back(newSymbol);
-                    }
-                    ++symbolInfo->nlistCount;
-
-                    // if removing local symbols, change __text symbols to "<redacted>" so backtraces don't have bogus names
-                    if ( n_sect == 1 ) {
-                        symbolStringOffset = redactedStringOffset;
-                    } else {
-                        // Symbols other than __text are dropped
-                        return;
-                    }
-                } else {
-                    // Keep this string so make space for it.
-                    auto itAndInserted = stringMap.insert({ symbolString, stringBufferSize });
-                    // If we inserted the string, then account for the space
-                    if ( itAndInserted.second )
-                        stringBufferSize += symbolString.size() + 1;
+    const MachOFile* mf = symbols.dylib->inputFile->mf;
+    CacheDylib* dylib = symbols.dylib;
 
-                    symbolStringOffset = itAndInserted.first->second;
-                }
+    // Note the nlists here take string IDs from the pools.  They are replaced with offsets once the pools are finalized
+    uint32_t redactedStringID = ~0U;
+    if ( options.localSymbolsMode == cache_builder::LocalSymbolsMode::unmap )
+        redactedStringID = symbols.stringPoolClient->add("<redacted>");
 
-                // Add this to the list for the new nlist
+    __block Diagnostics diag;
+    mf->withFileLayout(diag, ^(const mach_o::Layout &layout) {
+        mach_o::SymbolTable symbolTable(layout);
+
+        dylib->optimizedSymbols.localsStartIndex = 0;
+        symbolTable.forEachLocalSymbol(diag, ^(const char *symbolName, uint64_t n_value, uint8_t n_type, uint8_t n_sect, uint16_t n_desc, bool& stop) {
+            // Note we don't need to check for stabs, exports, etc.  forEachLocalSymbol() did that for us
+            std::string_view symbolString(symbolName);
+            symbols.sourceStringSize += symbolString.size() + 1;
+            ++symbols.sourceStringCount;
+
+            uint32_t symbolStringID = ~0U;
+            if ( options.localSymbolsMode == cache_builder::LocalSymbolsMode::unmap ) {
+                // copy all local symbol to unmmapped locals area
+                uint32_t unmappedStringID = symbols.unmappedStringPoolClient->add(symbolString);
+
+                // Add this to the list for the unmapped locals nlist
                 if ( config.layout.is64 ) {
                     struct nlist_64 newSymbol;
-                    newSymbol.n_un.n_strx   = symbolStringOffset;
+                    newSymbol.n_un.n_strx   = unmappedStringID;
                     newSymbol.n_type        = n_type;
                     newSymbol.n_sect        = n_sect;
                     newSymbol.n_desc        = n_desc;
                     newSymbol.n_value       = n_value;
-                    dylib->optimizedSymbols.nlist64.push_back(newSymbol);
+                    symbols.unmappedNList64.push_back(newSymbol);
                 } else {
                     struct nlist newSymbol;
-                    newSymbol.n_un.n_strx   = symbolStringOffset;
+                    newSymbol.n_un.n_strx   = unmappedStringID;
                     newSymbol.n_type        = n_type;
                     newSymbol.n_sect        = n_sect;
                     newSymbol.n_desc        = n_desc;
                     newSymbol.n_value       = (uint32_t)n_value;
-                    dylib->optimizedSymbols.nlist32.push_back(newSymbol);
+                    symbols.unmappedNList32.push_back(newSymbol);
                 }
-                dylib->optimizedSymbols.localsCount++;
-            });
+
+                // if removing local symbols, change __text symbols to "<redacted>" so backtraces don't have bogus names
+                if ( n_sect == 1 ) {
+                    symbolStringID = redactedStringID;
+                } else {
+                    // Symbols other than __text are dropped
+                    return;
+                }
+            } else {
+                // Keep this string
+                symbolStringID = symbols.stringPoolClient->add(symbolString);
+            }
+
+            // Add this to the list for the new nlist
+            if ( config.layout.is64 ) {
+                struct nlist_64 newSymbol;
+                newSymbol.n_un.n_strx   = symbolStringID;
+                newSymbol.n_type        = n_type;
+                newSymbol.n_sect        = n_sect;
+                newSymbol.n_desc        = n_desc;
+                newSymbol.n_value       = n_value;
+                dylib->optimizedSymbols.nlist64.push_back(newSymbol);
+            } else {
+                struct nlist newSymbol;
+                newSymbol.n_un.n_strx   = symbolStringID;
+                newSymbol.n_type        = n_type;
+                newSymbol.n_sect        = n_sect;
+                newSymbol.n_desc        = n_desc;
+                newSymbol.n_value       = (uint32_t)n_value;
+                dylib->optimizedSymbols.nlist32.push_back(newSymbol);
+            }
+            dylib->optimizedSymbols.localsCount++;
         });
+    });
 
-        if ( diag.hasError() )
-            return Error("Couldn't get dylib layout because: %s", diag.errorMessageCStr());
-    }
+    if ( diag.hasError() )
+        return Error("Couldn't get dylib layout because: %s", diag.errorMessageCStr());
 
     return Error();
 }
 
-Error SharedCacheBuilder::copyExportedSymbols(SubCache& subCache,
-                                              const std::span<LinkeditDataChunk*> symbolStringChunks,
-                                              const FileToDylibMap& fileToDylibMap,
-                                              const FileToSymbolInfoMap& fileToSymbolInfoMap,
-                                              std::vector<OldToNewIndicesMap>& oldToNewIndicesMaps,
-                                              const uint32_t redactedStringOffset,
-                                              uint32_t& stringBufferSize,
-                                              uint32_t& sourceStringSize,
-                                              uint32_t& sourceStringCount)
+Error SharedCacheBuilder::copyExportedSymbols(DylibSymbolStrings& symbols)
 {
-    // Map from strings to their offsets in to the new string buffer
-    auto& stringMap = subCache.symbolStringsOptimizer.stringMap;
-
-    for ( LinkeditDataChunk* chunk : symbolStringChunks ) {
-        const MachOFile* mf = chunk->inputFile->mf;
-        CacheDylib* dylib = fileToDylibMap.at(chunk->inputFile);
+    const MachOFile* mf = symbols.dylib->inputFile->mf;
+    CacheDylib* dylib = symbols.dylib;
 
-        OldToNewIndicesMap& oldToNewIndices = oldToNewIndicesMaps[dylib->cacheIndex];
+    OldToNewIndicesMap& oldToNewIndices = *symbols.oldToNewIndices;
 
-        __block Diagnostics diag;
-        mf->withFileLayout(diag, ^(const mach_o::Layout &layout) {
-            mach_o::SymbolTable symbolTable(layout);
+    __block Diagnostics diag;
+    mf->withFileLayout(diag, ^(const mach_o::Layout &layout) {
+        mach_o::SymbolTable symbolTable(layout);
 
-            __block uint32_t oldSymbolIndex = layout.linkedit.globalSymbolTable.entryIndex;
+        __block uint32_t oldSymbolIndex = layout.linkedit.globalSymbolTable.entryIndex;
 
-            dylib->optimizedSymbols.globalsStartIndex = dylib->optimizedSymbols.localsCount;
-            symbolTable.forEachGlobalSymbol(diag, ^(const char *symbolName, uint64_t n_value, uint8_t n_type, uint8_t n_sect, uint16_t n_desc, bool &stop) {
-                // Note we don't need to check for stabs, exports, etc.  forEachGlobalSymbol() did that for us
-                std::string_view symbolString(symbolName);
-                sourceStringSize += symbolString.size() + 1;
-                ++sourceStringCount;
+        dylib->optimizedSymbols.globalsStartIndex = dylib->optimizedSymbols.localsCount;
+        symbolTable.forEachGlobalSymbol(diag, ^(const char *symbolName, uint64_t n_value, uint8_t n_type, uint8_t n_sect, uint16_t n_desc, bool &stop) {
+            // Note we don't need to check for stabs, exports, etc.  forEachGlobalSymbol() did that for us
+            std::string_view symbolString(symbolName);
+            symbols.sourceStringSize += symbolString.size() + 1;
+            ++symbols.sourceStringCount;
 
-                // Skip symbols we don't need at runtime
-                if ( strncmp(symbolName, ".objc_", 6) == 0 ) {
-                    ++oldSymbolIndex;
-                    return;
-                }
-                if ( strncmp(symbolName, "$ld$", 4) == 0 ) {
-                    ++oldSymbolIndex;
-                    return;
-                }
+            // Skip symbols we don't need at runtime
+            if ( strncmp(symbolName, ".objc_", 6) == 0 ) {
+                ++oldSymbolIndex;
+                return;
+            }
+            if ( strncmp(symbolName, "$ld$", 4) == 0 ) {
+                ++oldSymbolIndex;
+                return;
+            }
 
-                auto itAndInserted = stringMap.insert({ symbolString, stringBufferSize });
-                // If we inserted the string, then account for the space
-                if ( itAndInserted.second )
-                    stringBufferSize += symbolString.size() + 1;
+            uint32_t symbolStringID = symbols.stringPoolClient->add(symbolString);
 
-                // Add this to the list for the new nlist
-                if ( config.layout.is64 ) {
-                    struct nlist_64 newSymbol;
-                    newSymbol.n_un.n_strx   = itAndInserted.first->second;
-                    newSymbol.n_type        = n_type;
-                    newSymbol.n_sect        = n_sect;
-                    newSymbol.n_desc        = n_desc;
-                    newSymbol.n_value       = n_value;
-                    dylib->optimizedSymbols.nlist64.push_back(newSymbol);
-                } else {
-                    struct nlist newSymbol;
-                    newSymbol.n_un.n_strx   = itAndInserted.first->second;
-                    newSymbol.n_type        = n_type;
-                    newSymbol.n_sect        = n_sect;
-                    newSymbol.n_desc        = n_desc;
-                    newSymbol.n_value       = (uint32_t)n_value;
-                    dylib->optimizedSymbols.nlist32.push_back(newSymbol);
-                }
+            // Add this to the list for the new nlist
+            if ( config.layout.is64 ) {
+                struct nlist_64 newSymbol;
+                newSymbol.n_un.n_strx   = symbolStringID;
+                newSymbol.n_type        = n_type;
+                newSymbol.n_sect        = n_sect;
+                newSymbol.n_desc        = n_desc;
+                newSymbol.n_value       = n_value;
+                dylib->optimizedSymbols.nlist64.push_back(newSymbol);
+            } else {
+                struct nlist newSymbol;
+                newSymbol.n_un.n_strx   = symbolStringID;
+                newSymbol.n_type        = n_type;
+                newSymbol.n_sect        = n_sect;
+                newSymbol.n_desc        = n_desc;
+                newSymbol.n_value       = (uint32_t)n_value;
+                dylib->optimizedSymbols.nlist32.push_back(newSymbol);
+            }
 
-                uint32_t newSymbolIndex = dylib->optimizedSymbols.globalsStartIndex + dylib->optimizedSymbols.globalsCount;
-                oldToNewIndices[oldSymbolIndex] = newSymbolIndex;
-                ++oldSymbolIndex;
+            uint32_t newSymbolIndex = dylib->optimizedSymbols.globalsStartIndex + dylib->optimizedSymbols.globalsCount;
+            oldToNewIndices[oldSymbolIndex] = newSymbolIndex;
+            ++oldSymbolIndex;
 
-                dylib->optimizedSymbols.globalsCount++;
-            });
+            dylib->optimizedSymbols.globalsCount++;
         });
+    });
 
-        if ( diag.hasError() )
-            return Error("Couldn't get dylib layout because: %s", diag.errorMessageCStr());
-    }
+    if ( diag.hasError() )
+        return Error("Couldn't get dylib layout because: %s", diag.errorMessageCStr());
 
     return Error();
 }
 
-Error SharedCacheBuilder::copyImportedSymbols(SubCache& subCache,
-                                              const std::span<LinkeditDataChunk*> symbolStringChunks,
-                                              const FileToDylibMap& fileToDylibMap,
-                                              const FileToSymbolInfoMap& fileToSymbolInfoMap,
-                                              std::vector<OldToNewIndicesMap>& oldToNewIndicesMaps,
-                                              const uint32_t redactedStringOffset,
-                                              uint32_t& stringBufferSize,
-                                              uint32_t& sourceStringSize,
-                                              uint32_t& sourceStringCount)
+Error SharedCacheBuilder::copyImportedSymbols(DylibSymbolStrings& symbols)
 {
-    // Map from strings to their offsets in to the new string buffer
-    auto& stringMap = subCache.symbolStringsOptimizer.stringMap;
-
-    for ( LinkeditDataChunk* chunk : symbolStringChunks ) {
-        const MachOFile* mf = chunk->inputFile->mf;
-        CacheDylib* dylib = fileToDylibMap.at(chunk->inputFile);
+    const MachOFile* mf = symbols.dylib->inputFile->mf;
+    CacheDylib* dylib = symbols.dylib;
 
-        OldToNewIndicesMap& oldToNewIndices = oldToNewIndicesMaps[dylib->cacheIndex];
+    OldToNewIndicesMap& oldToNewIndices = *symbols.oldToNewIndices;
 
-        __block Diagnostics diag;
-        mf->withFileLayout(diag, ^(const mach_o::Layout &layout) {
-            mach_o::SymbolTable symbolTable(layout);
+    __block Diagnostics diag;
+    mf->withFileLayout(diag, ^(const mach_o::Layout &layout) {
+        mach_o::SymbolTable symbolTable(layout);
 
-            __block uint32_t oldSymbolIndex = layout.linkedit.undefSymbolTable.entryIndex;
+        __block uint32_t oldSymbolIndex = layout.linkedit.undefSymbolTable.entryIndex;
 
-            dylib->optimizedSymbols.undefsStartIndex = dylib->optimizedSymbols.localsCount + dylib->optimizedSymbols.globalsCount;
-            symbolTable.forEachImportedSymbol(diag, ^(const char* symbolName, uint64_t n_value, uint8_t n_type, uint8_t n_sect, uint16_t n_desc, bool& stop) {
-                std::string_view symbolString(symbolName);
-                sourceStringSize += symbolString.size() + 1;
-                ++sourceStringCount;
+        dylib->optimizedSymbols.undefsStartIndex = dylib->optimizedSymbols.localsCount + dylib->optimizedSymbols.globalsCount;
+        symbolTable.forEachImportedSymbol(diag, ^(const char* symbolName, uint64_t n_value, uint8_t n_type, uint8_t n_sect, uint16_t n_desc, bool& stop) {
+            std::string_view symbolString(symbolName);
+            symbols.sourceStringSize += symbolString.size() + 1;
+            ++symbols.sourceStringCount;
 
-                // rdar://129398821 (dyld cache builder add support for binds relative to dylib segments)
-                // skip synthetic dyld symbols
-                if ( symbolString.find("$dyld$") != std::string_view::npos ) {
-                    ++oldSymbolIndex;
-                    return;
-                }
+            // rdar://129398821 (dyld cache builder add support for binds relative to dylib segments)
+            // skip synthetic dyld symbols
+            if ( symbolString.find("$dyld$") != std::string_view::npos ) {
+                ++oldSymbolIndex;
+                return;
+            }
 
-                auto itAndInserted = stringMap.insert({ symbolString, stringBufferSize });
-                // If we inserted the string, then account for the space
-                if ( itAndInserted.second )
-                    stringBufferSize += symbolString.size() + 1;
+            uint32_t symbolStringID = symbols.stringPoolClient->add(symbolString);
 
-                // Add this to the list for the new nlist
-                if ( config.layout.is64 ) {
-                    struct nlist_64 newSymbol;
-                    newSymbol.n_un.n_strx   = itAndInserted.first->second;
-                    newSymbol.n_type        = n_type;
-                    newSymbol.n_sect        = n_sect;
-                    newSymbol.n_desc        = n_desc;
-                    newSymbol.n_value       = n_value;
-                    dylib->optimizedSymbols.nlist64.push_back(newSymbol);
-                } else {
-                    struct nlist newSymbol;
-                    newSymbol.n_un.n_strx   = itAndInserted.first->second;
-                    newSymbol.n_type        = n_type;
-                    newSymbol.n_sect        = n_sect;
-                    newSymbol.n_desc        = n_desc;
-                    newSymbol.n_value       = (uint32_t)n_value;
-                    dylib->optimizedSymbols.nlist32.push_back(newSymbol);
-                }
+            // Add this to the list for the new nlist
+            if ( config.layout.is64 ) {
+                struct nlist_64 newSymbol;
+                newSymbol.n_un.n_strx   = symbolStringID;
+                newSymbol.n_type        = n_type;
+                newSymbol.n_sect        = n_sect;
+                newSymbol.n_desc        = n_desc;
+                newSymbol.n_value       = n_value;
+                dylib->optimizedSymbols.nlist64.push_back(newSymbol);
+            } else {
+                struct nlist newSymbol;
+                newSymbol.n_un.n_strx   = symbolStringID;
+                newSymbol.n_type        = n_type;
+                newSymbol.n_sect        = n_sect;
+                newSymbol.n_desc        = n_desc;
+                newSymbol.n_value       = (uint32_t)n_value;
+                dylib->optimizedSymbols.nlist32.push_back(newSymbol);
+            }
 
-                uint32_t newSymbolIndex = dylib->optimizedSymbols.undefsStartIndex + dylib->optimizedSymbols.undefsCount;
-                oldToNewIndices[oldSymbolIndex] = newSymbolIndex;
-                ++oldSymbolIndex;
+            uint32_t newSymbolIndex = dylib->optimizedSymbols.undefsStartIndex + dylib->optimizedSymbols.undefsCount;
+            oldToNewIndices[oldSymbolIndex] = newSymbolIndex;
+            ++oldSymbolIndex;
 
-                dylib->optimizedSymbols.undefsCount++;
-            });
+            dylib->optimizedSymbols.undefsCount++;
         });
+    });
 
-        if ( diag.hasError() )
-            return Error("Couldn't get dylib layout because: %s", diag.errorMessageCStr());
-    }
+    if ( diag.hasError() )
+        return Error("Couldn't get dylib layout because: %s", diag.errorMessageCStr());
 
     return Error();
 }
 
+// Gets an unmapped local symbol from the .symbols nlist.  The n_strx must already be an offset in to the final string pool
+static compact_local_symbols::Symbol unmappedLocalSymbol(const UnmappedSymbolsOptimizer& optimizer, bool is64, uint32_t nlistIndex)
+{
+    compact_local_symbols::Symbol sym;
+    uint32_t stringOffset = 0;
+    if ( is64 ) {
+        const struct nlist_64& nlist = optimizer.symbolNlistChunk.nlist64[nlistIndex];
+        stringOffset = nlist.n_un.n_strx;
+        sym.value    = nlist.n_value;
+        sym.type     = nlist.n_type;
+        sym.sect     = nlist.n_sect;
+        sym.desc     = (uint16_t)nlist.n_desc;
+    } else {
+        const struct nlist& nlist = optimizer.symbolNlistChunk.nlist32[nlistIndex];
+        stringOffset = nlist.n_un.n_strx;
+        sym.value    = nlist.n_value;
+        sym.type     = nlist.n_type;
+        sym.sect     = nlist.n_sect;
+        sym.desc     = (uint16_t)nlist.n_desc;
+    }
+    sym.name = &optimizer.compactStrings[stringOffset];
+    return sym;
+}
+
+// The compact .symbols format encodes each dylib's locals in address order, with the addresses as deltas.
+// The final addresses aren't known until the dylibs are adjusted, after layout, so reserve space using the input
+// addresses.  Adjusting slides whole segments, so deltas between symbols in the same section don't change.  Every
+// other delta gets the largest size a delta can encode to.
+static void sizeCompactLocalSymbols(UnmappedSymbolsOptimizer& optimizer, bool is64)
+{
+    optimizer.compact = true;
+
+    // The encoder needs names, not string pool offsets
+    optimizer.compactStrings.resize(optimizer.stringPool.size());
+    char* strings = optimizer.compactStrings.data();
+    optimizer.stringPool.forEachString(^(std::string_view str, uint32_t bufferOffset) {
+        memcpy(strings + bufferOffset, str.data(), str.size());
+    });
+
+    const auto& constOptimizer = optimizer;
+    Error sizeError = parallel::forEach(optimizer.symbolInfos, ^(size_t index, UnmappedSymbolsOptimizer::LocalSymbolInfo& symbolInfo) {
+        std::vector<compact_local_symbols::Symbol> symbols;
+        symbols.reserve(symbolInfo.nlistCount);
+        symbolInfo.compactOrder.reserve(symbolInfo.nlistCount);
+        for ( uint32_t i = 0; i != symbolInfo.nlistCount; ++i ) {
+            symbols.push_back(unmappedLocalSymbol(constOptimizer, is64, symbolInfo.nlistStartIndex + i));
+            symbolInfo.compactOrder.push_back(symbolInfo.nlistStartIndex + i);
+        }
+
+        // Address order, falling back to nlist order so that the output is deterministic
+        std::sort(symbolInfo.compactOrder.begin(), symbolInfo.compactOrder.end(), [&](uint32_t a, uint32_t b) {
+            uint64_t aValue = symbols[a - symbolInfo.nlistStartIndex].value;
+            uint64_t bValue = symbols[b - symbolInfo.nlistStartIndex].value;
+            if ( aValue != bValue )
+                return aValue < bValue;
+            return a < b;
+        });
+
+        uint64_t dataSize = 0;
+        bool     first    = true;
+        compact_local_symbols::Symbol prev;
+        for ( uint32_t nlistIndex : symbolInfo.compactOrder ) {
+            const compact_local_symbols::Symbol& sym = symbols[nlistIndex - symbolInfo.nlistStartIndex];
+            dataSize += compact_local_symbols::encodedSize(prev, sym);
+            bool sameSection = !first && (sym.sect != NO_SECT) && (sym.sect == prev.sect);
+            if ( !sameSection )
+                dataSize += compact_local_symbols::maxValueDeltaSize - compact_local_symbols::slebSize((int64_t)(sym.value - prev.value));
+            symbolInfo.maxNameLength = std::max(symbolInfo.maxNameLength, (uint32_t)sym.name.size());
+            prev  = sym;
+            first = false;
+        }
+        symbolInfo.compactDataSize = (uint32_t)dataSize;
+        return Error();
+    });
+    assert(!sizeError.hasError());
+
+    // Lay out the header, then the block entries, then each block in dylib order
+    uint64_t offset = sizeof(dyld_cache_local_symbols_compact_info);
+    offset += sizeof(dyld_cache_local_symbols_compact_entry) * optimizer.symbolInfos.size();
+    for ( UnmappedSymbolsOptimizer::LocalSymbolInfo& symbolInfo : optimizer.symbolInfos ) {
+        symbolInfo.compactDataOffset = (uint32_t)offset;
+        offset += symbolInfo.compactDataSize;
+        optimizer.compactMaxNameLength = std::max(optimizer.compactMaxNameLength, symbolInfo.maxNameLength);
+    }
+    optimizer.compactDataSize = offset;
+}
+
 // This runs after we've assigned Chunk's to SubCache's, but before we've actually
 // allocated the space for the SubCache's.
 // This pass takes all the LINKEDIT symbol strings and deduplicates them for the given
 // SubCache LINKEDIT region
 Error SharedCacheBuilder::calculateSubCacheSymbolStrings()
 {
-    Stats        stats(this->config);
-    Timer::Scope timedScope(this->config, "calculateSubCacheSymbolStrings time");
+    Stats                 stats(this->config);
+    Timer::Scope          timedScope(this->config, "calculateSubCacheSymbolStrings time");
+    Timer::AggregateTimer aggregateTimer(this->config);
 
     // LinkeditChunk's don't have a pointer to their cache dylib.  Make a map for them
     std::unordered_map<const InputFile*, CacheDylib*> fileToDylibMap;
@@ -3899,18 +4046,18 @@ Error SharedCacheBuilder::calculateSubCacheSymbolStrings()
     for ( CacheDylib& dylib : this->cacheDylibs )
         fileToDylibMap[dylib.inputFile] = &dylib;
 
-    // Create an optimizer for the .symbols file, if we need it
-    std::unordered_map<const InputFile*, UnmappedSymbolsOptimizer::LocalSymbolInfo*> fileToSymbolInfoMap;
-    if ( this->options.localSymbolsMode == cache_builder::LocalSymbolsMode::unmap ) {
+    // Create an optimizer for the .symbols file, if we need it.  Each cache dylib gets its own client of the string pool
+    const bool unmapLocals = (this->options.localSymbolsMode == cache_builder::LocalSymbolsMode::unmap);
+    std::vector<SymbolStringPool::Client*> unmappedStringPoolClients;
+    if ( unmapLocals ) {
         this->unmappedSymbolsOptimizer.symbolInfos.resize(this->cacheDylibs.size());
 
-        fileToSymbolInfoMap.reserve(this->cacheDylibs.size());
-        for ( uint32_t i = 0; i != this->cacheDylibs.size(); ++i )
-            fileToSymbolInfoMap[this->cacheDylibs[i].inputFile] = &this->unmappedSymbolsOptimizer.symbolInfos[i];
-
         // tradition for start of pool to be empty string
-        this->unmappedSymbolsOptimizer.stringMap["\0"] = 0;
-        ++this->unmappedSymbolsOptimizer.stringBufferSize;
+        this->unmappedSymbolsOptimizer.stringPool.addFixedString("");
+
+        unmappedStringPoolClients.reserve(this->cacheDylibs.size());
+        for ( uint32_t i = 0; i != this->cacheDylibs.size(); ++i )
+            unmappedStringPoolClients.push_back(&this->unmappedSymbolsOptimizer.stringPool.addClient());
     }
 
     for ( SubCache& subCache : this->subCaches ) {
@@ -3942,12 +4089,7 @@ Error SharedCacheBuilder::calculateSubCacheSymbolStrings()
 
         // Got some symbol strings to deduplicate.  Walk the nlist for this dylib to work
         // out which symbols we have
-        uint32_t stringBufferSize = 0;
-        uint32_t sourceStringSize = 0;
-        uint32_t sourceStringCount = 0;
-
-        // Map from strings to their offsets in to the new string buffer
-        auto& stringMap = subCache.symbolStringsOptimizer.stringMap;
+        SymbolStringPool& stringPool = subCache.symbolStringsOptimizer.stringPool;
 
         // Map from old -> new indices in the string table. This is used to update the indirect symbol table
         // We make 1 map per cache dylib
@@ -3955,35 +4097,106 @@ Error SharedCacheBuilder::calculateSubCacheSymbolStrings()
         oldToNewIndicesMaps.resize(this->cacheDylibs.size());
 
         // tradition for start of pool to be empty string
-        stringMap["\0"] = 0;
-        ++stringBufferSize;
+        stringPool.addFixedString("");
 
         // If we are unmapping linkedit, then we need the redacted symbol
-        uint32_t redactedStringOffset = ~0U;
-        if ( this->options.localSymbolsMode == cache_builder::LocalSymbolsMode::unmap ) {
-            redactedStringOffset = stringBufferSize;
-            stringMap["<redacted>"] = stringBufferSize;
-            stringBufferSize += strlen("<redacted>") + 1;
-        }
-
-        // The dsc_extractor cares about the order here.  So always do locals, then exports, then imports
-        Error localsError = copyLocalSymbols(subCache, symbolStringChunks, fileToDylibMap,
-                                             fileToSymbolInfoMap, redactedStringOffset,
-                                             stringBufferSize, sourceStringSize, sourceStringCount);
-        if ( localsError.hasError() )
-            return localsError;
-
-        Error exportsError = copyExportedSymbols(subCache, symbolStringChunks, fileToDylibMap,
-                                                 fileToSymbolInfoMap, oldToNewIndicesMaps, redactedStringOffset,
-                                                 stringBufferSize, sourceStringSize, sourceStringCount);
-        if ( exportsError.hasError() )
-            return localsError;
-
-        Error importsError = copyImportedSymbols(subCache, symbolStringChunks, fileToDylibMap,
-                                                 fileToSymbolInfoMap, oldToNewIndicesMaps, redactedStringOffset,
-                                                 stringBufferSize, sourceStringSize, sourceStringCount);
-        if ( importsError.hasError() )
-            return localsError;
+        if ( unmapLocals )
+            stringPool.addFixedString("<redacted>");
+
+        std::vector<DylibSymbolStrings> dylibSymbolsOwner(symbolStringChunks.size());
+        auto& dylibSymbols = dylibSymbolsOwner;
+        for ( uint32_t i = 0; i != symbolStringChunks.size(); ++i ) {
+            DylibSymbolStrings& symbols = dylibSymbols[i];
+            symbols.dylib               = fileToDylibMap.at(symbolStringChunks[i]->inputFile);
+            symbols.stringPoolClient    = &stringPool.addClient();
+            symbols.oldToNewIndices     = &oldToNewIndicesMaps[symbols.dylib->cacheIndex];
+            if ( unmapLocals )
+                symbols.unmappedStringPoolClient = unmappedStringPoolClients[symbols.dylib->cacheIndex];
+        }
+
+        // Each dylib only adds to its own nlist and string pool clients, so the dylibs can be walked in parallel
+        Timer::AggregateTimer* aggregateTimerPtr = &aggregateTimer;
+        Error copyError = parallel::forEach(dylibSymbols, ^(size_t index, DylibSymbolStrings& symbols) {
+            Timer::AggregateTimer::Scope copyTimedScope(*aggregateTimerPtr, "calculateSubCacheSymbolStrings copy symbols time");
+
+            // The dsc_extractor cares about the order here.  So always do locals, then exports, then imports
+            if ( Error localsError = copyLocalSymbols(symbols); localsError.hasError() )
+                return localsError;
+
+            if ( Error exportsError = copyExportedSymbols(symbols); exportsError.hasError() )
+                return exportsError;
+
+            if ( Error importsError = copyImportedSymbols(symbols); importsError.hasError() )
+                return importsError;
+
+            return Error();
+        });
+        if ( copyError.hasError() )
+            return copyError;
+
+        // Unmapped locals are added to one nlist for the whole .symbols file, in dylib order.
+        // Lay out each dylib's nlist after those from earlier SubCaches, then copy them all in parallel
+        if ( unmapLocals ) {
+            Timer::AggregateTimer::Scope mergeTimedScope(aggregateTimer, "calculateSubCacheSymbolStrings merge unmapped nlist time");
+
+            NListChunk& unmappedNList = this->unmappedSymbolsOptimizer.symbolNlistChunk;
+            const uint32_t nlistSize = config.layout.is64 ? sizeof(struct nlist_64) : sizeof(struct nlist);
+
+            LinkeditMerger merger;
+            // Every piece is whole entries, so only the entry type's alignment is needed.  Note a 32-bit
+            // nlist is 12 bytes, which isn't a valid alignment
+            const uint32_t nlistAlignment = config.layout.is64 ? alignof(struct nlist_64) : alignof(struct nlist);
+            const LinkeditMerger::RegionIndex nlistRegion = merger.addRegion("unmapped locals nlist", nlistAlignment);
+            for ( const DylibSymbolStrings& symbols : dylibSymbols ) {
+                if ( config.layout.is64 )
+                    merger.addPiece(nlistRegion, symbols.unmappedNList64.data(), symbols.unmappedNList64.size() * nlistSize);
+                else
+                    merger.addPiece(nlistRegion, symbols.unmappedNList32.data(), symbols.unmappedNList32.size() * nlistSize);
+            }
+            uint64_t existingNListSize = (config.layout.is64 ? unmappedNList.nlist64.size() : unmappedNList.nlist32.size()) * nlistSize;
+            uint64_t totalNListSize = merger.layout(existingNListSize);
+
+            for ( uint32_t i = 0; i != dylibSymbols.size(); ++i ) {
+                const DylibSymbolStrings& symbols = dylibSymbols[i];
+                UnmappedSymbolsOptimizer::LocalSymbolInfo& symbolInfo = this->unmappedSymbolsOptimizer.symbolInfos[symbols.dylib->cacheIndex];
+                symbolInfo.nlistStartIndex = (uint32_t)(merger.pieceOffset(nlistRegion, i) / nlistSize);
+                symbolInfo.nlistCount      = (uint32_t)(config.layout.is64 ? symbols.unmappedNList64.size() : symbols.unmappedNList32.size());
+            }
+
+            uint8_t* nlistBuffer = nullptr;
+            if ( config.layout.is64 ) {
+                unmappedNList.nlist64.resize(totalNListSize / nlistSize);
+                nlistBuffer = (uint8_t*)unmappedNList.nlist64.data();
+            } else {
+                unmappedNList.nlist32.resize(totalNListSize / nlistSize);
+                nlistBuffer = (uint8_t*)unmappedNList.nlist32.data();
+            }
+            merger.copy(nlistBuffer);
+        }
+
+        // Now we have all the strings, lay out the pool, then replace the string IDs in the nlists with real offsets
+        {
+            Timer::AggregateTimer::Scope mergeTimedScope(aggregateTimer, "calculateSubCacheSymbolStrings merge strings time");
+            stringPool.finalize();
+        }
+
+        Error updateError = parallel::forEach(dylibSymbols, ^(size_t index, DylibSymbolStrings& symbols) {
+            const SymbolStringPool::Client& client = *symbols.stringPoolClient;
+            for ( struct nlist_64& sym : symbols.dylib->optimizedSymbols.nlist64 )
+                sym.n_un.n_strx = client.offset(sym.n_un.n_strx);
+            for ( struct nlist& sym : symbols.dylib->optimizedSymbols.nlist32 )
+                sym.n_un.n_strx = client.offset(sym.n_un.n_strx);
+            return Error();
+        });
+        assert(!updateError.hasError());
+
+        uint32_t stringBufferSize  = stringPool.size();
+        uint64_t sourceStringSize  = 0;
+        uint32_t sourceStringCount = 0;
+        for ( const DylibSymbolStrings& symbols : dylibSymbols ) {
+            sourceStringSize  += symbols.sourceStringSize;
+            sourceStringCount += symbols.sourceStringCount;
+        }
 
         // Delete the old unoptimized nlists
         auto isNList = [](const Chunk* chunk) {
@@ -4038,8 +4251,10 @@ Error SharedCacheBuilder::calculateSubCacheSymbolStrings()
         }
 
         if ( this->config.log.printStats ) {
-            stats.add("  linkedit: deduplicated %d symbols strings to %d.  %dMB -> %dMB\n",
-                      sourceStringCount, (uint32_t)stringMap.size(), sourceStringSize >> 20, stringBufferSize >> 20);
+            stats.add("  linkedit: deduplicated %d symbols strings to %d.  %lldMB -> %dMB\n",
+                      sourceStringCount, stringPool.uniqueStringCount(), sourceStringSize >> 20, stringBufferSize >> 20);
+            stats.add("  linkedit: tail merged %d symbol strings, saving %lldKB\n",
+                      stringPool.tailMergedStringCount(), stringPool.tailMergedByteCount() >> 10);
         }
 
         // Update the indirect symbol table for any dylib which had moved symbols
@@ -4098,6 +4313,50 @@ Error SharedCacheBuilder::calculateSubCacheSymbolStrings()
         assert(this->subCaches.size() < this->subCaches.capacity());
         this->subCaches.push_back(SubCache::makeSymbolsCache());
         SubCache& localSymbolsSubCache = this->subCaches.back();
+
+        // All dylibs have added their locals, so the pool can be laid out, and the nlist given real offsets
+        SymbolStringPool& unmappedStringPool = this->unmappedSymbolsOptimizer.stringPool;
+        {
+            Timer::AggregateTimer::Scope mergeTimedScope(aggregateTimer, "calculateSubCacheSymbolStrings merge strings time");
+            unmappedStringPool.finalize();
+        }
+
+        const auto& stringPoolClients = unmappedStringPoolClients;
+        NListChunk& unmappedNList = this->unmappedSymbolsOptimizer.symbolNlistChunk;
+        Error updateError = parallel::forEach(this->unmappedSymbolsOptimizer.symbolInfos,
+                                              ^(size_t index, UnmappedSymbolsOptimizer::LocalSymbolInfo& symbolInfo) {
+            const SymbolStringPool::Client& client = *stringPoolClients[index];
+            for ( uint32_t i = 0; i != symbolInfo.nlistCount; ++i ) {
+                if ( config.layout.is64 ) {
+                    struct nlist_64& sym = unmappedNList.nlist64[symbolInfo.nlistStartIndex + i];
+                    sym.n_un.n_strx = client.offset(sym.n_un.n_strx);
+                } else {
+                    struct nlist& sym = unmappedNList.nlist32[symbolInfo.nlistStartIndex + i];
+                    sym.n_un.n_strx = client.offset(sym.n_un.n_strx);
+                }
+            }
+            return Error();
+        });
+        assert(!updateError.hasError());
+
+        if ( this->config.log.printStats ) {
+            stats.add("  linkedit: unmapped locals use %d strings in %dKB, tail merged %d strings saving %lldKB\n",
+                      unmappedStringPool.uniqueStringCount(), unmappedStringPool.size() >> 10,
+                      unmappedStringPool.tailMergedStringCount(), unmappedStringPool.tailMergedByteCount() >> 10);
+        }
+
+        if ( this->options.compactLocalSymbols ) {
+            Timer::AggregateTimer::Scope compactTimedScope(aggregateTimer, "calculateSubCacheSymbolStrings compact locals time");
+            sizeCompactLocalSymbols(this->unmappedSymbolsOptimizer, this->config.layout.is64);
+
+            if ( this->config.log.printStats ) {
+                uint64_t nlistSize = this->config.layout.is64 ? (unmappedNList.nlist64.size() * sizeof(struct nlist_64))
+                                                              : (unmappedNList.nlist32.size() * sizeof(struct nlist));
+                stats.add("  linkedit: compact unmapped locals reserve %lldKB, instead of %lldKB of nlist and strings\n",
+                          this->unmappedSymbolsOptimizer.compactDataSize >> 10, (nlistSize + unmappedStringPool.size()) >> 10);
+            }
+        }
+
         localSymbolsSubCache.addUnmappedSymbols(this->config, this->unmappedSymbolsOptimizer);
 
         // Finalize the symbols cache
@@ -6472,7 +6731,15 @@ Error SharedCacheBuilder::emitExecutablePrebuiltLoaders()
     };
 
     ScopedDeleter deleter(executableLoaders);
+
+    // Each executable is built on its own thread with its own RuntimeState and allocator.  Only the cache dylib
+    // loaders, layouts, and on-disk mappings are shared, and those are all read-only at this point.
+    // The per-executable times are summed so that we can compare them against the wall time
+    Timer::AggregateTimer  executableTimer(this->config);
+    Timer::AggregateTimer* executableTimerPtr = &executableTimer;
+    uint64_t parallelStartTimeNanos = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
     Error err = parallel::forEach(this->exeInputFiles, ^(size_t index, InputFile*& exeFile) {
+        Timer::AggregateTimer::Scope timedScope(*executableTimerPtr, "executable PrebuiltLoaderSet time");
         const mach_o::Layout& exeLayout = layoutBuilderPtr->getExecutableLayout((uint32_t)index);
 
         if ( log ) {
@@ -6482,7 +6749,7 @@ Error SharedCacheBuilder::emitExecutablePrebuiltLoaders()
         const MachOFile* mainMF = exeFile->mf;
         KernelArgs       kernArgs(mainMF, { "test.exe" }, {}, {});
         SyscallDelegate  osDelegate;
-        osDelegate._mappedOtherDylibs = otherMapping;
+        osDelegate._sharedMappedOtherDylibs = &otherMapping;
         osDelegate._gradedArchs       = &this->options.archs;
         //osDelegate._dyldCache           = dyldCache;
         STACK_ALLOCATOR(alloc, 0);
@@ -6571,7 +6838,13 @@ Error SharedCacheBuilder::emitExecutablePrebuiltLoaders()
             state.partitionDelayLoads(allLoaders, topLoaders);
 
             state.setMainLoader(mainLoader);
-            const dyld4::PrebuiltLoaderSet* prebuiltAppSet = dyld4::PrebuiltLoaderSet::makeLaunchSet(launchDiag, state, missingPaths);
+            // Apps with many embedded frameworks are the slowest to build, so their objc images can also be visited in parallel
+            const bool parallelObjC = this->options.parallelObjCClosures;
+            const dyld4::PrebuiltLoaderSet* prebuiltAppSet = nullptr;
+            {
+                Timer::AggregateTimer::Scope makeTimedScope(*executableTimerPtr, "executable makeLaunchSet time");
+                prebuiltAppSet = dyld4::PrebuiltLoaderSet::makeLaunchSet(launchDiag, state, missingPaths, parallelObjC);
+            }
             if ( launchDiag.hasError() ) {
                 //fprintf(stderr, "warning: can't build PrebuiltLoaderSet for '%s': %s\n", exeFile->path.c_str(), launchDiag.errorMessageCStr());
                 if ( log )
@@ -6596,6 +6869,17 @@ Error SharedCacheBuilder::emitExecutablePrebuiltLoaders()
     });
 
     assert(!err.hasError());
+
+    if ( this->config.log.printTimers ) {
+        uint64_t wallTimeNanos  = clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - parallelStartTimeNanos;
+        uint64_t totalTimeNanos = executableTimer.timeNanos("executable PrebuiltLoaderSet time");
+        if ( wallTimeNanos != 0 ) {
+            this->config.log.log("emitExecutablePrebuiltLoaders parallel speedup = %.1fx (%lldms across threads, %lldms wall)\n",
+                                 (double)totalTimeNanos / (double)wallTimeNanos, totalTimeNanos / 1000000, wallTimeNanos / 1000000);
+        }
+    }
+
+    // Serialize in path order, not in the order the threads finished, so that the trie and pool are deterministic
     std::map<std::string_view, const dyld4::PrebuiltLoaderSet*> prebuiltsMap;
     uint64_t prebuiltsSpace = 0;
     for ( uint64_t i = 0; i != this->exeInputFiles.size(); ++i ) {
@@ -6612,6 +6896,7 @@ Error SharedCacheBuilder::emitExecutablePrebuiltLoaders()
     uint64_t loaderBufferSize = loaderChunk->subCacheFileSize.rawValue();
 
     if ( this->config.log.printStats ) {
+        stats.add("  dyld4 executable Loader's : built %lu out of %lu executables\n", prebuiltsMap.size(), this->exeInputFiles.size());
         stats.add("  dyld4 executable Loader's : used %lld out of %lld bytes of buffer\n", prebuiltsSpace, loaderBufferSize);
     }
 
@@ -6635,6 +6920,8 @@ Error SharedCacheBuilder::emitExecutablePrebuiltLoaders()
     uint8_t* poolBase = loaderChunk->subCacheBuffer;
     __block std::vector<DylibIndexTrie::Entry> trieEntrys;
     uint32_t                                   currentPoolOffset = 0;
+    // one entry for the path and one for the cdHash
+    trieEntrys.reserve(prebuiltsMap.size() * 2);
     for ( const auto& entry : prebuiltsMap ) {
         const dyld4::PrebuiltLoaderSet* pbls = entry.second;
         // FIXME: Use a string_view if we change Trie to accept it
@@ -6698,24 +6985,24 @@ void SharedCacheBuilder::emitSymbolTable()
 
         uint8_t* buffer = subCache.symbolStringsOptimizer.symbolStringsChunk->subCacheBuffer;
 
-        for ( const auto& stringAndPos : subCache.symbolStringsOptimizer.stringMap ) {
-            const std::string_view& str = stringAndPos.first;
-            const uint32_t bufferOffset = stringAndPos.second;
-
+        subCache.symbolStringsOptimizer.stringPool.forEachString(^(std::string_view str, uint32_t bufferOffset) {
             memcpy(buffer + bufferOffset, str.data(), str.size());
-        }
+        });
     }
 }
 
-void SharedCacheBuilder::emitUnmappedLocalSymbols()
+Error SharedCacheBuilder::emitUnmappedLocalSymbols()
 {
     if ( this->options.localSymbolsMode != LocalSymbolsMode::unmap )
-        return;
+        return Error();
 
     Timer::Scope timedScope(this->config, "emitUnmappedLocalSymbols time");
 
     auto& optimizer = this->unmappedSymbolsOptimizer;
 
+    if ( optimizer.compact )
+        return emitCompactUnmappedLocalSymbols();
+
     const uint32_t entriesOffset = sizeof(dyld_cache_local_symbols_info);
     const uint32_t entriesCount  = (uint32_t)optimizer.symbolInfos.size();
     const uint32_t nlistOffset   = (uint32_t)(optimizer.symbolNlistChunk.subCacheFileOffset.rawValue() - optimizer.unmappedSymbolsChunk.subCacheFileOffset.rawValue());
@@ -6754,13 +7041,76 @@ void SharedCacheBuilder::emitUnmappedLocalSymbols()
     {
         uint8_t* buffer = optimizer.symbolStringsChunk.subCacheBuffer;
 
-        for ( const auto& stringAndPos : optimizer.stringMap ) {
-            const std::string_view& str = stringAndPos.first;
-            const uint32_t bufferOffset = stringAndPos.second;
-
+        optimizer.stringPool.forEachString(^(std::string_view str, uint32_t bufferOffset) {
             memcpy(buffer + bufferOffset, str.data(), str.size());
-        }
+        });
     }
+
+    return Error();
+}
+
+Error SharedCacheBuilder::emitCompactUnmappedLocalSymbols()
+{
+    auto& optimizer = this->unmappedSymbolsOptimizer;
+
+    uint8_t* buffer = optimizer.unmappedSymbolsChunk.subCacheBuffer;
+    const uint32_t blocksOffset = sizeof(dyld_cache_local_symbols_compact_info);
+    const uint32_t blocksCount  = (uint32_t)optimizer.symbolInfos.size();
+
+    // Emit the header.  The legacy part has no nlist or entries, so that old tools see no locals
+    {
+        dyld_cache_local_symbols_compact_info* infoHeader = (dyld_cache_local_symbols_compact_info*)buffer;
+        infoHeader->legacy.nlistOffset      = 0;
+        infoHeader->legacy.nlistCount       = 0;
+        infoHeader->legacy.stringsOffset    = 0;
+        infoHeader->legacy.stringsSize      = 0;
+        infoHeader->legacy.entriesOffset    = blocksOffset;
+        infoHeader->legacy.entriesCount     = 0;
+        infoHeader->magic                   = DYLD_CACHE_LOCAL_SYMBOLS_COMPACT_MAGIC;
+        infoHeader->version                 = DYLD_CACHE_LOCAL_SYMBOLS_COMPACT_VERSION;
+        infoHeader->blocksOffset            = blocksOffset;
+        infoHeader->blocksCount             = blocksCount;
+        infoHeader->maxNameLength           = optimizer.compactMaxNameLength;
+        infoHeader->reserved                = 0;
+    }
+
+    // Encode each dylib's block, now that the nlist has the final addresses
+    dyld_cache_local_symbols_compact_entry* blocks = (dyld_cache_local_symbols_compact_entry*)(buffer + blocksOffset);
+    const bool is64 = this->config.layout.is64;
+    const auto& constOptimizer = optimizer;
+    Error emitError = parallel::forEach(optimizer.symbolInfos, ^(size_t index, UnmappedSymbolsOptimizer::LocalSymbolInfo& symbolInfo) {
+        uint8_t* const blockStart = buffer + symbolInfo.compactDataOffset;
+        uint8_t*       p          = blockStart;
+        compact_local_symbols::Symbol prev;
+        for ( uint32_t nlistIndex : symbolInfo.compactOrder ) {
+            compact_local_symbols::Symbol sym = unmappedLocalSymbol(constOptimizer, is64, nlistIndex);
+
+            // The space was reserved from the input addresses, see sizeCompactLocalSymbols().  Writing past it would
+            // overwrite the next dylib's block
+            if ( (uint64_t)(p - blockStart) + compact_local_symbols::encodedSize(prev, sym) > symbolInfo.compactDataSize )
+                return Error("compact local symbols for %s need more than the %u bytes reserved for them",
+                             this->cacheDylibs[index].installName.data(), symbolInfo.compactDataSize);
+            p = compact_local_symbols::encode(p, prev, sym);
+            prev = sym;
+        }
+
+        dyld_cache_local_symbols_compact_entry& block = blocks[index];
+        block.dylibOffset   = (this->cacheDylibs[index].cacheLoadAddress - this->config.layout.cacheBaseAddress).rawValue();
+        block.dataOffset    = symbolInfo.compactDataOffset;
+        block.dataSize      = (uint32_t)(p - blockStart);
+        block.symbolCount   = symbolInfo.nlistCount;
+        block.maxNameLength = symbolInfo.maxNameLength;
+        return Error();
+    });
+    if ( emitError.hasError() )
+        return emitError;
+
+    // Readers binary search the blocks, so they have to be sorted by dylib offset, not in dylib order
+    std::sort(blocks, blocks + blocksCount, [](const dyld_cache_local_symbols_compact_entry& a, const dyld_cache_local_symbols_compact_entry& b) {
+        return a.dylibOffset < b.dylibOffset;
+    });
+
+    return Error();
 }
 
 void SharedCacheBuilder::emitObjCSelectorStrings()
@@ -8436,6 +8786,33 @@ void SharedCacheBuilder::emitFunctionVariants()
 }
 
 
+void SharedCacheBuilder::emitExportFilters()
+{
+    Timer::Scope timedScope(this->config, "emitExportFilters time");
+
+    const ExportFiltersOptimizer& opt = this->exportFiltersOptimizer;
+    if ( opt.chunk == nullptr )
+        return;
+
+    uint8_t*                   buffer  = opt.chunk->subCacheBuffer;
+    dyld_cache_export_filters* filters = (dyld_cache_export_filters*)buffer;
+    filters->version = 1;
+    filters->count   = (uint32_t)opt.filters.size();
+
+    uint64_t wordsOffset = alignTo((uint64_t)offsetof(dyld_cache_export_filters, entries[filters->count]), 8);
+    for ( uint32_t i = 0; i != filters->count; ++i ) {
+        const std::vector<uint64_t>& filter = opt.filters[i];
+        if ( filter.empty() ) {
+            filters->entries[i] = { 0, 0 };
+            continue;
+        }
+        filters->entries[i] = { (uint32_t)wordsOffset, (uint32_t)filter.size() };
+        memcpy(buffer + wordsOffset, filter.data(), filter.size() * sizeof(uint64_t));
+        wordsOffset += filter.size() * sizeof(uint64_t);
+    }
+    assert(wordsOffset == opt.exportFiltersByteSize);
+}
+
 void SharedCacheBuilder::emitCacheDylibsTrie()
 {
     Timer::Scope timedScope(this->config, "emitCacheDylibsTrie time");
@@ -8825,6 +9202,7 @@ void SharedCacheBuilder::computeCacheHeaders()
                                             this->dylibTrieOptimizer,
                                             this->objcOptimizer, this->swiftOptimizer,
                                             this->patchTableOptimizer, this->functionVariantsOptimizer,
+                                            this->exportFiltersOptimizer,
                                             this->prebuiltLoaderBuilder, this->prewarmingOptimizer);
             continue;
         }
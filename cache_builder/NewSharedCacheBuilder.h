@@ -156,6 +156,7 @@ private:
     void            calculateCacheDylibsTrie();
     void            estimatePatchTableSize();
     void            estimateFunctionVariantsSize();
+    void            estimateExportFiltersSize();
     void            estimateCacheLoadersSize();
     void            estimatePrewarmingSize();
     void            setupStubOptimizer();
@@ -203,10 +204,12 @@ private:
     void            emitCacheDylibsTrie();
     error::Error    emitPatchTable();
     void            emitFunctionVariants();
+    void            emitExportFilters();
     error::Error    emitCacheDylibsPrebuiltLoaders();
     error::Error    emitExecutablePrebuiltLoaders();
     void            emitSymbolTable();
-    void            emitUnmappedLocalSymbols();
+    error::Error    emitUnmappedLocalSymbols();
+    error::Error    emitCompactUnmappedLocalSymbols();
     error::Error    emitPrewarmingData();
     uint64_t        getMaxSlide() const;
     void            addObjcSegments();
@@ -222,34 +225,25 @@ private:
                                     const SubCache& mainSubCache) const;
 
     typedef std::unordered_map<const InputFile*, CacheDylib*> FileToDylibMap;
-    typedef std::unordered_map<const InputFile*, UnmappedSymbolsOptimizer::LocalSymbolInfo*> FileToSymbolInfoMap;
     typedef std::unordered_map<uint32_t, uint32_t> OldToNewIndicesMap;
-    error::Error copyLocalSymbols(SubCache& subCache,
-                                  const std::span<LinkeditDataChunk*> symbolStringChunks,
-                                  const FileToDylibMap& fileToDylibMap,
-                                  const FileToSymbolInfoMap& fileToSymbolInfoMap,
-                                  const uint32_t redactedStringOffset,
-                                  uint32_t& stringBufferSize,
-                                  uint32_t& sourceStringSize,
-                                  uint32_t& sourceStringCount);
-    error::Error copyExportedSymbols(SubCache& subCache,
-                                     const std::span<LinkeditDataChunk*> symbolStringChunks,
-                                     const FileToDylibMap& fileToDylibMap,
-                                     const FileToSymbolInfoMap& fileToSymbolInfoMap,
-                                     std::vector<OldToNewIndicesMap>& oldToNewIndicesMaps,
-                                     const uint32_t redactedStringOffset,
-                                     uint32_t& stringBufferSize,
-                                     uint32_t& sourceStringSize,
-                                     uint32_t& sourceStringCount);
-    error::Error copyImportedSymbols(SubCache& subCache,
-                                     const std::span<LinkeditDataChunk*> symbolStringChunks,
-                                     const FileToDylibMap& fileToDylibMap,
-                                     const FileToSymbolInfoMap& fileToSymbolInfoMap,
-                                     std::vector<OldToNewIndicesMap>& oldToNewIndicesMaps,
-                                     const uint32_t redactedStringOffset,
-                                     uint32_t& stringBufferSize,
-                                     uint32_t& sourceStringSize,
-                                     uint32_t& sourceStringCount);
+
+    // The symbols for one dylib while building the LINKEDIT symbol string pools.  Each dylib only touches
+    // its own state here, so dylibs can be processed in parallel.  Until the pools are finalized, the
+    // n_strx in the nlists are IDs from the string pool clients, not offsets
+    struct DylibSymbolStrings
+    {
+        CacheDylib*                     dylib                       = nullptr;
+        SymbolStringPool::Client*       stringPoolClient            = nullptr;
+        SymbolStringPool::Client*       unmappedStringPoolClient    = nullptr;
+        OldToNewIndicesMap*             oldToNewIndices             = nullptr;
+        std::vector<struct nlist>       unmappedNList32;
+        std::vector<struct nlist_64>    unmappedNList64;
+        uint32_t                        sourceStringSize            = 0;
+        uint32_t                        sourceStringCount           = 0;
+    };
+    error::Error copyLocalSymbols(DylibSymbolStrings& symbols);
+    error::Error copyExportedSymbols(DylibSymbolStrings& symbols);
+    error::Error copyImportedSymbols(DylibSymbolStrings& symbols);
 
     __attribute__((format(printf, 2, 3)))
     void            warning(const char* format, ...);
@@ -291,6 +285,7 @@ private:
     UnmappedSymbolsOptimizer             unmappedSymbolsOptimizer;
     StubOptimizer                        stubOptimizer;
     FunctionVariantsOptimizer            functionVariantsOptimizer;
+    ExportFiltersOptimizer               exportFiltersOptimizer;
     PrewarmingOptimizer                  prewarmingOptimizer;
 };
 
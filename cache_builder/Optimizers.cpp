@@ -24,6 +24,10 @@
 
 #include "Optimizers.h"
 
+#include <algorithm>
+#include <assert.h>
+#include <dispatch/dispatch.h>
+
 using namespace cache_builder;
 
 
@@ -532,3 +536,143 @@ void StubOptimizer::generateArm64eStubToGOT(uint8_t* stubBuffer,
     stubInstructions[2] = 0xF9400230;  // LDR   X16, [X17]
     stubInstructions[3] = 0xD71F0A11;  // BRAA  X16, X17
 }
+
+//
+// MARK: --- SymbolStringPool methods ---
+//
+
+uint32_t SymbolStringPool::Client::add(std::string_view str)
+{
+    auto itAndInserted = this->stringIDs.insert({ str, (uint32_t)this->shardIndices.size() });
+    if ( itAndInserted.second ) {
+        // Use the high bits to pick the shard, as the low bits pick the bucket in the shard's map
+        uint64_t hash = HashString::hash(str, nullptr);
+        this->shardIndices.push_back((uint8_t)((hash >> 48) % SymbolStringPool::numShards));
+    }
+    return itAndInserted.first->second;
+}
+
+uint32_t SymbolStringPool::addFixedString(std::string_view str)
+{
+    assert(this->clients.empty());
+
+    auto itAndInserted = this->fixedStrings.insert({ str, this->bufferSize });
+    if ( itAndInserted.second ) {
+        this->strings.push_back({ str, this->bufferSize });
+        this->bufferSize += str.size() + 1;
+    }
+    return itAndInserted.first->second;
+}
+
+SymbolStringPool::Client& SymbolStringPool::addClient()
+{
+    this->clients.push_back(std::make_unique<Client>());
+    return *this->clients.back();
+}
+
+// Compares strings from their last character.  Sorting with this puts every string directly after
+// the longer strings it is a suffix of, eg, "__foo" then "_foo" then "foo"
+static bool tailMergeOrder(std::string_view a, std::string_view b)
+{
+    size_t aPos = a.size();
+    size_t bPos = b.size();
+    while ( (aPos != 0) && (bPos != 0) ) {
+        uint8_t aChar = a[--aPos];
+        uint8_t bChar = b[--bPos];
+        if ( aChar != bChar )
+            return aChar > bChar;
+    }
+    return aPos > bPos;
+}
+
+void SymbolStringPool::finalize()
+{
+    for ( std::unique_ptr<Client>& client : this->clients ) {
+        client->shardStringIndices.resize(client->shardIndices.size());
+        client->offsets.resize(client->shardIndices.size());
+    }
+
+    // Deduplicate across clients.  Each shard only sees the strings whose hash picked it, so the shards
+    // can be built in parallel without locks.  Clients are always walked in order so the shards are deterministic
+    std::vector<SymbolStringMap> shardsOwner(numShards);
+    auto& shards = shardsOwner;
+    auto& allClients = this->clients;
+    dispatch_apply(numShards, DISPATCH_APPLY_AUTO, ^(size_t shardIndex) {
+        SymbolStringMap& shard = shards[shardIndex];
+        for ( std::unique_ptr<Client>& client : allClients ) {
+            const auto& clientStrings = client->stringIDs.array();
+            for ( uint32_t stringID = 0; stringID != client->shardIndices.size(); ++stringID ) {
+                if ( client->shardIndices[stringID] != shardIndex )
+                    continue;
+                auto itAndInserted = shard.insert({ clientStrings[stringID].first, (uint32_t)shard.size() });
+                client->shardStringIndices[stringID] = itAndInserted.first->second;
+            }
+        }
+    });
+
+    // Flatten the shards.  Fixed strings already have an offset, everything else is sorted for tail merging
+    std::vector<uint32_t>           shardStartIndicesOwner(numShards);
+    auto&                           shardStartIndices = shardStartIndicesOwner;
+    std::vector<std::string_view>   uniqueStrings;
+    for ( uint32_t shardIndex = 0; shardIndex != numShards; ++shardIndex ) {
+        shardStartIndices[shardIndex] = (uint32_t)uniqueStrings.size();
+        for ( const auto& stringAndIndex : shards[shardIndex].array() )
+            uniqueStrings.push_back(stringAndIndex.first);
+    }
+
+    std::vector<uint32_t> uniqueOffsetsOwner(uniqueStrings.size());
+    auto&                 uniqueOffsets = uniqueOffsetsOwner;
+    std::vector<uint32_t> sortedIndices;
+    sortedIndices.reserve(uniqueStrings.size());
+    for ( uint32_t i = 0; i != uniqueStrings.size(); ++i ) {
+        auto it = this->fixedStrings.find(uniqueStrings[i]);
+        if ( it != this->fixedStrings.end() )
+            uniqueOffsets[i] = it->second;
+        else
+            sortedIndices.push_back(i);
+    }
+
+    std::sort(sortedIndices.begin(), sortedIndices.end(), [&uniqueStrings](uint32_t a, uint32_t b) {
+        return tailMergeOrder(uniqueStrings[a], uniqueStrings[b]);
+    });
+
+    // Each string is either a suffix of the string before it, or needs its own bytes
+    std::string_view prevString;
+    uint32_t         prevOffset = 0;
+    for ( uint32_t index : sortedIndices ) {
+        std::string_view str = uniqueStrings[index];
+        uint32_t         offset;
+        if ( !prevString.empty() && prevString.ends_with(str) ) {
+            offset = prevOffset + (uint32_t)(prevString.size() - str.size());
+            ++this->numTailMergedStrings;
+            this->numTailMergedBytes += str.size() + 1;
+        } else {
+            offset = this->bufferSize;
+            this->strings.push_back({ str, offset });
+            this->bufferSize += str.size() + 1;
+        }
+        uniqueOffsets[index] = offset;
+        prevString           = str;
+        prevOffset           = offset;
+    }
+    this->numUniqueStrings = (uint32_t)(this->fixedStrings.size() + sortedIndices.size());
+
+    // Map every client ID to its offset
+    dispatch_apply(allClients.size(), DISPATCH_APPLY_AUTO, ^(size_t clientIndex) {
+        Client& client = *allClients[clientIndex];
+        for ( uint32_t stringID = 0; stringID != client.offsets.size(); ++stringID ) {
+            uint32_t uniqueIndex = shardStartIndices[client.shardIndices[stringID]] + client.shardStringIndices[stringID];
+            client.offsets[stringID] = uniqueOffsets[uniqueIndex];
+        }
+        client.shardIndices.clear();
+        client.shardIndices.shrink_to_fit();
+        client.shardStringIndices.clear();
+        client.shardStringIndices.shrink_to_fit();
+    });
+}
+
+void SymbolStringPool::forEachString(void (^callback)(std::string_view str, uint32_t offset)) const
+{
+    for ( const auto& stringAndOffset : this->strings )
+        callback(stringAndOffset.first, stringAndOffset.second);
+}
@@ -33,6 +33,7 @@
 #include "SectionCoalescer.h"
 
 #include <list>
+#include <memory>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -396,16 +397,62 @@ struct DylibTrieOptimizer
     const CacheTrieChunk*           dylibsTrieChunk = nullptr;
 };
 
-struct SymbolStringsOptimizer
+// Builds a LINKEDIT symbol string pool.  Each client, eg, a dylib, adds its strings independently, so
+// clients can run in parallel.  Then finalize() deduplicates across clients and tail merges, so that a
+// string which is a suffix of another, eg, "_foo" and "__foo", points in to the bytes of the longer one.
+// The layout only depends on the set of strings, not on the order they were added
+struct SymbolStringPool
 {
-    struct LocalSymbolInfo
+    struct Client
     {
-        uint64_t    dylibOffset;
-        uint32_t    nlistStartIndex;
-        uint32_t    nlistCount;
+        // Returns an ID for the string.  The offset of the string is only known after SymbolStringPool::finalize()
+        uint32_t add(std::string_view str);
+        uint32_t offset(uint32_t stringID) const { return this->offsets[stringID]; }
+
+    private:
+        friend struct SymbolStringPool;
+
+        SymbolStringMap                 stringIDs;
+        // For each ID, which shard and which entry in that shard, the string was merged in to
+        std::vector<uint8_t>            shardIndices;
+        std::vector<uint32_t>           shardStringIndices;
+        // For each ID, the offset of the string in the pool.  Set by finalize()
+        std::vector<uint32_t>           offsets;
     };
 
-    SymbolStringMap             stringMap;
+    // Adds a string at a fixed offset at the start of the pool, eg, the empty string at offset 0.
+    // Returns its offset.  Must be called before any clients add strings
+    uint32_t    addFixedString(std::string_view str);
+
+    // The returned reference is valid for the lifetime of the pool
+    Client&     addClient();
+
+    // Assigns offsets to all strings, and to all client string IDs
+    void        finalize();
+
+    uint32_t    size() const                    { return this->bufferSize; }
+    uint32_t    uniqueStringCount() const       { return this->numUniqueStrings; }
+    uint32_t    tailMergedStringCount() const   { return this->numTailMergedStrings; }
+    uint64_t    tailMergedByteCount() const     { return this->numTailMergedBytes; }
+
+    // Calls the callback for each string which owns bytes in the pool.  Tail merged strings are skipped
+    void        forEachString(void (^callback)(std::string_view str, uint32_t offset)) const;
+
+private:
+    static const uint32_t                   numShards = 64;
+
+    SymbolStringMap                         fixedStrings;
+    std::vector<std::unique_ptr<Client>>    clients;
+    std::vector<std::pair<std::string_view, uint32_t>> strings;
+    uint32_t                                bufferSize              = 0;
+    uint32_t                                numUniqueStrings        = 0;
+    uint32_t                                numTailMergedStrings    = 0;
+    uint64_t                                numTailMergedBytes      = 0;
+};
+
+struct SymbolStringsOptimizer
+{
+    SymbolStringPool            stringPool;
 
     // The Chunk in a SubCache which will contain the symbol strings
     const SymbolStringsChunk*   symbolStringsChunk = nullptr;
@@ -417,12 +464,25 @@ struct UnmappedSymbolsOptimizer
     {
         uint32_t    nlistStartIndex     = 0;
         uint32_t    nlistCount          = 0;
+
+        // Only used by the compact format.  The nlist indices in address order, and the space
+        // reserved for them in the unmapped symbols chunk
+        std::vector<uint32_t>   compactOrder;
+        uint32_t                compactDataOffset   = 0;
+        uint32_t                compactDataSize     = 0;
+        uint32_t                maxNameLength       = 0;
     };
 
-    // On embedded, locals are unmapped and stored in a .symbols file.  This is the map
+    // On embedded, locals are unmapped and stored in a .symbols file.  This is the pool
     // of those strings
-    SymbolStringMap                 stringMap;
-    uint32_t                        stringBufferSize    = 0;
+    SymbolStringPool                stringPool;
+
+    // If set, the .symbols file uses the compact format, which is encoded from the nlist and
+    // these strings, instead of emitting them directly
+    bool                            compact                 = false;
+    std::vector<char>               compactStrings;
+    uint32_t                        compactMaxNameLength    = 0;
+    uint64_t                        compactDataSize         = 0;
 
     // Each dylib has an entry tracking its unmapped locals in the .symbol file nlist
     std::vector<LocalSymbolInfo>    symbolInfos;
@@ -503,6 +563,19 @@ struct FunctionVariantsOptimizer
 };
 
 
+struct ExportFiltersOptimizer
+{
+    // How much linkedit space we need for the dyld_cache_export_filters and all the filter words
+    uint64_t                                exportFiltersByteSize = 0;
+
+    // The Chunk in the global SubCache which will contain the export filters
+    const ExportFiltersChunk*               chunk = nullptr;
+
+    // One filter for each cache dylib, or empty if the dylib's exports trie couldn't be walked
+    std::vector<std::vector<uint64_t>>      filters;
+};
+
+
 struct PrebuiltLoaderBuilder
 {
     // How much space we need for the cache dylibs PrebuiltLoader's
@@ -1240,6 +1240,20 @@ void SubCache::addFunctionVariantsChunk(FunctionVariantsOptimizer& optimizer)
     this->addLinkeditChunk(this->functionVariants.get());
 }
 
+void SubCache::addExportFiltersChunk(ExportFiltersOptimizer& optimizer)
+{
+    if ( optimizer.exportFiltersByteSize == 0 )
+        return;
+
+    this->exportFilters                    = std::make_unique<ExportFiltersChunk>();
+    this->exportFilters->cacheVMSize       = CacheVMSize(optimizer.exportFiltersByteSize);
+    this->exportFilters->subCacheFileSize  = CacheFileSize(optimizer.exportFiltersByteSize);
+
+    optimizer.chunk = this->exportFilters.get();
+
+    this->addLinkeditChunk(this->exportFilters.get());
+}
+
 void SubCache::addCacheDylibsLoaderChunk(PrebuiltLoaderBuilder& builder)
 {
     // We can't compute the size yet.
@@ -1353,22 +1367,29 @@ void SubCache::addUnmappedSymbols(const BuilderConfig& config, UnmappedSymbolsOp
 {
     assert(this->kind == Kind::symbols);
 
-    // Add the unmapped symbol data
+    // Add the unmapped symbol data.  The compact format has the header, entries, and encoded
+    // symbols all in this chunk, and leaves the nlist and strings chunks empty
     uint64_t unmappedSymbolsFileSize = 0;
-    unmappedSymbolsFileSize += sizeof(dyld_cache_local_symbols_info);
-    unmappedSymbolsFileSize += sizeof(dyld_cache_local_symbols_entry_64) * opt.symbolInfos.size();
+    if ( opt.compact ) {
+        unmappedSymbolsFileSize += opt.compactDataSize;
+    } else {
+        unmappedSymbolsFileSize += sizeof(dyld_cache_local_symbols_info);
+        unmappedSymbolsFileSize += sizeof(dyld_cache_local_symbols_entry_64) * opt.symbolInfos.size();
+    }
     opt.unmappedSymbolsChunk.cacheVMSize = CacheVMSize(0ULL);
     opt.unmappedSymbolsChunk.subCacheFileSize = CacheFileSize(unmappedSymbolsFileSize);
 
     uint64_t nlistFileSize = 0;
-    if ( config.layout.is64 )
+    if ( opt.compact )
+        nlistFileSize = 0;
+    else if ( config.layout.is64 )
         nlistFileSize += sizeof(struct nlist_64) * opt.symbolNlistChunk.nlist64.size();
     else
         nlistFileSize += sizeof(struct nlist) * opt.symbolNlistChunk.nlist32.size();
     opt.symbolNlistChunk.cacheVMSize = CacheVMSize(0ULL);
     opt.symbolNlistChunk.subCacheFileSize = CacheFileSize(nlistFileSize);
 
-    uint64_t symbolStringsSize = opt.stringBufferSize;
+    uint64_t symbolStringsSize = opt.compact ? 0 : opt.stringPool.size();
     opt.symbolStringsChunk.cacheVMSize = CacheVMSize(0ULL);
     opt.symbolStringsChunk.subCacheFileSize = CacheFileSize(symbolStringsSize);
 
@@ -1644,6 +1665,8 @@ void SubCache::writeCacheHeader(const BuilderOptions& options, const BuilderConf
     dyldCacheHeader->tproMappingsCount             = 0; // set later only on the main cache file
     dyldCacheHeader->prewarmingDataOffset          = 0; // set later only on the main cache file
     dyldCacheHeader->prewarmingDataSize            = 0; // set later only on the main cache file
+    dyldCacheHeader->exportFiltersAddr             = 0; // set later only on the main cache file
+    dyldCacheHeader->exportFiltersSize             = 0; // set later only on the main cache file
 
     // Fill in old mappings
     // And new mappings which also have slide info
@@ -1663,6 +1686,7 @@ void SubCache::addMainCacheHeaderInfo(const BuilderOptions& options, const Build
                                       const SwiftOptimizer& swiftOpt,
                                       const PatchTableOptimizer& patchTableOptimizer,
                                       const FunctionVariantsOptimizer& functionVariantOptimizer,
+                                      const ExportFiltersOptimizer& exportFiltersOptimizer,
                                       const PrebuiltLoaderBuilder& prebuiltLoaderBuilder,
                                       const PrewarmingOptimizer& prewarmingOptimizer)
 {
@@ -1714,6 +1738,11 @@ void SubCache::addMainCacheHeaderInfo(const BuilderOptions& options, const Build
     dyldCacheHeader->functionVariantInfoAddr = functionVariantOptimizer.chunk->cacheVMAddress.rawValue();
     dyldCacheHeader->functionVariantInfoSize = functionVariantOptimizer.fvInfoTotalByteSize;
 
+    if ( exportFiltersOptimizer.chunk != nullptr ) {
+        dyldCacheHeader->exportFiltersAddr = exportFiltersOptimizer.chunk->cacheVMAddress.rawValue();
+        dyldCacheHeader->exportFiltersSize = exportFiltersOptimizer.exportFiltersByteSize;
+    }
+
     // The main cache has offsets to all the caches
     if ( !this->subCaches.empty() ) {
         // The first subCache has an array of UUIDs for all other subCaches
@@ -154,6 +154,7 @@ public:
     void addCacheTrieChunk(DylibTrieOptimizer& dylibTrieOptimizer);
     void addPatchTableChunk(PatchTableOptimizer& patchTableOptimizer);
     void addFunctionVariantsChunk(FunctionVariantsOptimizer& optimizer);
+    void addExportFiltersChunk(ExportFiltersOptimizer& optimizer);
     void addCacheDylibsLoaderChunk(PrebuiltLoaderBuilder& builder);
     void addExecutableLoaderChunk(PrebuiltLoaderBuilder& builder);
     void addExecutablesTrieChunk(PrebuiltLoaderBuilder& builder);
@@ -194,6 +195,7 @@ public:
                                 const SwiftOptimizer& swiftOpt,
                                 const PatchTableOptimizer& patchTableOptimizer,
                                 const FunctionVariantsOptimizer& functionVariantOptimizer,
+                                const ExportFiltersOptimizer& exportFiltersOptimizer,
                                 const PrebuiltLoaderBuilder& prebuiltLoaderBuilder,
                                 const PrewarmingOptimizer& prewarmingOptimizer);
 
@@ -317,6 +319,7 @@ public:
     std::unique_ptr<CacheTrieChunk>                             cacheDylibsTrie;
     std::unique_ptr<PatchTableChunk>                            patchTable;
     std::unique_ptr<FunctionVariantsPatchTableChunk>            functionVariants;
+    std::unique_ptr<ExportFiltersChunk>                         exportFilters;
     std::unique_ptr<DynamicConfigChunk>                         dynamicConfig;
     std::unique_ptr<PrebuiltLoaderChunk>                        cacheDylibsLoaders;
     std::unique_ptr<PrebuiltLoaderChunk>                        executableLoaders;
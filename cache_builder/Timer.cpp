@@ -136,6 +136,17 @@ void cache_builder::Timer::AggregateTimer::record(std::string_view name, uint64_
     pthread_mutex_unlock(&this->mapLock);
 }
 
+uint64_t cache_builder::Timer::AggregateTimer::timeNanos(std::string_view name)
+{
+    uint64_t result = 0;
+    pthread_mutex_lock(&this->mapLock);
+    auto it = timeMap.find(name);
+    if ( it != timeMap.end() )
+        result = timesNanos[it->second].second;
+    pthread_mutex_unlock(&this->mapLock);
+    return result;
+}
+
 #pragma clang diagnostic pop
 
 #pragma clang diagnostic pop
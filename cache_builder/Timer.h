@@ -60,6 +60,9 @@ struct Timer
         ~AggregateTimer();
         void record(std::string_view name, uint64_t startTime, uint64_t endTime);
 
+        // Sum of all times recorded for the given name.  When the clients ran in parallel, this can exceed the wall time
+        uint64_t timeNanos(std::string_view name);
+
         // FIXME: Should we just have an AggregateTimer* in Timer::Scope instead?
         struct Scope
         {
@@ -49,10 +49,10 @@ using cache_builder::SharedCacheBuilder;
 using error::Error;
 
 static const uint64_t kMinBuildVersion = 1; //The minimum version BuildOptions struct we can support
-static const uint64_t kMaxBuildVersion = 3; //The maximum version BuildOptions struct we can support
+static const uint64_t kMaxBuildVersion = 4; //The maximum version BuildOptions struct we can support
 
 static const uint32_t MajorVersion = 1;
-static const uint32_t MinorVersion = 7;
+static const uint32_t MinorVersion = 8;
 
 struct BuildInstance {
     std::unique_ptr<cache_builder::BuilderOptions>  options;
@@ -464,6 +464,24 @@ static bool printStats(const BuildOptions_v1* options) {
     return v3->printStats;
 }
 
+static bool compactLocalSymbols(const BuildOptions_v1* options) {
+    // Old builds always use the nlist format
+    if ( options->version < 4 )
+        return false;
+
+    const BuildOptions_v4* v4 = (const BuildOptions_v4*)options;
+    return v4->compactLocalSymbols;
+}
+
+static bool parallelObjCClosures(const BuildOptions_v1* options) {
+    // Old builds always build closures serially
+    if ( options->version < 4 )
+        return false;
+
+    const BuildOptions_v4* v4 = (const BuildOptions_v4*)options;
+    return v4->parallelObjCClosures;
+}
+
 // This is a JSON file containing the list of classes for which
 // we should try to build IMP caches.
 static json::Node parseObjcOptimizationsFile(Diagnostics& diags, const void* data, size_t length) {
@@ -637,6 +655,8 @@ static bool createBuilders(struct MRMSharedCacheBuilder* builder)
         options->objcOptimizations           = parseObjcOptimizationsFile(diag, builder->objcOptimizationsFileData,
                                                                           builder->objcOptimizationsFileLength);
         options->localSymbolsMode            = excludeLocalSymbols(builder->options);
+        options->compactLocalSymbols         = compactLocalSymbols(builder->options);
+        options->parallelObjCClosures        = parallelObjCClosures(builder->options);
         options->swiftGenericMetadataFile    = builder->swiftGenericMetadataFileData;
         options->prewarmingOptimizations     = builder->prewarmingMetadataFileData;
 
@@ -0,0 +1,294 @@
+/*
+ * Copyright (c) 2025 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef CompactLocalSymbols_h
+#define CompactLocalSymbols_h
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mach-o/nlist.h>
+
+#include <algorithm>
+#include <span>
+#include <string_view>
+
+#include "Defines.h"
+#include "dyld_cache_format.h"
+
+//
+// Encoder and decoder for the compact .symbols format described in dyld_cache_format.h.
+// This is header only as it is used by the cache builder, the tools, and libdyld's
+// introspection SPI, which don't share a common library.
+//
+namespace compact_local_symbols {
+
+// The fields of an nlist we keep for each symbol, with the name instead of a string table offset
+struct Symbol
+{
+    std::string_view    name;
+    uint64_t            value   = 0;
+    uint8_t             type    = 0;
+    uint8_t             sect    = 0;
+    uint16_t            desc    = 0;
+};
+
+// The largest number of bytes an n_value delta can take to encode
+constexpr uint32_t maxValueDeltaSize = 10;
+
+inline uint32_t ulebSize(uint64_t value)
+{
+    uint32_t result = 0;
+    do {
+        value = value >> 7;
+        ++result;
+    } while ( value != 0 );
+    return result;
+}
+
+inline uint32_t slebSize(int64_t value)
+{
+    uint32_t result = 0;
+    bool more = true;
+    while ( more ) {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        more = !(((value == 0) && ((byte & 0x40) == 0)) || ((value == -1) && ((byte & 0x40) != 0)));
+        ++result;
+    }
+    return result;
+}
+
+inline uint8_t* writeUleb(uint8_t* p, uint64_t value)
+{
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        if ( value != 0 )
+            byte |= 0x80;
+        *p++ = byte;
+    } while ( value != 0 );
+    return p;
+}
+
+inline uint8_t* writeSleb(uint8_t* p, int64_t value)
+{
+    bool more = true;
+    while ( more ) {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        more = !(((value == 0) && ((byte & 0x40) == 0)) || ((value == -1) && ((byte & 0x40) != 0)));
+        if ( more )
+            byte |= 0x80;
+        *p++ = byte;
+    }
+    return p;
+}
+
+inline bool readUleb(const uint8_t*& p, const uint8_t* end, uint64_t& value)
+{
+    value = 0;
+    uint32_t bit = 0;
+    while ( p != end ) {
+        uint8_t byte = *p++;
+        if ( bit > 63 )
+            return false;
+        value |= ((uint64_t)(byte & 0x7F) << bit);
+        bit += 7;
+        if ( (byte & 0x80) == 0 )
+            return true;
+    }
+    return false;
+}
+
+inline bool readSleb(const uint8_t*& p, const uint8_t* end, int64_t& value)
+{
+    value = 0;
+    uint32_t bit = 0;
+    while ( p != end ) {
+        uint8_t byte = *p++;
+        if ( bit > 63 )
+            return false;
+        value |= ((int64_t)(byte & 0x7F) << bit);
+        bit += 7;
+        if ( (byte & 0x80) == 0 ) {
+            // sign extend negative numbers
+            if ( ((byte & 0x40) != 0) && (bit < 64) )
+                value |= (~0ULL) << bit;
+            return true;
+        }
+    }
+    return false;
+}
+
+inline size_t sharedPrefixLength(std::string_view a, std::string_view b)
+{
+    size_t length = std::min(a.size(), b.size());
+    size_t i = 0;
+    while ( (i != length) && (a[i] == b[i]) )
+        ++i;
+    return i;
+}
+
+// Returns the number of bytes 'sym' encodes to when it follows 'prev' in a block.
+// Use a default constructed Symbol as 'prev' for the first symbol in a block
+inline uint32_t encodedSize(const Symbol& prev, const Symbol& sym)
+{
+    size_t prefixLength = sharedPrefixLength(prev.name, sym.name);
+    size_t suffixLength = sym.name.size() - prefixLength;
+    return slebSize((int64_t)(sym.value - prev.value)) + 2 + ulebSize(sym.desc)
+            + ulebSize(prefixLength) + ulebSize(suffixLength) + (uint32_t)suffixLength;
+}
+
+// Writes 'sym' at 'p' and returns the end of what was written
+inline uint8_t* encode(uint8_t* p, const Symbol& prev, const Symbol& sym)
+{
+    size_t prefixLength = sharedPrefixLength(prev.name, sym.name);
+    size_t suffixLength = sym.name.size() - prefixLength;
+    p = writeSleb(p, (int64_t)(sym.value - prev.value));
+    *p++ = sym.type;
+    *p++ = sym.sect;
+    p = writeUleb(p, sym.desc);
+    p = writeUleb(p, prefixLength);
+    p = writeUleb(p, suffixLength);
+    memcpy(p, sym.name.data() + prefixLength, suffixLength);
+    return p + suffixLength;
+}
+
+// Returns the compact header if the local symbols info uses the compact format, or nullptr if it uses the nlist format
+inline const dyld_cache_local_symbols_compact_info* compactInfo(const dyld_cache_local_symbols_info* localInfo)
+{
+    // Compact info always has empty nlist and entries, and its entries start after the compact header
+    if ( (localInfo->nlistCount != 0) || (localInfo->entriesCount != 0) )
+        return nullptr;
+    if ( localInfo->entriesOffset < sizeof(dyld_cache_local_symbols_compact_info) )
+        return nullptr;
+
+    const auto* info = (const dyld_cache_local_symbols_compact_info*)localInfo;
+    if ( (info->magic != DYLD_CACHE_LOCAL_SYMBOLS_COMPACT_MAGIC) || (info->version != DYLD_CACHE_LOCAL_SYMBOLS_COMPACT_VERSION) )
+        return nullptr;
+    return info;
+}
+
+inline std::span<const dyld_cache_local_symbols_compact_entry> blocks(const dyld_cache_local_symbols_compact_info* info)
+{
+    const auto* entries = (const dyld_cache_local_symbols_compact_entry*)((const uint8_t*)info + info->blocksOffset);
+    return { entries, info->blocksCount };
+}
+
+// Blocks are sorted by dylib offset, so this is a binary search
+inline const dyld_cache_local_symbols_compact_entry* findBlock(const dyld_cache_local_symbols_compact_info* info, uint64_t dylibOffset)
+{
+    std::span<const dyld_cache_local_symbols_compact_entry> entries = blocks(info);
+    auto it = std::lower_bound(entries.begin(), entries.end(), dylibOffset, [](const dyld_cache_local_symbols_compact_entry& entry, uint64_t offset) {
+        return entry.dylibOffset < offset;
+    });
+    if ( (it == entries.end()) || (it->dylibOffset != dylibOffset) )
+        return nullptr;
+    return &*it;
+}
+
+// Decodes each symbol in the block.  'nameBuffer' must have room for entry.maxNameLength + 1 chars.
+// Returns false if the block is malformed.  Only the symbols before the malformed one are passed to the handler
+inline bool forEachSymbol(const dyld_cache_local_symbols_compact_info* info, const dyld_cache_local_symbols_compact_entry& entry,
+                          char* nameBuffer,
+                          void (^handler)(const char* name, uint64_t n_value, uint8_t n_type, uint8_t n_sect, uint16_t n_desc, bool& stop))
+{
+    const uint8_t* p   = (const uint8_t*)info + entry.dataOffset;
+    const uint8_t* end = p + entry.dataSize;
+    uint64_t value      = 0;
+    uint64_t nameLength = 0;
+    bool     stop       = false;
+    for ( uint32_t i = 0; (i != entry.symbolCount) && !stop; ++i ) {
+        int64_t  valueDelta;
+        uint64_t desc;
+        uint64_t prefixLength;
+        uint64_t suffixLength;
+        if ( !readSleb(p, end, valueDelta) )
+            return false;
+        if ( (end - p) < 2 )
+            return false;
+        uint8_t type = *p++;
+        uint8_t sect = *p++;
+        if ( !readUleb(p, end, desc) || !readUleb(p, end, prefixLength) || !readUleb(p, end, suffixLength) )
+            return false;
+        if ( (prefixLength > nameLength) || (suffixLength > (uint64_t)(end - p)) || ((prefixLength + suffixLength) > entry.maxNameLength) )
+            return false;
+
+        memcpy(nameBuffer + prefixLength, p, suffixLength);
+        p += suffixLength;
+        nameLength = prefixLength + suffixLength;
+        nameBuffer[nameLength] = '\0';
+        value += valueDelta;
+        handler(nameBuffer, value, type, sect, (uint16_t)desc, stop);
+    }
+    return true;
+}
+
+// Decodes the block in to a temporary nlist and string table, for clients which want the nlist format.
+// NListType is struct nlist or struct nlist_64
+template<typename NListType>
+inline bool withNLists(const dyld_cache_local_symbols_compact_info* info, const dyld_cache_local_symbols_compact_entry& entry,
+                       void (^reader)(const NListType* nlists, uint32_t nlistCount, const char* strings))
+{
+    char* nameBuffer = (char*)malloc(entry.maxNameLength + 1);
+
+    // Size the string table first, so that we only allocate once
+    __block size_t stringsSize = 1;
+    bool valid = forEachSymbol(info, entry, nameBuffer, ^(const char* name, uint64_t, uint8_t, uint8_t, uint16_t, bool&) {
+        stringsSize += strlen(name) + 1;
+    });
+
+    if ( valid ) {
+        NListType* nlists  = (NListType*)calloc(entry.symbolCount, sizeof(NListType));
+        char*      strings = (char*)malloc(stringsSize);
+        strings[0] = '\0';
+
+        __block uint32_t nlistCount   = 0;
+        __block uint32_t stringOffset = 1;
+        forEachSymbol(info, entry, nameBuffer, ^(const char* name, uint64_t n_value, uint8_t n_type, uint8_t n_sect, uint16_t n_desc, bool&) {
+            NListType& nlist = nlists[nlistCount++];
+            nlist.n_un.n_strx = stringOffset;
+            nlist.n_type      = n_type;
+            nlist.n_sect      = n_sect;
+            nlist.n_desc      = n_desc;
+            nlist.n_value     = (decltype(nlist.n_value))n_value;
+
+            size_t nameSize = strlen(name) + 1;
+            memcpy(strings + stringOffset, name, nameSize);
+            stringOffset += (uint32_t)nameSize;
+        });
+
+        reader(nlists, nlistCount, strings);
+
+        free(strings);
+        free(nlists);
+    }
+
+    free(nameBuffer);
+    return valid;
+}
+
+} // namespace compact_local_symbols
+
+#endif /* CompactLocalSymbols_h */
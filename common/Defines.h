@@ -156,7 +156,9 @@ static_assert((DYLD_FEATURE_SIMULATOR_NOTIFICATION_HOST_SUPPORT && DYLD_FEATURE_
 // 1. We are building dyld, since most of the time we only allocate 2-3 pages and we can hand pack a bunch of virtual address spacew
 // OR
 // 2. We are running anything on 32 bit hardware where we have limited address space
+#ifndef ALLOCATOR_DEFAULT_POOL_SIZE
 #define ALLOCATOR_DEFAULT_POOL_SIZE (128*1024)
+#endif
 
 // Exclaves does not have access to vm_allocate, but it also use a smaller fixed set of libraries, so dyld can embed a simple page allocator as a replacement
 #if TARGET_OS_EXCLAVEKIT
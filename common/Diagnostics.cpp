@@ -46,16 +46,6 @@
   dispatch_queue_t sWarningQueue = dispatch_queue_create("com.apple.dyld.cache-builder.warnings", NULL);
 #endif
 
-Diagnostics::Diagnostics(bool verbose)
-#if BUILDING_CACHE_BUILDER || BUILDING_UNIT_TESTS || BUILDING_CACHE_BUILDER_UNIT_TESTS
-    : _prefix(""), _verbose(verbose)
-#endif
-{
-#if TARGET_OS_EXCLAVEKIT
-    _strBuf[0] = '\0';
-#endif
-}
-
 #if BUILDING_CACHE_BUILDER || BUILDING_UNIT_TESTS || BUILDING_CACHE_BUILDER_UNIT_TESTS
 Diagnostics::Diagnostics(const std::string& prefix, bool verbose)
     : _prefix(prefix),_verbose(verbose)
@@ -63,11 +53,6 @@ Diagnostics::Diagnostics(const std::string& prefix, bool verbose)
 }
 #endif
 
-Diagnostics::~Diagnostics()
-{
-    clearError();
-}
-
 void Diagnostics::error(const char* format, ...)
 {
     va_list    list;
@@ -116,24 +101,6 @@ void Diagnostics::error(const char* format, va_list_wrap vaWrap)
 //#endif
  }
 
-bool Diagnostics::hasError() const
-{
-#if TARGET_OS_EXCLAVEKIT
-    return (*_strBuf != '\0');
-#else
-    return _buffer != nullptr;
-#endif
-}
-
-bool Diagnostics::noError() const
-{
-#if TARGET_OS_EXCLAVEKIT
-    return (*_strBuf == '\0');
-#else
-    return _buffer == nullptr;
-#endif
-}
-
 void Diagnostics::clearError()
 {
 //#if TARGET_OS_EXCLAVEKIT
@@ -45,8 +45,16 @@
 class VIS_HIDDEN Diagnostics
 {
 public:
-                    Diagnostics(bool verbose=false);
-                    ~Diagnostics();
+    // Construction and destruction are inline and never allocate.  Only the first error allocates
+    // a message buffer, so a Diagnostics per dylib or per symbol costs nothing on the success path
+#if BUILDING_CACHE_BUILDER || BUILDING_UNIT_TESTS || BUILDING_CACHE_BUILDER_UNIT_TESTS
+                    Diagnostics(bool verbose=false) : _verbose(verbose) { }
+#elif TARGET_OS_EXCLAVEKIT
+                    Diagnostics(bool verbose=false) { _strBuf[0] = '\0'; }
+#else
+                    Diagnostics(bool verbose=false) { }
+#endif
+                    ~Diagnostics() { if ( hasError() ) clearError(); }
 
     void            error(const char* format, ...)  __attribute__((format(printf, 2, 3)));
     void            error(const char* format, va_list_wrap vaWrap) __attribute__((format(printf, 2, 0)));
@@ -59,8 +67,13 @@ public:
     void            copy(const Diagnostics&);
 #endif
 
-    bool            hasError() const;
-    bool            noError() const;
+#if TARGET_OS_EXCLAVEKIT
+    bool            hasError() const { return (*_strBuf != '\0'); }
+    bool            noError() const  { return (*_strBuf == '\0'); }
+#else
+    bool            hasError() const { return (_buffer != nullptr); }
+    bool            noError() const  { return (_buffer == nullptr); }
+#endif
     void            clearError();
     void            assertNoError() const;
     bool            errorMessageContains(const char* subString) const;
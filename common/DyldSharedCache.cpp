@@ -52,6 +52,7 @@
 #define NO_ULEB
 #include "MachOLoaded.h"
 #include "DyldSharedCache.h"
+#include "CompactLocalSymbols.h"
 #include "Header.h"
 #include "Trie.hpp"
 #include "StringUtils.h"
@@ -116,6 +117,25 @@ void DyldSharedCache::forEachPrewarmingEntry(void (^handler)(const void* content
     }
 }
 
+bool DyldSharedCache::exportFilter(uint32_t imageIndex, const uint64_t*& words, uint32_t& wordCount) const
+{
+    // check for old cache, or a cache built without filters
+    if ( (header.mappingOffset <= offsetof(dyld_cache_header, exportFiltersSize)) || (header.exportFiltersAddr == 0) )
+        return false;
+
+    const dyld_cache_export_filters* filters = (const dyld_cache_export_filters*)((const uint8_t*)this + (header.exportFiltersAddr - this->unslidLoadAddress()));
+    if ( (filters->version != 1) || (imageIndex >= filters->count) )
+        return false;
+
+    const dyld_cache_export_filter_entry& entry = filters->entries[imageIndex];
+    if ( entry.wordsOffset == 0 )
+        return false;
+
+    words     = (const uint64_t*)((const uint8_t*)filters + entry.wordsOffset);
+    wordCount = entry.wordCount;
+    return true;
+}
+
 const char* DyldSharedCache::mappingName(uint32_t maxProt, uint64_t flags)
 {
     if ( maxProt & VM_PROT_EXECUTE ) {
@@ -1058,6 +1078,8 @@ void DyldSharedCache::forEachLocalSymbolEntry(void (^handler)(uint64_t dylibOffs
         for (uint32_t i = 0; i < localInfo->entriesCount; i++) {
             const dyld_cache_local_symbols_entry_64& localEntry = localEntries[i];
             handler(localEntry.dylibOffset, localEntry.nlistStartIndex, localEntry.nlistCount, stop);
+            if ( stop )
+                break;
         }
     } else {
         // On old caches, the dylibOffset is 64-bits, and is a file offset
@@ -1067,10 +1089,39 @@ void DyldSharedCache::forEachLocalSymbolEntry(void (^handler)(uint64_t dylibOffs
         for (uint32_t i = 0; i < localInfo->entriesCount; i++) {
             const dyld_cache_local_symbols_entry& localEntry = localEntries[i];
             handler(localEntry.dylibOffset, localEntry.nlistStartIndex, localEntry.nlistCount, stop);
+            if ( stop )
+                break;
         }
     }
 }
 
+const dyld_cache_local_symbols_compact_info* DyldSharedCache::getCompactLocalSymbolsInfo() const
+{
+    // check for cache without local symbols info
+    if (!this->hasLocalSymbolsInfo())
+        return nullptr;
+    const auto localInfo = (dyld_cache_local_symbols_info*)((uintptr_t)this + header.localSymbolsOffset);
+    return compact_local_symbols::compactInfo(localInfo);
+}
+
+#if !(BUILDING_LIBDYLD || BUILDING_DYLD)
+bool DyldSharedCache::forEachCompactLocalSymbol(uint64_t dylibCacheVMOffset,
+                                                void (^handler)(const char* name, uint64_t n_value, uint8_t n_type,
+                                                                uint8_t n_sect, uint16_t n_desc, bool& stop)) const
+{
+    const dyld_cache_local_symbols_compact_info* compactInfo = getCompactLocalSymbolsInfo();
+    if ( compactInfo == nullptr )
+        return false;
+
+    const dyld_cache_local_symbols_compact_entry* block = compact_local_symbols::findBlock(compactInfo, dylibCacheVMOffset);
+    if ( block == nullptr )
+        return false;
+
+    std::vector<char> nameBuffer(block->maxNameLength + 1);
+    return compact_local_symbols::forEachSymbol(compactInfo, *block, nameBuffer.data(), handler);
+}
+#endif // !(BUILDING_LIBDYLD || BUILDING_DYLD)
+
 bool DyldSharedCache::addressInText(uint64_t cacheOffset, uint32_t* imageIndex) const
 {
     const dyld_cache_mapping_info* mappings = (dyld_cache_mapping_info*)((char*)this + header.mappingOffset);
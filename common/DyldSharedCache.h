@@ -442,9 +442,27 @@ public:
 
      //
      // Iterates over each local symbol entry in the cache
+     // Note, caches using the compact local symbols format have no entries.  Use forEachCompactLocalSymbol() for those
      //
      void                forEachLocalSymbolEntry(void (^handler)(uint64_t dylibCacheVMOffset, uint32_t nlistStartIndex, uint32_t nlistCount, bool& stop)) const;
 
+
+    //
+    // Get the compact local symbols info, or nullptr if the local symbols use the nlist format
+    //
+    const dyld_cache_local_symbols_compact_info* getCompactLocalSymbolsInfo() const;
+
+
+#if !(BUILDING_LIBDYLD || BUILDING_DYLD)
+    //
+    // Iterates over the local symbols for one dylib, in a cache using the compact format
+    // Only the block for that dylib is decoded.  Returns false if the dylib has no block, or the block is malformed
+    //
+    bool                forEachCompactLocalSymbol(uint64_t dylibCacheVMOffset,
+                                                  void (^handler)(const char* name, uint64_t n_value, uint8_t n_type,
+                                                                  uint8_t n_sect, uint16_t n_desc, bool& stop)) const;
+#endif
+
     //
     // Returns if an address range is in this cache, and if so if in an immutable area
     //
@@ -510,6 +528,11 @@ public:
     //
     void                forEachPrewarmingEntry(void (^handler)(const void* content, uint64_t unslidVMAddr, uint64_t vmSize)) const;
 
+    //
+    // Returns the bloom filter of the names in the exports trie of the dylib at imageIndex (see ExportBloomFilter.h)
+    //
+    bool                exportFilter(uint32_t imageIndex, const uint64_t*& words, uint32_t& wordCount) const;
+
     //
     // Iterates over function variant pointers in the dyld cache
     //
@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2025 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef ExportBloomFilter_h
+#define ExportBloomFilter_h
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "Defines.h"
+
+//
+// A bloom filter of every name in a dylib's exports trie, including re-exports.  Symbol lookups which follow
+// re-exports probe it before walking the trie, so that dylibs which cannot have the symbol cost a hash and three
+// bit tests.  A false positive only costs the trie walk which would have happened anyway.
+//
+// The filter is a power of two count of 64-bit words, with about 10 bits per name, which gives roughly a 1% false
+// positive rate.  The shared cache builder emits the same layout in dyld_cache_export_filters, so any change
+// to the hashing needs a new version there.
+//
+struct VIS_HIDDEN ExportBloomFilter
+{
+    static const uint32_t kBitsPerName  = 10;
+    static const uint32_t kProbeCount   = 3;
+
+    // number of words needed for a filter of 'nameCount' names
+    static uint32_t wordCountFor(uint64_t nameCount)
+    {
+        uint64_t neededWords = ((nameCount * kBitsPerName) + 63) / 64;
+        uint32_t wordCount   = 1;
+        while ( (wordCount < neededWords) && (wordCount < (1U << 30)) )
+            wordCount <<= 1;
+        return wordCount;
+    }
+
+    static void add(uint64_t* words, uint32_t wordCount, const char* name)
+    {
+        uint64_t hash   = hashName(name);
+        uint32_t h1     = (uint32_t)hash;
+        uint32_t h2     = (uint32_t)(hash >> 32) | 1;
+        uint64_t mask   = ((uint64_t)wordCount * 64) - 1;
+        for ( uint32_t i = 0; i != kProbeCount; ++i ) {
+            uint64_t bit = (h1 + (uint64_t)i * h2) & mask;
+            words[bit / 64] |= (1ULL << (bit % 64));
+        }
+    }
+
+    static bool mayContain(const uint64_t* words, uint32_t wordCount, const char* name)
+    {
+        uint64_t hash   = hashName(name);
+        uint32_t h1     = (uint32_t)hash;
+        uint32_t h2     = (uint32_t)(hash >> 32) | 1;
+        uint64_t mask   = ((uint64_t)wordCount * 64) - 1;
+        for ( uint32_t i = 0; i != kProbeCount; ++i ) {
+            uint64_t bit = (h1 + (uint64_t)i * h2) & mask;
+            if ( (words[bit / 64] & (1ULL << (bit % 64))) == 0 )
+                return false;
+        }
+        return true;
+    }
+
+    // Calls the handler with the name of every terminal node in the trie.  Returns false if the trie is malformed,
+    // or too deep or too large to walk, in which case no filter should be made as it might miss names
+    static bool forEachTrieName(const uint8_t* trieStart, const uint8_t* trieEnd, void (^handler)(const char* name))
+    {
+        struct Frame
+        {
+            const uint8_t*  nextChild;
+            uint32_t        childrenLeft;
+            uint32_t        nameLength;
+        };
+        if ( trieStart == trieEnd )
+            return true;
+
+        char            name[kMaxNameLength];
+        Frame           stack[kMaxDepth];
+        uint32_t        depth       = 0;
+        uint32_t        nameLength  = 0;
+        uint64_t        nodesLeft   = (uint64_t)(trieEnd - trieStart);  // bounds the walk if child offsets loop back
+        const uint8_t*  node        = trieStart;
+        while ( true ) {
+            name[nameLength] = '\0';
+            uint64_t       terminalSize;
+            const uint8_t* p = node;
+            if ( (nodesLeft-- == 0) || !readUleb(p, trieEnd, terminalSize) || (terminalSize >= (uint64_t)(trieEnd - p)) )
+                return false;
+            if ( terminalSize != 0 )
+                handler(name);
+            p += terminalSize;
+            if ( depth == kMaxDepth )
+                return false;
+            stack[depth++] = { p + 1, *p, nameLength };
+
+            // move on to the next child not yet visited, popping nodes which have none left
+            node = nullptr;
+            while ( (node == nullptr) && (depth != 0) ) {
+                Frame& frame = stack[depth - 1];
+                if ( frame.childrenLeft == 0 ) {
+                    --depth;
+                    continue;
+                }
+                --frame.childrenLeft;
+                nameLength = frame.nameLength;
+                const uint8_t* s = frame.nextChild;
+                while ( (s < trieEnd) && (*s != '\0') ) {
+                    if ( nameLength == kMaxNameLength - 1 )
+                        return false;
+                    name[nameLength++] = (char)*s++;
+                }
+                if ( s >= trieEnd )
+                    return false;
+                ++s;
+                uint64_t childOffset;
+                if ( !readUleb(s, trieEnd, childOffset) || (childOffset == 0) || (childOffset >= (uint64_t)(trieEnd - trieStart)) )
+                    return false;
+                frame.nextChild = s;
+                node            = trieStart + childOffset;
+            }
+            if ( node == nullptr )
+                return true;
+        }
+    }
+
+private:
+    static const uint32_t kMaxNameLength    = 4096;
+    static const uint32_t kMaxDepth         = 256;
+
+    // FNV-1a, with a final mix so that the low and high halves are both usable as independent hashes
+    static uint64_t hashName(const char* name)
+    {
+        uint64_t hash = 0xcbf29ce484222325ULL;
+        for ( const char* s = name; *s != '\0'; ++s ) {
+            hash ^= (uint8_t)*s;
+            hash *= 0x100000001b3ULL;
+        }
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+
+    static bool readUleb(const uint8_t*& p, const uint8_t* end, uint64_t& value)
+    {
+        value = 0;
+        for ( uint32_t bit = 0; (p < end) && (bit < 64); bit += 7 ) {
+            uint8_t byte = *p++;
+            value |= ((uint64_t)(byte & 0x7F) << bit);
+            if ( (byte & 0x80) == 0 )
+                return true;
+        }
+        return false;
+    }
+};
+
+#endif /* ExportBloomFilter_h */
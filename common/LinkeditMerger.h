@@ -0,0 +1,148 @@
+/*
+ * Copyright (c) 2025 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef LinkeditMerger_h
+#define LinkeditMerger_h
+
+#include <assert.h>
+#include <stdint.h>
+#include <string.h>
+#include <dispatch/dispatch.h>
+
+#include <bit>
+#include <vector>
+
+#include "Defines.h"
+
+//
+// Merges pieces of LINKEDIT from many images in to one buffer.  This is done in two passes:
+//  - layout(), which assigns every piece an offset by prefix summing the sizes of the pieces
+//    before it.  Pieces are grouped in to regions, eg, all the bind opcodes, laid out in order
+//  - copy(), which copies the pieces in to place.  As every piece has its own offset by now,
+//    this is done in parallel
+// Pieces which can't just be memcpy()ed, eg, ones which need their contents rewritten, are added
+// without a source, and filled in by the caller with forEachPiece(), which is also parallel.
+//
+// This is header only as it is used by both the kernel collection builder and the shared cache
+// builder, which don't share a common library.
+//
+class VIS_HIDDEN LinkeditMerger
+{
+public:
+    typedef uint32_t RegionIndex;
+
+    // Adds a region after all the existing regions.  The region starts at a multiple of 'alignment'
+    RegionIndex addRegion(const char* name, uint32_t alignment = 1)
+    {
+        assert(std::has_single_bit(alignment));
+        _regions.push_back({ name, alignment, 0, 0, {} });
+        return (RegionIndex)(_regions.size() - 1);
+    }
+
+    // Adds 'size' bytes to the end of the region.  If 'source' is set, copy() will memcpy() from it,
+    // otherwise the caller fills in the piece.  If 'newOffset' is set, layout() stores the offset of
+    // the piece there
+    void addPiece(RegionIndex regionIndex, const void* source, uint64_t size, uint32_t* newOffset = nullptr)
+    {
+        assert(!_laidOut);
+        _regions[regionIndex].pieces.push_back({ (const uint8_t*)source, size, 0, newOffset });
+    }
+
+    // Pass 1: assigns an offset to every region and piece, starting at 'startOffset'.  Returns the end offset
+    uint64_t layout(uint64_t startOffset = 0)
+    {
+        uint64_t offset = startOffset;
+        for ( Region& region : _regions ) {
+            offset = (offset + region.alignment - 1) & ~((uint64_t)region.alignment - 1);
+            region.offset = offset;
+            for ( Piece& piece : region.pieces ) {
+                piece.offset = offset;
+                if ( piece.newOffset != nullptr )
+                    *piece.newOffset = (uint32_t)offset;
+                offset += piece.size;
+            }
+            region.size = offset - region.offset;
+        }
+        _laidOut = true;
+        return offset;
+    }
+
+    // Pass 2: copies every piece with a source in to 'buffer', in parallel
+    void copy(uint8_t* buffer) const
+    {
+        assert(_laidOut);
+        std::vector<const Piece*> pieces;
+        for ( const Region& region : _regions ) {
+            for ( const Piece& piece : region.pieces ) {
+                if ( (piece.source != nullptr) && (piece.size != 0) )
+                    pieces.push_back(&piece);
+            }
+        }
+
+        const Piece* const* piecesArray = pieces.data();
+        dispatch_apply(pieces.size(), DISPATCH_APPLY_AUTO, ^(size_t index) {
+            const Piece& piece = *piecesArray[index];
+            ::memcpy(buffer + piece.offset, piece.source, (size_t)piece.size);
+        });
+    }
+
+    // Calls the handler in parallel for each piece in the region, with where the piece lives in 'buffer'
+    void forEachPiece(RegionIndex regionIndex, uint8_t* buffer,
+                      void (^handler)(size_t pieceIndex, uint8_t* content, uint64_t size)) const
+    {
+        assert(_laidOut);
+        const Region& region = _regions[regionIndex];
+        dispatch_apply(region.pieces.size(), DISPATCH_APPLY_AUTO, ^(size_t index) {
+            const Piece& piece = region.pieces[index];
+            handler(index, buffer + piece.offset, piece.size);
+        });
+    }
+
+    const char* regionName(RegionIndex regionIndex) const               { return _regions[regionIndex].name; }
+    uint64_t    regionOffset(RegionIndex regionIndex) const             { return _regions[regionIndex].offset; }
+    uint64_t    regionSize(RegionIndex regionIndex) const               { return _regions[regionIndex].size; }
+    uint64_t    pieceOffset(RegionIndex regionIndex, size_t pieceIndex) const { return _regions[regionIndex].pieces[pieceIndex].offset; }
+
+private:
+    struct Piece
+    {
+        const uint8_t*  source;
+        uint64_t        size;
+        uint64_t        offset;
+        uint32_t*       newOffset;
+    };
+
+    struct Region
+    {
+        const char*         name;
+        uint32_t            alignment;
+        uint64_t            offset;
+        uint64_t            size;
+        std::vector<Piece>  pieces;
+    };
+
+    std::vector<Region> _regions;
+    bool                _laidOut = false;
+};
+
+#endif /* LinkeditMerger_h */
@@ -26,6 +26,8 @@
 
 #if !TARGET_OS_EXCLAVEKIT
 
+#include <algorithm>
+
 #include "MetadataVisitor.h"
 
 #if SUPPORT_VM_LAYOUT
@@ -175,6 +177,8 @@ Visitor::Visitor(CacheVMAddress cacheBaseAddress, const dyld3::MachOFile* dylibM
     for ( const Segment& segment : this->segments ) {
         assert(!segment.onDiskDylibChainedPointerFormat.has_value());
     }
+
+    buildSegmentLookup();
 }
 
 // On disk dylib/executable
@@ -191,6 +195,56 @@ Visitor::Visitor(VMAddress chainedPointerBaseAddress, const dyld3::MachOFile* dy
     for ( const Segment& segment : this->segments ) {
         assert(segment.onDiskDylibChainedPointerFormat.has_value());
     }
+
+    buildSegmentLookup();
+}
+
+void Visitor::buildSegmentLookup()
+{
+    // Skip segments which don't contribute to the cache.  This is a hack to account
+    // for LINKEDIT, which doesn't really get its own buffer.  We don't want to match
+    // an address to LINKEDIT, when we actually wanted to find it in the selector strings
+    // "segment" we also track here
+    this->segmentRanges.reserve(this->segments.size());
+    for ( uint32_t i = 0; i != this->segments.size(); ++i ) {
+        const Segment& segment = this->segments[i];
+        if ( segment.bufferStart == nullptr )
+            continue;
+        this->segmentRanges.push_back({ segment.startVMAddr, segment.endVMAddr, i });
+    }
+
+    std::sort(this->segmentRanges.begin(), this->segmentRanges.end(),
+              [](const SegmentRange& a, const SegmentRange& b) {
+        return a.startVMAddr < b.startVMAddr;
+    });
+
+    // The binary search relies on the ranges being disjoint.  If they aren't, then clear the table and
+    // getValueFor() will fall back to searching the segments in order, as it has always done
+    for ( uint32_t i = 1; i < this->segmentRanges.size(); ++i ) {
+        if ( this->segmentRanges[i].startVMAddr < this->segmentRanges[i - 1].endVMAddr ) {
+            this->segmentRanges.clear();
+            break;
+        }
+    }
+}
+
+const Visitor::SegmentRange* Visitor::findSegmentRange(VMAddress vmAddr) const
+{
+    if ( this->segmentRanges.empty() )
+        return nullptr;
+
+    // Find the first range which starts after the address, then the range before it is the candidate
+    auto it = std::upper_bound(this->segmentRanges.begin(), this->segmentRanges.end(), vmAddr,
+                               [](const VMAddress& addr, const SegmentRange& range) {
+        return addr < range.startVMAddr;
+    });
+    if ( it == this->segmentRanges.begin() )
+        return nullptr;
+    --it;
+    if ( !(vmAddr < it->endVMAddr) )
+        return nullptr;
+
+    return &*it;
 }
 
 #endif
@@ -250,6 +304,12 @@ ResolvedValue Visitor::getValueFor(VMAddress vmAddr) const
     const void* valueInDylib = (const uint8_t*)this->dylibMA + offsetInDylib.rawValue();
     return ResolvedValue(valueInDylib, vmAddr);
 #else
+    if ( const SegmentRange* range = this->findSegmentRange(vmAddr) ) {
+        const Segment& cacheSegment = this->segments[range->segmentsIndex];
+        VMOffset segmentVMOffset = vmAddr - cacheSegment.startVMAddr;
+        return ResolvedValue(cacheSegment, segmentVMOffset);
+    }
+
     // Find the segment containing the target address
     for ( const Segment& cacheSegment : segments ) {
         if ( (vmAddr >= cacheSegment.startVMAddr) && (vmAddr < cacheSegment.endVMAddr) ) {
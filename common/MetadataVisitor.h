@@ -199,6 +199,20 @@ protected:
     std::vector<Segment>        segments;
     std::vector<uint64_t>       bindTargets;
     std::optional<VMAddress>    selectorStringsBaseAddress;
+
+    // getValueFor() is called for every pointer we chase, so instead of searching the segments
+    // list each time, we keep the segments with buffers sorted by address and binary search them.
+    // The table is only written by the constructor, so lookups are safe from multiple threads
+    struct SegmentRange
+    {
+        VMAddress               startVMAddr;
+        VMAddress               endVMAddr;
+        uint32_t                segmentsIndex;
+    };
+    std::vector<SegmentRange>   segmentRanges;
+
+    void                        buildSegmentLookup();
+    const SegmentRange*         findSegmentRange(VMAddress vmAddr) const;
 #endif
 
 #if POINTERS_ARE_UNSLID
@@ -64,6 +64,7 @@
 #include "objc-shared-cache.h"
 #include "DyldAPIs.h"
 #include "JustInTimeLoader.h"
+#include "PathProbeCache.h"
 #include "Utilities.h"
 
 #include "Header.h"
@@ -246,9 +247,9 @@ static uint32_t normalizeImageIndex(const ProcessConfig& config, uint32_t index)
 const mach_header* APIs::_dyld_get_image_header(uint32_t imageIndex)
 {
     __block const mach_header* result = 0;
-    locks.withLoadersReadLock(^{
-        if ( imageIndex < loaded.size() )
-            result = loaded[normalizeImageIndex(config, imageIndex)]->loadAddress(*this);
+    withLoadedImages(^(std::span<const Loader* const> images) {
+        if ( imageIndex < images.size() )
+            result = images[normalizeImageIndex(config, imageIndex)]->loadAddress(*this);
     });
     if ( config.log.apis )
         log("_dyld_get_image_header(%u) => %p\n", imageIndex, result);
@@ -279,9 +280,9 @@ intptr_t APIs::_dyld_get_image_slide(const mach_header* mh)
 intptr_t APIs::_dyld_get_image_vmaddr_slide(uint32_t imageIndex)
 {
     __block intptr_t result = 0;
-    locks.withLoadersReadLock(^{
-        if ( imageIndex < loaded.size() )
-            result = loaded[normalizeImageIndex(config, imageIndex)]->loadAddress(*this)->getSlide();
+    withLoadedImages(^(std::span<const Loader* const> images) {
+        if ( imageIndex < images.size() )
+            result = images[normalizeImageIndex(config, imageIndex)]->loadAddress(*this)->getSlide();
     });
     if ( config.log.apis )
         log("_dyld_get_image_vmaddr_slide(%u) => 0x%lX\n", imageIndex, result);
@@ -291,9 +292,9 @@ intptr_t APIs::_dyld_get_image_vmaddr_slide(uint32_t imageIndex)
 const char* APIs::_dyld_get_image_name(uint32_t imageIndex)
 {
     __block const char* result = 0;
-    locks.withLoadersReadLock(^{
-        if ( imageIndex < loaded.size() )
-            result = loaded[normalizeImageIndex(config, imageIndex)]->path(*this);
+    withLoadedImages(^(std::span<const Loader* const> images) {
+        if ( imageIndex < images.size() )
+            result = images[normalizeImageIndex(config, imageIndex)]->path(*this);
     });
     if ( config.log.apis )
         log("_dyld_get_image_name(%u) => %s\n", imageIndex, result);
@@ -976,9 +977,9 @@ bool APIs::findImageMappedAt(const void* addr, const MachOLoaded** ml, bool* nev
     }
 
     // slow path - search image list
-    locks.withLoadersReadLock(^{
+    withLoadedImages(^(std::span<const Loader* const> images) {
         // If we found a cache range for this address, then we know we only need to look in loaders for the cache
-        for ( const Loader* image : loaded ) {
+        for ( const Loader* image : images ) {
             if ( image->dylibInDyldCache != inSharedCache )
                 continue;
             const void* sgAddr;
@@ -1270,8 +1271,8 @@ const Loader* APIs::findImageContaining(const void* addr)
 {
     addr                         = (void*)stripPointer(addr);
     __block const Loader* result = nullptr;
-    locks.withLoadersReadLock(^{
-        for ( const dyld4::Loader* image : loaded ) {
+    withLoadedImages(^(std::span<const Loader* const> images) {
+        for ( const dyld4::Loader* image : images ) {
             const void* sgAddr;
             uint64_t    sgSize;
             uint8_t     sgPerm;
@@ -1362,6 +1363,12 @@ void* APIs::dlopen_from(const char* path, int mode, void* addressInCaller)
             const uint64_t startPatchedObjCClassesCount = this->patchedObjCClasses.size();
             const uint64_t startPatchedSingletonsCount = this->patchedSingletons.size();
             Diagnostics     diag;
+            PathProbeCache::Scope pathProbeScope(*this);
+
+            // lock-free readers of the loaded images fall back to the lock until this dlopen is done changing them
+            const bool changesLoaded = ((mode & RTLD_NOLOAD) == 0);
+            if ( changesLoaded )
+                this->invalidateLoadedSnapshot();
 
             // try to load specified dylib
             Loader::LoadChain   loadChainMain { nullptr, mainExecutableLoader };
@@ -1389,6 +1396,8 @@ void* APIs::dlopen_from(const char* path, int mode, void* addressInCaller)
             topLoader = Loader::getLoader(diag, *this, path, options);
             if ( topLoader == nullptr ) {
                 setErrorString("dlopen(%s, 0x%04X): %s", path, mode, diag.errorMessageCStr());
+                if ( changesLoaded )
+                    this->publishLoadedSnapshot();
                 return;
             }
 
@@ -1572,6 +1581,9 @@ void* APIs::dlopen_from(const char* path, int mode, void* addressInCaller)
                 doSingletonPatching(cacheDataConst);
                 notifyObjCPatching();
             }
+
+            if ( changesLoaded )
+                this->publishLoadedSnapshot();
         });
 
         // do the initializers on the regular stack. We should never be on the protected stack at this point
@@ -1822,7 +1834,7 @@ void* APIs::dlsym(void* handle, const char* symbolName)
                 log("     dlsym(\"%s\") => NULL\n", symbolName);
             return nullptr;
         }
-        STACK_ALLOC_ARRAY(const Loader*, alreadySearched, loaded.size());
+        STACK_ALLOC_SEARCHED_LOADERS(alreadySearched, *this);
         if ( !callerImage->hasExportedSymbol(diag, *this, underscoredName, Loader::dlsymNext, Loader::runResolver, &result, &alreadySearched) ) {
             setErrorString("dlsym(RTLD_NEXT, %s): symbol not found", symbolName);
             if ( config.log.apis )
@@ -1840,7 +1852,7 @@ void* APIs::dlsym(void* handle, const char* symbolName)
                 log("     dlsym(\"%s\") => NULL\n", symbolName);
             return nullptr;
         }
-        STACK_ALLOC_ARRAY(const Loader*, alreadySearched, loaded.size());
+        STACK_ALLOC_SEARCHED_LOADERS(alreadySearched, *this);
         if ( !callerImage->hasExportedSymbol(diag, *this, underscoredName, Loader::dlsymSelf, Loader::runResolver, &result, &alreadySearched) ) {
             setErrorString("dlsym(RTLD_SELF, %s): symbol not found", symbolName);
             if ( config.log.apis )
@@ -1860,7 +1872,7 @@ void* APIs::dlsym(void* handle, const char* symbolName)
             return nullptr;
         }
         // RTLD_FIRST only searches one place
-        STACK_ALLOC_ARRAY(const Loader*, alreadySearched, loaded.size());
+        STACK_ALLOC_SEARCHED_LOADERS(alreadySearched, *this);
         Loader::ExportedSymbolMode mode = (firstOnly ? Loader::staticLink : Loader::dlsymSelf);
         if ( !image->hasExportedSymbol(diag, *this, underscoredName, mode, Loader::runResolver, &result, &alreadySearched) ) {
             setErrorString("dlsym(%p, %s): symbol not found", handle, symbolName);
@@ -434,6 +434,58 @@ void SyscallDelegate::forEachInDirectory(const char* dirPath, bool dirsOnly, voi
 #endif
 }
 
+// calls the handler with the name of everything in the directory, including symlinks.
+// Returns 0 if the whole directory was read, otherwise an errno
+int SyscallDelegate::listDirectory(const char* dirPath, void (^handler)(const char* leafName, bool& stop)) const
+{
+#if BUILDING_DYLD
+    int fd = ::open(dirPath, O_RDONLY|O_DIRECTORY, 0);
+    if ( fd == -1 )
+        return errno;
+    struct attrlist attrList;
+    bzero(&attrList, sizeof(attrList));
+    attrList.bitmapcount = ATTR_BIT_MAP_COUNT;
+    attrList.commonattr  = ATTR_CMN_RETURNED_ATTRS | ATTR_CMN_NAME;
+    int  result = 0;
+    bool stop   = false;
+    while ( !stop ) {
+        uint8_t attrBuf[2048];
+        int retcount = ::getattrlistbulk(fd, &attrList, &attrBuf[0], sizeof(attrBuf), 0);
+        if ( retcount == 0 )
+            break;
+        if ( retcount < 0 ) {
+            result = errno;
+            break;
+        }
+        struct attr_layout {
+            uint32_t        length;
+            attribute_set_t returned;
+            attrreference_t name_info;
+        };
+        const attr_layout* entry = (attr_layout*)&attrBuf[0];
+        for (int index=0; (index < retcount) && !stop; ++index) {
+            const char* entryName = (char*)(&entry->name_info) + entry->name_info.attr_dataoffset;
+            handler(entryName, stop);
+            entry = (attr_layout*)((uint8_t*)entry + entry->length);
+        }
+    }
+    ::close(fd);
+    return result;
+#else
+    // the mock file system only knows the directories in _dirMap, so don't claim anything is missing from others
+    const auto& pos = _dirMap.find(dirPath);
+    if ( pos == _dirMap.end() )
+        return ENOTSUP;
+    bool stop = false;
+    for (const char* node : pos->second) {
+        handler(node, stop);
+        if ( stop )
+            break;
+    }
+    return 0;
+#endif
+}
+
 bool SyscallDelegate::getDylibInfo(const char* dylibPath, mach_o::Platform platform, const GradedArchs& archs, uint32_t& version, char installName[PATH_MAX]) const
 {
 #if BUILDING_DYLD
@@ -521,10 +573,11 @@ bool SyscallDelegate::fileExists(const char* path, FileID* fileID, int* errNum)
 #elif BUILDING_CACHE_BUILDER || BUILDING_CACHE_BUILDER_UNIT_TESTS
     if ( path[0] != '/' )
         return false;
-    bool found = (_mappedOtherDylibs.count(path) != 0);
+    const PathToMapping& otherDylibs = this->mappedOtherDylibs();
+    bool found = (otherDylibs.count(path) != 0);
     if ( !found  ) {
         std::string betterPath = normalize_absolute_file_path(path);
-        found = (_mappedOtherDylibs.count(betterPath) != 0);
+        found = (otherDylibs.count(betterPath) != 0);
     }
     if ( found ) {
         if ( fileID != nullptr )
@@ -771,11 +824,12 @@ const void* SyscallDelegate::mapFileReadOnly(Diagnostics& diag, const char* path
         ::close(fd);
     return result;
 #elif BUILDING_CACHE_BUILDER || BUILDING_CACHE_BUILDER_UNIT_TESTS
-    const auto& pos = _mappedOtherDylibs.find(path);
-    if ( pos == _mappedOtherDylibs.end() ) {
+    const PathToMapping& otherDylibs = this->mappedOtherDylibs();
+    const auto& pos = otherDylibs.find(path);
+    if ( pos == otherDylibs.end() ) {
         std::string betterPath = normalize_absolute_file_path(path);
-        const auto& pos2 = _mappedOtherDylibs.find(betterPath);
-        if ( pos2 != _mappedOtherDylibs.end() ) {
+        const auto& pos2 = otherDylibs.find(betterPath);
+        if ( pos2 != otherDylibs.end() ) {
             if ( realerPath != nullptr ) {
                 ::strlcpy(realerPath, betterPath.data(), PATH_MAX);
             }
@@ -823,11 +877,12 @@ void SyscallDelegate::withReadOnlyMappedFile(Diagnostics& diag, const char* path
         ::close(fileDescriptor);
     }
 #elif BUILDING_CACHE_BUILDER || BUILDING_CACHE_BUILDER_UNIT_TESTS
-    const auto& pos = _mappedOtherDylibs.find(path);
-    if ( pos == _mappedOtherDylibs.end() ) {
+    const PathToMapping& otherDylibs = this->mappedOtherDylibs();
+    const auto& pos = otherDylibs.find(path);
+    if ( pos == otherDylibs.end() ) {
         std::string betterPath = normalize_absolute_file_path(path);
-        const auto& pos2 = _mappedOtherDylibs.find(betterPath);
-        if ( pos2 != _mappedOtherDylibs.end() ) {
+        const auto& pos2 = otherDylibs.find(betterPath);
+        if ( pos2 != otherDylibs.end() ) {
             handler(pos2->second.mappingStart, pos2->second.mappingSize, true, FileID::none(), path, -1);
         }
     }
@@ -107,6 +107,7 @@ public:
     bool                hasExistingDyldCache(uint64_t& cacheBaseAddress, FileIdTuple& cacheFileID) const;
     void                disablePageInLinking() const;
     void                forEachInDirectory(const char* dir, bool dirs, void (^handler)(const char* pathInDir, const char* leafName)) const;
+    int                 listDirectory(const char* dir, void (^handler)(const char* leafName, bool& stop)) const;
     bool                getDylibInfo(const char* dylibPath, mach_o::Platform platform, const GradedArchs& archs, uint32_t& version, char installName[PATH_MAX]) const;
     bool                isContainerized(const char* homeDir) const;
     bool                isMaybeContainerized(const char* homeDir) const;
@@ -213,6 +214,8 @@ public:
 #if BUILDING_CACHE_BUILDER || BUILDING_CACHE_BUILDER_UNIT_TESTS
     struct MappingInfo { const void* mappingStart; size_t mappingSize; };
     typedef std::map<std::string_view, MappingInfo> PathToMapping;
+
+    const PathToMapping& mappedOtherDylibs() const { return (_sharedMappedOtherDylibs != nullptr) ? *_sharedMappedOtherDylibs : _mappedOtherDylibs; }
 #endif
 
 #if !BUILDING_DYLD
@@ -223,6 +226,8 @@ public:
 #endif
 #if BUILDING_CACHE_BUILDER || BUILDING_CACHE_BUILDER_UNIT_TESTS
     PathToMapping           _mappedOtherDylibs;
+    // if set, used instead of _mappedOtherDylibs so that many delegates can share one map without copying it
+    const PathToMapping*    _sharedMappedOtherDylibs = nullptr;
     const GradedArchs*      _gradedArchs    = nullptr;
 #endif
 
@@ -1073,9 +1073,11 @@ ProcessConfig::Logging::Logging(const Process& process, const Security& security
     this->loaders        = security.allowEnvVarsPrint && process.environ("DYLD_PRINT_LOADERS");
     this->searching      = security.allowEnvVarsPrint && process.environ("DYLD_PRINT_SEARCHING");
     this->env            = security.allowEnvVarsPrint && process.environ("DYLD_PRINT_ENV");
+    this->allocator      = security.allowEnvVarsPrint && process.environ("DYLD_PRINT_ALLOCATOR_STATS");
     this->useStderr      = security.allowEnvVarsPrint && process.environ("DYLD_PRINT_TO_STDERR");
     this->descriptor     = STDERR_FILENO;
     this->useFile        = false;
+    this->allocatorTraceDescriptor = -1;
     if ( security.allowEnvVarsPrint && security.allowEnvVarsSharedCache ) {
         if ( const char* path = process.environ("DYLD_PRINT_TO_FILE") ) {
             int fd = syscall.openLogFile(path);
@@ -1084,6 +1086,9 @@ ProcessConfig::Logging::Logging(const Process& process, const Security& security
                 this->descriptor = fd;
             }
         }
+        // binary log of the persistent allocator's calls, for replaying with allocator_replay
+        if ( const char* path = process.environ("DYLD_ALLOCATOR_TRACE_FILE") )
+            this->allocatorTraceDescriptor = syscall.openLogFile(path);
     }
     if ( security.allowEnvVarsPrint ) {
         if (const char* str = process.environ("DYLD_PRINT_LINKS_WITH") )
@@ -1100,6 +1105,8 @@ ProcessConfig::Logging::Logging(const Process& process, const Security& security
     this->loaders        = true;
     this->searching      = true;
     this->env            = true;
+    this->allocator      = false;
+    this->allocatorTraceDescriptor = -1;
 #endif
 }
 
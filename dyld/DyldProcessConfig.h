@@ -313,7 +313,9 @@ public:
         bool                        loaders;
         bool                        searching;
         bool                        env;
+        bool                        allocator;
         int                         descriptor;
+        int                         allocatorTraceDescriptor;
         bool                        useStderr;
         bool                        useFile;
         CString                     linksWith;
@@ -35,6 +35,7 @@
 //  #include <System/sys/reason.h>
   #include <kern/kcdata.h>
   #include <libkern/OSAtomic.h>
+  #include <mach/thread_switch.h>
 //  #include <_simple.h>
   // atexit header is missing C++ guards
   extern "C" {
@@ -88,6 +89,7 @@ extern "C" int amfi_check_dyld_policy_self(uint64_t input_flags, uint64_t* outpu
 #if !TARGET_OS_EXCLAVEKIT
   #include "FileUtils.h"
 #endif
+#include "PathProbeCache.h"
 #include "Vector.h"
 #if TARGET_OS_SIMULATOR
     #include "dyldSyscallInterface.h"
@@ -270,6 +272,38 @@ void RuntimeLocks::withNotifiersReadLock(void (^work)())
     }
 }
 
+uint32_t RuntimeLocks::beginSnapshotRead()
+{
+    // each thread has its own stack, so the stack address is a cheap way to spread threads over the slots
+    uint64_t stackPage = (uint64_t)(uintptr_t)__builtin_frame_address(0) >> 16;
+    uint32_t slot      = (uint32_t)(((stackPage * 0x9E3779B97F4A7C15ULL) >> 32) % kSnapshotReaderSlots);
+    uint32_t parity    = _snapshotEpoch.load(std::memory_order_relaxed) & 1;
+    // this must be ordered before the caller's load of the snapshot, so is sequentially consistent
+    _snapshotReaders[slot].counts[parity].fetch_add(1, std::memory_order_seq_cst);
+    return (slot << 1) | parity;
+}
+
+void RuntimeLocks::endSnapshotRead(uint32_t token)
+{
+    _snapshotReaders[token >> 1].counts[token & 1].fetch_sub(1, std::memory_order_release);
+}
+
+void RuntimeLocks::waitForSnapshotReaders()
+{
+    // The writer has already swapped out the snapshot.  Any reader which was counted before we look at its count
+    // is waited for, and any reader counted after that will load the new snapshot.  Both parities are checked, as a
+    // reader may have read the epoch before the flip, but only been counted after it
+    for ( uint32_t i = 0; i != 2; ++i ) {
+        uint32_t oldParity = _snapshotEpoch.fetch_add(1, std::memory_order_seq_cst) & 1;
+        for ( SnapshotReaderSlot& slot : _snapshotReaders ) {
+            while ( slot.counts[oldParity].load(std::memory_order_seq_cst) != 0 ) {
+#if BUILDING_DYLD && !TARGET_OS_EXCLAVEKIT
+                thread_switch(MACH_PORT_NULL, SWITCH_OPTION_DEPRESS, 1);
+#endif
+            }
+        }
+    }
+}
 
 void RuntimeLocks::takeLockBeforeFork()
 {
@@ -313,6 +347,11 @@ void RuntimeLocks::resetLockInForkChild()
     if ( (this->_libSystemHelpers != nullptr) && (this->_libSystemHelpers.version() >= 2) ) {
         this->_libSystemHelpers.os_unfair_recursive_lock_unlock_forked_child(&_loadersLock);
         this->_libSystemHelpers.os_unfair_recursive_lock_unlock_forked_child(&_notifiersLock);
+        // readers on other threads in the parent don't exist in the child, so must not be waited for
+        for ( SnapshotReaderSlot& slot : _snapshotReaders ) {
+            slot.counts[0].store(0, std::memory_order_relaxed);
+            slot.counts[1].store(0, std::memory_order_relaxed);
+        }
         allocatorLock    = OS_LOCK_UNFAIR_INIT;
 #if !TARGET_OS_SIMULATOR
         logSerializer    = OS_LOCK_UNFAIR_INIT;
@@ -706,6 +745,13 @@ void RuntimeState::setDyldLoader(const Loader* ldr)
     this->libdyldLoader = ldr;
 }
 
+bool RuntimeState::probeFileExists(const char* path, FileID* fileID, int* errNum)
+{
+    if ( this->pathProbeCache != nullptr )
+        return this->pathProbeCache->fileExists(this->config, path, fileID, errNum);
+    return this->config.fileExists(path, fileID, errNum);
+}
+
 void RuntimeState::setMainLoader(const Loader* ldr)
 {
     this->mainExecutableLoader = ldr;
@@ -1031,6 +1077,48 @@ bool RuntimeState::inPermanentRange(uintptr_t start, uintptr_t end, uint8_t* per
     return false;
 }
 
+void RuntimeState::withLoadedImages(void (^work)(std::span<const Loader* const> images))
+{
+    uint32_t token = locks.beginSnapshotRead();
+    if ( const LoadedSnapshot* snapshot = _loadedSnapshot.load(std::memory_order_seq_cst) ) {
+        work(std::span<const Loader* const>(snapshot->loaders, (size_t)snapshot->count));
+        locks.endSnapshotRead(token);
+        return;
+    }
+    locks.endSnapshotRead(token);
+
+    // no snapshot, because we are launching or 'loaded' is being changed, so copy it under the lock
+    locks.withLoadersReadLock(^{
+        STACK_ALLOC_ARRAY(const Loader*, images, loaded.size());
+        for ( const Loader* ldr : loaded )
+            images.push_back(ldr);
+        work(std::span<const Loader* const>(images.begin(), (size_t)images.count()));
+    });
+}
+
+void RuntimeState::invalidateLoadedSnapshot()
+{
+    const LoadedSnapshot* oldSnapshot = _loadedSnapshot.exchange(nullptr, std::memory_order_seq_cst);
+    if ( oldSnapshot == nullptr )
+        return;
+    locks.waitForSnapshotReaders();
+    persistentAllocator.free((void*)oldSnapshot);
+}
+
+void RuntimeState::publishLoadedSnapshot()
+{
+    uint64_t        count    = loaded.size();
+    LoadedSnapshot* snapshot = (LoadedSnapshot*)persistentAllocator.malloc(offsetof(LoadedSnapshot, loaders[count]));
+    snapshot->count = count;
+    for ( uint64_t i = 0; i != count; ++i )
+        snapshot->loaders[i] = loaded[i];
+    const LoadedSnapshot* oldSnapshot = _loadedSnapshot.exchange(snapshot, std::memory_order_seq_cst);
+    if ( oldSnapshot != nullptr ) {
+        locks.waitForSnapshotReaders();
+        persistentAllocator.free((void*)oldSnapshot);
+    }
+}
+
 void RuntimeState::setLaunchMissingDylib(const char* missingDylibPath, const char* clientUsingDylib)
 {
 #if BUILDING_DYLD && !TARGET_OS_EXCLAVEKIT
@@ -1897,6 +1985,8 @@ void RuntimeState::notifyUnload(const std::span<const Loader*>& loadersToRemove)
     removeMissingFlatLazySymbols(loadersToRemove);
 
     locks.withLoadersWriteLock(^{
+        // once the new snapshot is published, no lock-free reader can see these loaders, so removeLoaders() can unmap them
+        invalidateLoadedSnapshot();
         // remove each from loaded
         for ( const Loader* removeeLoader : loadersToRemove ) {
             for ( auto it=loaded.begin(); it != loaded.end(); ++it ) {
@@ -1908,6 +1998,7 @@ void RuntimeState::notifyUnload(const std::span<const Loader*>& loadersToRemove)
             // remove any entries in weakDefMap
             removeDynamicDependencies(removeeLoader);
         }
+        publishLoadedSnapshot();
     });
 
     // Call deinitialize on any pseudo-dylibs.
@@ -80,6 +80,7 @@ using dyld3::MachOAnalyzer;
 
 class DyldCacheDataConstLazyScopedWriter;
 class RuntimeState;
+class PathProbeCache;
 
 class Loader;
 class Reaper;
@@ -323,6 +324,13 @@ public:
 
     }
     
+    // Readers of RuntimeState's loaded images snapshot don't take the loaders lock.  Instead each one is counted
+    // in one of a few cache line sized slots while it uses the snapshot, and a writer which replaces the snapshot
+    // waits for the counts to drain before freeing the old one
+    uint32_t                beginSnapshotRead();
+    void                    endSnapshotRead(uint32_t token);
+    void                    waitForSnapshotReaders();
+
     // Helpers to reset locks across fork()
     void                    takeLockBeforeFork();
     void                    releaseLockInForkParent();
@@ -333,7 +341,17 @@ public:
     void                    setHelpers(LibSystemHelpersWrapper helpers) { _libSystemHelpers = helpers; }
 
 private:
+    // There are two counts per slot, picked by the low bit of the epoch.  Writers flip the epoch before waiting,
+    // so that a steady stream of new readers can't keep a writer waiting forever
+    static const uint32_t   kSnapshotReaderSlots = 32;
+    struct alignas(128) SnapshotReaderSlot
+    {
+        std::atomic<uint64_t>   counts[2] = { 0, 0 };
+    };
+
     LibSystemHelpersWrapper _libSystemHelpers;
+    std::atomic<uint32_t>   _snapshotEpoch = 0;
+    SnapshotReaderSlot      _snapshotReaders[kSnapshotReaderSlots];
 #if BUILDING_DYLD
     dyld_recursive_mutex  _loadersLock;
     dyld_recursive_mutex  _notifiersLock;
@@ -552,6 +570,7 @@ public:
     ExternallyViewableState*        externallyViewable;
 #endif
     Vector<AuthPseudoDylib>         pseudoDylibs;
+    PathProbeCache*                 pathProbeCache = nullptr;   // set while a PathProbeCache::Scope is active
 
 #if BUILDING_DYLD
     StructuredError                 structuredError;
@@ -582,6 +601,9 @@ public:
 
     void                        setDyldLoader(const Loader* ldr);
 
+    // like config.fileExists(), but uses the path probe cache if one is active
+    bool                        probeFileExists(const char* path, FileID* fileID=nullptr, int* errNum=nullptr);
+
     uint8_t*                    appState(uint16_t index);
     uint8_t*                    cachedDylibState(uint16_t index);
 #if BUILDING_CACHE_BUILDER || BUILDING_CACHE_BUILDER_UNIT_TESTS
@@ -618,6 +640,14 @@ public:
     void                        addPermanentRanges(const Array<const Loader*>& neverUnloadLoaders);
     bool                        inPermanentRange(uintptr_t start, uintptr_t end, uint8_t* perms, const Loader** loader);
 
+    // Calls 'work' with the loaded images.  This uses the snapshot published by the last change to 'loaded', without
+    // taking the loaders lock.  While 'loaded' is being changed there is no snapshot, and this takes the lock instead.
+    // 'work' must not call out of dyld, as a dlclose() from within it would wait forever for this reader to finish
+    void                        withLoadedImages(void (^work)(std::span<const Loader* const> images));
+    // Both must be called with the loaders write lock held.  Changes to 'loaded' go between the two
+    void                        invalidateLoadedSnapshot();
+    void                        publishLoadedSnapshot();
+
     void                        notifyLoad(const std::span<const Loader*>& newLoaders);
     void                        notifyUnload(const std::span<const Loader*>& removeLoaders);
     void                        doSingletonPatching(DyldCacheDataConstLazyScopedWriter& cacheDataConst);
@@ -728,6 +758,17 @@ private:
         Range                           _ranges[1];
     };
 
+    //
+    // An immutable copy of 'loaded', so that lookups which only need the list of images, eg, dladdr() and
+    // _dyld_get_image_header(), don't contend on the loaders lock.  It is replaced as a whole, and only freed once
+    // RuntimeLocks shows that no reader can still be using it
+    //
+    struct LoadedSnapshot
+    {
+        uint64_t                        count;
+        const Loader*                   loaders[1];
+    };
+
     // keep dlopen counts in a side table because it is rarely used, so it would waste space for each Loader object to have its own count field
     friend class Reaper;
     friend class RecursiveAutoLock;
@@ -807,6 +848,7 @@ private:
     bool                            _saveAppClosureFile;
     bool                            _failIfCouldBuildAppClosureFile;
     PermanentRanges*                _permanentRanges                = nullptr;
+    std::atomic<const LoadedSnapshot*> _loadedSnapshot              = nullptr;
     MainFunc                        _driverKitMain                  = nullptr;
     Vector<DlopenCount>             _dlopenRefCounts;
     Vector<const Loader*>           _dynamicNeverUnloads;
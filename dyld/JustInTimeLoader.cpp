@@ -23,6 +23,7 @@
 
 #include <assert.h>
 #include <strings.h>
+#include <algorithm>
 
 #include <TargetConditionals.h>
 #if !TARGET_OS_EXCLAVEKIT
@@ -35,6 +36,7 @@
 #include "Loader.h"
 #include "JustInTimeLoader.h"
 #include "MachOAnalyzer.h"
+#include "ExportBloomFilter.h"
 #include "DyldProcessConfig.h"
 #include "DyldRuntimeState.h"
 
@@ -341,6 +343,34 @@ const Loader::DylibPatch* JustInTimeLoader::makePatchTable(RuntimeState& state,
         DylibPatch*     table       = (DylibPatch*)state.persistentAllocator.malloc(sizeof(DylibPatch) * (patchCount + 1));;
         __block uint32_t patchIndex = 0;
 
+        // A root of a low level dylib can have thousands of patchable exports.  Resolve them all up front in name
+        // order, so that names with common prefixes share the walk of the root's exports trie
+        struct ResolvedExport { ResolvedSymbol symbol; bool found; };
+        ResolvedExport*  resolvedExports = (ResolvedExport*)state.persistentAllocator.malloc(sizeof(ResolvedExport) * patchCount);
+        const char**     exportNames     = (const char**)state.persistentAllocator.malloc(sizeof(const char*) * patchCount);
+        const char**     sortedNames     = (const char**)state.persistentAllocator.malloc(sizeof(const char*) * patchCount);
+        uint32_t*        nameOrder       = (uint32_t*)state.persistentAllocator.malloc(sizeof(uint32_t) * patchCount);
+        __block uint32_t exportIndex     = 0;
+        patchTable.forEachPatchableExport(indexOfOverriddenCachedDylib, ^(uint32_t dylibVMOffsetOfImpl, const char* exportName, PatchKind patchKind) {
+            exportNames[exportIndex] = exportName;
+            nameOrder[exportIndex]   = exportIndex;
+            ++exportIndex;
+        });
+        std::sort(nameOrder, nameOrder + patchCount, [&](uint32_t a, uint32_t b) {
+            return strcmp(exportNames[a], exportNames[b]) < 0;
+        });
+        for ( uint32_t i = 0; i < patchCount; ++i )
+            sortedNames[i] = exportNames[nameOrder[i]];
+        this->hasExportedSymbols(state, std::span<const char* const>(sortedNames, patchCount), staticLink, skipResolver,
+                                 ^(size_t nameIndex, bool found, const ResolvedSymbol& symbol) {
+            ResolvedExport& resolvedExport = resolvedExports[nameOrder[nameIndex]];
+            resolvedExport.symbol = symbol;
+            resolvedExport.found  = found;
+        });
+        state.persistentAllocator.free(nameOrder);
+        state.persistentAllocator.free(sortedNames);
+        state.persistentAllocator.free(exportNames);
+
 #if SUPPORT_VM_LAYOUT
         const uint8_t*  thisAddress = (uint8_t*)(this->loadAddress(state));
         const uint8_t*  cacheDylibAddress = (uint8_t*)state.config.dyldCache.addr->getIndexedImageEntry(indexOfOverriddenCachedDylib);
@@ -356,9 +386,9 @@ const Loader::DylibPatch* JustInTimeLoader::makePatchTable(RuntimeState& state,
 
         patchTable.forEachPatchableExport(indexOfOverriddenCachedDylib, ^(uint32_t dylibVMOffsetOfImpl, const char* exportName,
                                                                           PatchKind patchKind) {
-            Diagnostics    exportDiag;
-            ResolvedSymbol foundSymbolInfo;
-            if ( this->hasExportedSymbol(exportDiag, state, exportName, staticLink, skipResolver, &foundSymbolInfo) ) {
+            const ResolvedExport& resolvedExport  = resolvedExports[patchIndex];
+            const ResolvedSymbol& foundSymbolInfo = resolvedExport.symbol;
+            if ( resolvedExport.found ) {
                 if ( extra )
                     state.log("   will patch cache uses of '%s' %s\n", exportName, PatchTable::patchKindName(patchKind));
                 const dyld3::MachOAnalyzer* implMA  = (const dyld3::MachOAnalyzer*)foundSymbolInfo.targetLoader->loadAddress(state);
@@ -426,6 +456,7 @@ const Loader::DylibPatch* JustInTimeLoader::makePatchTable(RuntimeState& state,
         });
         // mark end of table
         table[patchIndex].overrideOffsetOfImpl = DylibPatch::endOfPatchTable;
+        state.persistentAllocator.free(resolvedExports);
         // record in Loader
         return table;
 #else
@@ -434,9 +465,9 @@ const Loader::DylibPatch* JustInTimeLoader::makePatchTable(RuntimeState& state,
         // The cache builder doesn't lay out dylibs in VM layout, so we need to use VMAddr/VMOffset everywhere
         patchTable.forEachPatchableExport(indexOfOverriddenCachedDylib, ^(uint32_t dylibVMOffsetOfImpl, const char* exportName,
                                                                           PatchKind patchKind) {
-            Diagnostics    exportDiag;
-            ResolvedSymbol foundSymbolInfo;
-            if ( this->hasExportedSymbol(exportDiag, state, exportName, staticLink, skipResolver, &foundSymbolInfo) ) {
+            const ResolvedExport& resolvedExport  = resolvedExports[patchIndex];
+            const ResolvedSymbol& foundSymbolInfo = resolvedExport.symbol;
+            if ( resolvedExport.found ) {
                 if ( extra )
                     state.log("   will patch cache uses of '%s' %s\n", exportName, PatchTable::patchKindName(patchKind));
                 CacheVMAddress implBaseVMAddr(((const Header*)foundSymbolInfo.targetLoader->mf(state))->preferredLoadAddress());
@@ -455,6 +486,7 @@ const Loader::DylibPatch* JustInTimeLoader::makePatchTable(RuntimeState& state,
         });
         // mark end of table
         table[patchIndex].overrideOffsetOfImpl = DylibPatch::endOfPatchTable;
+        state.persistentAllocator.free(resolvedExports);
         // record in Loader
         return table;
 #endif // SUPPORT_VM_LAYOUT
@@ -624,6 +656,60 @@ bool JustInTimeLoader::representsCachedDylibIndex(uint16_t dylibIndex) const
     return false;
 }
 
+const JustInTimeLoader::ExportFilter JustInTimeLoader::kNoExportFilter = { 0, { 0 } };
+
+bool JustInTimeLoader::exportFilter(const uint64_t*& words, uint32_t& wordCount) const
+{
+    const ExportFilter* filter = this->lazyExportFilter.load(std::memory_order_acquire);
+    if ( (filter == nullptr) || (filter == &kNoExportFilter) )
+        return false;
+
+    words     = filter->words;
+    wordCount = (uint32_t)filter->wordCount;
+    return true;
+}
+
+#if BUILDING_DYLD
+void JustInTimeLoader::buildExportFilter(RuntimeState& state) const
+{
+    if ( this->lazyExportFilter.load(std::memory_order_acquire) != nullptr )
+        return;
+
+    // images without a trie, or with one we can't walk, are always searched
+    Diagnostics      diag;
+    const uint8_t*   trieStart = nullptr;
+    const uint8_t*   trieEnd   = nullptr;
+    __block uint64_t nameCount = 0;
+    bool             canFilter = this->exportsTrie(diag, state, trieStart, trieEnd)
+                                 && ExportBloomFilter::forEachTrieName(trieStart, trieEnd, ^(const char* name) { ++nameCount; })
+                                 && (nameCount != 0);
+
+    // dlsym() may get here with only the loaders read lock, or no lock at all, and the persistent allocator is not
+    // thread safe, so the filter is only allocated and published under the loaders write lock.  dlsym() also doesn't
+    // make memory writable, and both the allocator and this loader are in TPRO protected memory, so do that explicitly.
+    // This can't use withLoadersWriteLockAndProtectedStack(), as dlopen() may already be on the protected stack
+    MemoryManager::withWritableMemory([&] {
+        state.locks.withLoadersWriteLock([&] {
+            if ( this->lazyExportFilter.load(std::memory_order_acquire) != nullptr )
+                return;
+            const ExportFilter* filter = &kNoExportFilter;
+            if ( canFilter ) {
+                uint32_t      wordCount = ExportBloomFilter::wordCountFor(nameCount);
+                ExportFilter* newFilter = (ExportFilter*)state.persistentAllocator.malloc(offsetof(ExportFilter, words[wordCount]));
+                newFilter->wordCount = wordCount;
+                bzero(newFilter->words, wordCount * sizeof(uint64_t));
+                uint64_t* words = newFilter->words;
+                ExportBloomFilter::forEachTrieName(trieStart, trieEnd, ^(const char* name) {
+                    ExportBloomFilter::add(words, wordCount, name);
+                });
+                filter = newFilter;
+            }
+            this->lazyExportFilter.store(filter, std::memory_order_release);
+        });
+    });
+}
+#endif // BUILDING_DYLD
+
 #if BUILDING_DYLD || BUILDING_UNIT_TESTS
 void JustInTimeLoader::logFixup(RuntimeState& state, uint64_t fixupLocRuntimeOffset, uintptr_t newValue, PointerMetaData pmd, const Loader::ResolvedSymbol& target) const
 {
@@ -901,6 +987,14 @@ void JustInTimeLoader::unmap(RuntimeState& state, bool force) const
     if ( !force && this->neverUnload )
         state.log("trying to unmap %s\n", this->path(state));
     assert(force || !this->neverUnload);
+    // the filter is freed under the same lock, and with the same writable memory, that buildExportFilter() allocates it with
+    MemoryManager::withWritableMemory([&] {
+        state.locks.withLoadersWriteLock([&] {
+            const ExportFilter* filter = this->lazyExportFilter.exchange(nullptr, std::memory_order_acq_rel);
+            if ( (filter != nullptr) && (filter != &kNoExportFilter) )
+                state.persistentAllocator.free((void*)filter);
+        });
+    });
     size_t vmSize  = (size_t)this->analyzer()->mappedSize();
     void*  vmStart = (void*)(this->loadAddress(state));
     state.config.syscall.munmap(vmStart, vmSize);
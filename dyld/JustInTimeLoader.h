@@ -26,6 +26,7 @@
 
 
 #include <stdint.h>
+#include <atomic>
 #include <TargetConditionals.h>
 
 #include "Defines.h"
@@ -87,6 +88,12 @@ public:
     bool                isOverrideOfCachedDylib() const { return overridesCache; }
     const PseudoDylib*  pseudoDylib() const { return pd; }
 
+    // bloom filter of the names in the exports trie, if one has been built (see ExportBloomFilter.h)
+    bool                exportFilter(const uint64_t*& words, uint32_t& wordCount) const;
+#if BUILDING_DYLD
+    void                buildExportFilter(RuntimeState& state) const;
+#endif
+
     FileValidationInfo  getFileValidationInfo(RuntimeState& state) const;
     static void         withRegions(const MachOFile* mf, void (^callback)(const Array<Region>& regions));
 
@@ -138,6 +145,13 @@ private:
 
 
 protected:
+    struct ExportFilter
+    {
+        uint64_t    wordCount;
+        uint64_t    words[1];
+    };
+    static const ExportFilter   kNoExportFilter;    // stored once we know the image can't have a filter
+
 #if SUPPORT_VM_LAYOUT
     const MachOLoaded*          mappedAddress;
     const MachOAnalyzer*        analyzer() const { return (MachOAnalyzer*)mappedAddress; }
@@ -165,6 +179,7 @@ protected:
     ConstAuthPseudoDylib pd                             = nullptr;
     uint32_t             exportsTrieRuntimeOffset       = 0;
     uint32_t             exportsTrieSize                = 0;
+    mutable std::atomic<const ExportFilter*> lazyExportFilter = nullptr;
     SectionLocations     sectionLocations;
     AuthLoader           dependents[1];
     // DependentsKind[]: If allDepsAreNormal is false, then we have an array here too, with 1 entry per dependent
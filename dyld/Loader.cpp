@@ -46,6 +46,7 @@
 #include "MachOAnalyzer.h"
 #include "Defines.h"
 #include "Utilities.h"
+#include "ExportBloomFilter.h"
 
 // dyld
 #include "Loader.h"
@@ -951,18 +952,18 @@ const Loader* Loader::getLoader(Diagnostics& diag, RuntimeState& state, const ch
                                 if ( possiblePathIsInDyldCache ) {
                                     if ( state.config.dyldCache.isOverridablePath(possiblePath) ) {
                                         // see if there is a root installed that overrides one of few overridable dylibs in the cache
-                                        possiblePathHasFileOnDisk  = state.config.fileExists(possiblePath, &possiblePathFileID, &possiblePathOnDiskErrNo);
+                                        possiblePathHasFileOnDisk  = state.probeFileExists(possiblePath, &possiblePathFileID, &possiblePathOnDiskErrNo);
                                         possiblePathOverridesCache = possiblePathHasFileOnDisk;
                                     }
                                 }
                                 else {
-                                    possiblePathHasFileOnDisk  = state.config.fileExists(possiblePath, &possiblePathFileID, &possiblePathOnDiskErrNo);
+                                    possiblePathHasFileOnDisk  = state.probeFileExists(possiblePath, &possiblePathFileID, &possiblePathOnDiskErrNo);
                                     possiblePathOverridesCache = possiblePathHasFileOnDisk && originalPathIsOverridableInDyldCache;
                                 }
                             }
                             else {
                                 // for dev caches, always stat() and check cache
-                                possiblePathHasFileOnDisk = state.config.fileExists(possiblePath, &possiblePathFileID, &possiblePathOnDiskErrNo);
+                                possiblePathHasFileOnDisk = state.probeFileExists(possiblePath, &possiblePathFileID, &possiblePathOnDiskErrNo);
                                 if ( possiblePathHasFileOnDisk || !ProcessConfig::PathOverrides::isOnDiskOnlyType(type) )
                                     possiblePathIsInDyldCache = state.config.dyldCache.indexOfPath(possiblePath, dylibInCacheIndex);
                                 possiblePathOverridesCache = possiblePathHasFileOnDisk && (originalPathIsInDyldCache || possiblePathIsInDyldCache);
@@ -2989,7 +2990,7 @@ Loader::ResolvedSymbol Loader::resolveSymbol(Diagnostics& diag, RuntimeState& st
         return result;
     }
     if ( result.targetLoader != nullptr ) {
-        STACK_ALLOC_ARRAY(const Loader*, alreadySearched, state.loaded.size());
+        STACK_ALLOC_SEARCHED_LOADERS(alreadySearched, state);
         if ( result.targetLoader->hasExportedSymbol(diag, state, symbolName, Loader::staticLink, Loader::skipResolver, &result, &alreadySearched) ) {
             return result;
         }
@@ -3075,17 +3076,167 @@ void Loader::tooNewErrorAddendum(Diagnostics& diag, RuntimeState& state) const
     });
 }
 
-bool Loader::hasExportedSymbol(Diagnostics& diag, RuntimeState& state, const char* symbolName, ExportedSymbolMode mode, ResolverMode resolverMode,
-                               ResolvedSymbol* result, dyld3::Array<const Loader*>* alreadySearched) const
+// The cache builder can't use runtimeOffset's to get the exports trie.  Instead use the layout from
+// the builder
+bool Loader::exportsTrie(Diagnostics& diag, const RuntimeState& state, const uint8_t*& trieStart, const uint8_t*& trieEnd) const
 {
-    // don't search twice
-    if ( alreadySearched != nullptr ) {
-        for ( const Loader* im : *alreadySearched ) {
-            if ( im == this )
-                return false;
+#if SUPPORT_VM_LAYOUT
+    uint64_t trieRuntimeOffset;
+    uint32_t trieSize;
+    if ( !this->getExportsTrie(trieRuntimeOffset, trieSize) )
+        return false;
+    trieStart = (uint8_t*)this->loadAddress(state) + trieRuntimeOffset;
+    trieEnd   = trieStart + trieSize;
+    return true;
+#else
+    __block bool hasTrie = false;
+    this->withLayout(diag, state, ^(const mach_o::Layout &layout) {
+        if ( layout.linkedit.exportsTrie.hasValue() ) {
+            trieStart   = layout.linkedit.exportsTrie.buffer;
+            trieEnd     = trieStart + layout.linkedit.exportsTrie.bufferSize;
+            hasTrie     = true;
         }
-        alreadySearched->push_back(this);
+    });
+    return hasTrie;
+#endif
+}
+
+// Builds the ResolvedSymbol for the terminal node of 'symbolName' in this image's exports trie.
+// Follows re-exports in to the dependent dylib
+bool Loader::exportedSymbolFromTrieNode(Diagnostics& diag, RuntimeState& state, const char* symbolName, const uint8_t* node, const uint8_t* trieEnd,
+                                        ExportedSymbolMode mode, ResolverMode resolverMode, ResolvedSymbol* result,
+                                        SearchedLoaders* alreadySearched) const
+{
+    const uint8_t* p     = node;
+    const uint64_t flags = MachOLoaded::read_uleb128(diag, p, trieEnd);
+    if ( flags & EXPORT_SYMBOL_FLAGS_REEXPORT ) {
+        // re-export from another dylib, lookup there
+        const uint64_t ordinal      = MachOLoaded::read_uleb128(diag, p, trieEnd);
+        const char*    importedName = (char*)p;
+        bool nameChanged = false;
+        if ( importedName[0] == '\0' ) {
+            importedName = symbolName;
+        } else if ( strcmp(importedName, symbolName) != 0 ) {
+            nameChanged = true;
+        }
+        if ( (ordinal == 0) || (ordinal > this->dependentCount()) ) {
+            diag.error("re-export ordinal %lld in %s out of range for %s", ordinal, this->path(state), symbolName);
+            return false;
+        }
+        uint32_t                 depIndex = (uint32_t)(ordinal - 1);
+        LinkedDylibAttributes depAttrs;
+        if ( Loader* depLoader = this->dependent(state, depIndex, &depAttrs) ) {
+            // <rdar://91326465> Explicitly promote to a ::staticLink
+            // resolution when looking for a reexported symbol in ::shallow mode.
+            // The symbol might be located in one of the reexported libraries
+            // of the dependent. If the caller checks all loaders with
+            // ::shallow mode it won't be able to find an aliased symbol,
+            // because it will only look for the original name.
+            if ( nameChanged && mode == Loader::shallow )
+                mode = Loader::staticLink;
+            if ( nameChanged && alreadySearched ) {
+                // As we are changing the symbol name we are looking for, use a new alreadySearched.  The existnig
+                // alreadySearched may include loaders we have searched before for the old name, but not the new one,
+                // and we want to check them again
+                STACK_ALLOC_SEARCHED_LOADERS(nameChangedAlreadySearched, state);
+                return depLoader->hasExportedSymbol(diag, state, importedName, mode, resolverMode, result, &nameChangedAlreadySearched);
+            }
+            return depLoader->hasExportedSymbol(diag, state, importedName, mode, resolverMode, result, alreadySearched);
+        }
+        return false; // re-exported symbol from weak-linked dependent which is missing
+    }
+    else if ( flags & EXPORT_SYMBOL_FLAGS_FUNCTION_VARIANT ) {
+        if ( diag.hasError() )
+            return false;
+        // symbol has a variant table as second entry, skip first value (default impl addr)
+        (void)MachOLoaded::read_uleb128(diag, p, trieEnd);
+        uint32_t  fvTableIndex         = (uint32_t)MachOLoaded::read_uleb128(diag, p, trieEnd);
+        uint64_t  betterFunctionOffset = this->selectFromFunctionVariants(diag, state, symbolName, fvTableIndex);
+        if ( diag.hasError() )
+            return false;
+        result->targetLoader        = this;
+        result->targetSymbolName    = symbolName;
+        result->targetRuntimeOffset = betterFunctionOffset;
+        result->kind                = ResolvedSymbol::Kind::bindToImage;
+        result->isCode              = true;
+        result->isWeakDef           = false;
+        result->isMissingFlatLazy   = false;
+        result->isFunctionVariant   = true;
+        result->variantIndex        = fvTableIndex;
+        return true;
+    }
+    else {
+        if ( diag.hasError() )
+            return false;
+        bool isAbsoluteSymbol           = ((flags & EXPORT_SYMBOL_FLAGS_KIND_MASK) == EXPORT_SYMBOL_FLAGS_KIND_ABSOLUTE);
+        uintptr_t targetRuntimeOffset   = (uintptr_t)MachOLoaded::read_uleb128(diag, p, trieEnd);
+
+#if BUILDING_DYLD
+        bool isResolver = (flags & EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER);
+        if ( isResolver && (resolverMode == runResolver) ) {
+            uintptr_t resolverFuncRuntimeOffset = (uintptr_t)MachOLoaded::read_uleb128(diag, p, trieEnd);
+            const uint8_t* dylibLoadAddress = (const uint8_t*)this->loadAddress(state);
+            typedef void* (*ResolverFunc)(void);
+            ResolverFunc resolver = (ResolverFunc)(dylibLoadAddress + resolverFuncRuntimeOffset);
+#if __has_feature(ptrauth_calls)
+            resolver = __builtin_ptrauth_sign_unauthenticated(resolver, ptrauth_key_asia, 0);
+#endif
+            const void* resolverResult = (*resolver)();
+            targetRuntimeOffset = (uintptr_t)resolverResult - (uintptr_t)dylibLoadAddress;
+        }
+#endif
+
+        result->targetLoader            = this;
+        result->targetSymbolName        = symbolName;
+        result->targetRuntimeOffset     = targetRuntimeOffset;
+        result->kind                    = isAbsoluteSymbol ? ResolvedSymbol::Kind::bindAbsolute : ResolvedSymbol::Kind::bindToImage;
+        result->isCode                  = this->mf(state)->inCodeSection((uint32_t)(result->targetRuntimeOffset));
+#if BUILDING_DYLD
+        result->targetAddressForDlsym   = resolvedAddress(state, *result);
+        result->targetAddressForDlsym   = interpose(state, result->targetAddressForDlsym);
+#if __has_feature(ptrauth_calls)
+        if ( result->isCode )
+            result->targetAddressForDlsym = (uintptr_t)__builtin_ptrauth_sign_unauthenticated((void*)result->targetAddressForDlsym, ptrauth_key_asia, 0);
+#endif
+#endif
+        result->isWeakDef               = (flags & EXPORT_SYMBOL_FLAGS_WEAK_DEFINITION);
+        result->isMissingFlatLazy       = false;
+        result->isMaterializing         = false;
+        return true;
+    }
+}
+
+// Returns false if this image's export filter shows that 'symbolName' is not in its exports trie.  Dylibs in the
+// dyld cache get their filter from the cache builder.  Other images only have one once buildExportFilter() has run
+bool Loader::exportFilterMayContain(const RuntimeState& state, const char* symbolName) const
+{
+#if BUILDING_DYLD
+    const uint64_t* words     = nullptr;
+    uint32_t        wordCount = 0;
+    if ( this->dylibInDyldCache ) {
+        const DyldSharedCache* cache = state.config.dyldCache.addr;
+        if ( (cache == nullptr) || !cache->exportFilter(this->ref.index, words, wordCount) )
+            return true;
     }
+    else if ( const JustInTimeLoader* jitThis = this->isJustInTimeLoader() ) {
+        if ( !jitThis->exportFilter(words, wordCount) )
+            return true;
+    }
+    else {
+        return true;
+    }
+    return ExportBloomFilter::mayContain(words, wordCount, symbolName);
+#else
+    return true;
+#endif
+}
+
+bool Loader::hasExportedSymbol(Diagnostics& diag, RuntimeState& state, const char* symbolName, ExportedSymbolMode mode, ResolverMode resolverMode,
+                               ResolvedSymbol* result, SearchedLoaders* alreadySearched) const
+{
+    // don't search twice
+    if ( (alreadySearched != nullptr) && !alreadySearched->insert(this) )
+        return false;
     bool               canSearchDependents;
     bool               searchNonReExports;
     bool               searchSelf;
@@ -3117,132 +3268,15 @@ bool Loader::hasExportedSymbol(Diagnostics& diag, RuntimeState& state, const cha
             break;
     }
 
-    // The cache builder can't use runtimeOffset's to get the exports trie.  Instead use the layout from
-    // the builder
-    __block const uint8_t* trieStart = nullptr;
-    __block const uint8_t* trieEnd   = nullptr;
-    __block bool hasTrie = false;
-#if SUPPORT_VM_LAYOUT
-    const MachOLoaded* ml = this->loadAddress(state);
-    //state.log("Loader::hasExportedSymbol(%s) this=%s\n", symbolName, this->path());
-    uint64_t trieRuntimeOffset;
-    uint32_t trieSize;
-    if ( this->getExportsTrie(trieRuntimeOffset, trieSize) ) {
-        trieStart = (uint8_t*)ml + trieRuntimeOffset;
-        trieEnd   = trieStart + trieSize;
-        hasTrie   = true;
-    }
-#else
-    this->withLayout(diag, state, ^(const mach_o::Layout &layout) {
-        if ( layout.linkedit.exportsTrie.hasValue() ) {
-            trieStart   = layout.linkedit.exportsTrie.buffer;
-            trieEnd     = trieStart + layout.linkedit.exportsTrie.bufferSize;
-            hasTrie     = true;
-        }
-    });
-#endif
-
-    if ( hasTrie ) {
-        const uint8_t* node      = MachOLoaded::trieWalk(diag, trieStart, trieEnd, symbolName);
-        //state.log("    trieStart=%p, trieSize=0x%08X, node=%p, error=%s\n", trieStart, trieSize, node, diag.errorMessage());
-        if ( (node != nullptr) && searchSelf ) {
-            const uint8_t* p     = node;
-            const uint64_t flags = MachOLoaded::read_uleb128(diag, p, trieEnd);
-            if ( flags & EXPORT_SYMBOL_FLAGS_REEXPORT ) {
-                // re-export from another dylib, lookup there
-                const uint64_t ordinal      = MachOLoaded::read_uleb128(diag, p, trieEnd);
-                const char*    importedName = (char*)p;
-                bool nameChanged = false;
-                if ( importedName[0] == '\0' ) {
-                    importedName = symbolName;
-                } else if ( strcmp(importedName, symbolName) != 0 ) {
-                    nameChanged = true;
-                }
-                if ( (ordinal == 0) || (ordinal > this->dependentCount()) ) {
-                    diag.error("re-export ordinal %lld in %s out of range for %s", ordinal, this->path(state), symbolName);
-                    return false;
-                }
-                uint32_t                 depIndex = (uint32_t)(ordinal - 1);
-                LinkedDylibAttributes depAttrs;
-                if ( Loader* depLoader = this->dependent(state, depIndex, &depAttrs) ) {
-                    // <rdar://91326465> Explicitly promote to a ::staticLink
-                    // resolution when looking for a reexported symbol in ::shallow mode.
-                    // The symbol might be located in one of the reexported libraries
-                    // of the dependent. If the caller checks all loaders with
-                    // ::shallow mode it won't be able to find an aliased symbol,
-                    // because it will only look for the original name.
-                    if ( nameChanged && mode == Loader::shallow )
-                        mode = Loader::staticLink;
-                    if ( nameChanged && alreadySearched ) {
-                        // As we are changing the symbol name we are looking for, use a new alreadySearched.  The existnig
-                        // alreadySearched may include loaders we have searched before for the old name, but not the new one,
-                        // and we want to check them again
-                        STACK_ALLOC_ARRAY(const Loader*, nameChangedAlreadySearched, state.loaded.size());
-                        return depLoader->hasExportedSymbol(diag, state, importedName, mode, resolverMode, result, &nameChangedAlreadySearched);
-                    }
-                    return depLoader->hasExportedSymbol(diag, state, importedName, mode, resolverMode, result, alreadySearched);
-                }
-                return false; // re-exported symbol from weak-linked dependent which is missing
-            }
-            else if ( flags & EXPORT_SYMBOL_FLAGS_FUNCTION_VARIANT ) {
-                if ( diag.hasError() )
-                    return false;
-                // symbol has a variant table as second entry, skip first value (default impl addr)
-                (void)MachOLoaded::read_uleb128(diag, p, trieEnd);
-                uint32_t  fvTableIndex         = (uint32_t)MachOLoaded::read_uleb128(diag, p, trieEnd);
-                uint64_t  betterFunctionOffset = this->selectFromFunctionVariants(diag, state, symbolName, fvTableIndex);
-                if ( diag.hasError() )
-                    return false;
-                result->targetLoader        = this;
-                result->targetSymbolName    = symbolName;
-                result->targetRuntimeOffset = betterFunctionOffset;
-                result->kind                = ResolvedSymbol::Kind::bindToImage;
-                result->isCode              = true;
-                result->isWeakDef           = false;
-                result->isMissingFlatLazy   = false;
-                result->isFunctionVariant   = true;
-                result->variantIndex        = fvTableIndex;
-                return true;
-            }
-            else {
-                if ( diag.hasError() )
-                    return false;
-                bool isAbsoluteSymbol           = ((flags & EXPORT_SYMBOL_FLAGS_KIND_MASK) == EXPORT_SYMBOL_FLAGS_KIND_ABSOLUTE);
-                uintptr_t targetRuntimeOffset   = (uintptr_t)MachOLoaded::read_uleb128(diag, p, trieEnd);
-
-#if BUILDING_DYLD
-                bool isResolver = (flags & EXPORT_SYMBOL_FLAGS_STUB_AND_RESOLVER);
-                if ( isResolver && (resolverMode == runResolver) ) {
-                    uintptr_t resolverFuncRuntimeOffset = (uintptr_t)MachOLoaded::read_uleb128(diag, p, trieEnd);
-                    const uint8_t* dylibLoadAddress = (const uint8_t*)this->loadAddress(state);
-                    typedef void* (*ResolverFunc)(void);
-                    ResolverFunc resolver = (ResolverFunc)(dylibLoadAddress + resolverFuncRuntimeOffset);
-#if __has_feature(ptrauth_calls)
-                    resolver = __builtin_ptrauth_sign_unauthenticated(resolver, ptrauth_key_asia, 0);
-#endif
-                    const void* resolverResult = (*resolver)();
-                    targetRuntimeOffset = (uintptr_t)resolverResult - (uintptr_t)dylibLoadAddress;
-                }
-#endif
-
-                result->targetLoader            = this;
-                result->targetSymbolName        = symbolName;
-                result->targetRuntimeOffset     = targetRuntimeOffset;
-                result->kind                    = isAbsoluteSymbol ? ResolvedSymbol::Kind::bindAbsolute : ResolvedSymbol::Kind::bindToImage;
-                result->isCode                  = this->mf(state)->inCodeSection((uint32_t)(result->targetRuntimeOffset));
-#if BUILDING_DYLD
-                result->targetAddressForDlsym   = resolvedAddress(state, *result);
-                result->targetAddressForDlsym   = interpose(state, result->targetAddressForDlsym);
-#if __has_feature(ptrauth_calls)
-                if ( result->isCode )
-                    result->targetAddressForDlsym = (uintptr_t)__builtin_ptrauth_sign_unauthenticated((void*)result->targetAddressForDlsym, ptrauth_key_asia, 0);
-#endif
-#endif
-                result->isWeakDef               = (flags & EXPORT_SYMBOL_FLAGS_WEAK_DEFINITION);
-                result->isMissingFlatLazy       = false;
-                result->isMaterializing         = false;
-                return true;
-            }
+    const uint8_t* trieStart = nullptr;
+    const uint8_t* trieEnd   = nullptr;
+    if ( this->exportsTrie(diag, state, trieStart, trieEnd) ) {
+        // the walk is only needed if we are searching this image, and its export filter doesn't rule the symbol out
+        if ( searchSelf && this->exportFilterMayContain(state, symbolName) ) {
+            const uint8_t* node      = MachOLoaded::trieWalk(diag, trieStart, trieEnd, symbolName);
+            //state.log("    trieStart=%p, trieEnd=%p, node=%p, error=%s\n", trieStart, trieEnd, node, diag.errorMessage());
+            if ( node != nullptr )
+                return this->exportedSymbolFromTrieNode(diag, state, symbolName, node, trieEnd, mode, resolverMode, result, alreadySearched);
         }
     }
     else {
@@ -3322,6 +3356,14 @@ bool Loader::hasExportedSymbol(Diagnostics& diag, RuntimeState& state, const cha
                 //state.log("dep #%d of %p is %d %p (%s %s)\n", i, this, (int)depKind, depLoader, this->path(), depLoader->path());
                 // when dlsym() continues to search (searchNonReExports), don't follow upward or delay linkages
                 if ( depAttrs.reExport || (searchNonReExports && !depAttrs.upward && !depAttrs.delayInit)  ) {
+#if BUILDING_DYLD
+                    // re-exported dylibs, eg, the sub-libraries of an umbrella framework, are searched for most symbols
+                    // they don't have, so are worth a filter.  Dylibs in the dyld cache already have one
+                    if ( depAttrs.reExport && !depLoader->dylibInDyldCache ) {
+                        if ( const JustInTimeLoader* jitDep = depLoader->isJustInTimeLoader() )
+                            jitDep->buildExportFilter(state);
+                    }
+#endif
                     if ( depLoader->hasExportedSymbol(diag, state, symbolName, depsMode, resolverMode, result, alreadySearched) )
                         return true;
                 }
@@ -3331,6 +3373,142 @@ bool Loader::hasExportedSymbol(Diagnostics& diag, RuntimeState& state, const cha
     return false;
 }
 
+//
+// Finds the terminal nodes of many symbols in one exports trie.  Each walk resumes from the deepest node on the
+// path it shares with the previous symbol, instead of from the root, so walking names in sorted order only
+// visits each node on the shared prefixes once.  Any order gives the same answers as MachOLoaded::trieWalk()
+//
+class VIS_HIDDEN SortedTrieWalker
+{
+public:
+                    SortedTrieWalker(const uint8_t* start, const uint8_t* end) : _start(start), _end(end) { }
+
+    const uint8_t*  find(Diagnostics& diag, const char* symbol)
+    {
+        // drop the nodes which are below the prefix this symbol shares with the previous one
+        uint32_t sharedLength = 0;
+        if ( _prevSymbol != nullptr ) {
+            while ( (_prevSymbol[sharedLength] != '\0') && (_prevSymbol[sharedLength] == symbol[sharedLength]) )
+                ++sharedLength;
+        }
+        while ( _path[_depth - 1].symbolOffset > sharedLength )
+            --_depth;
+        _prevSymbol = symbol;
+
+        const uint8_t* p = _start + _path[_depth - 1].nodeOffset;
+        const char*    s = symbol + _path[_depth - 1].symbolOffset;
+        while ( p < _end ) {
+            uint64_t terminalSize = *p++;
+            if ( terminalSize > 127 ) {
+                // except for re-export-with-rename, all terminal sizes fit in one byte
+                --p;
+                terminalSize = MachOLoaded::read_uleb128(diag, p, _end);
+                if ( diag.hasError() )
+                    return nullptr;
+            }
+            if ( (*s == '\0') && (terminalSize != 0) )
+                return p;
+            const uint8_t* children = p + terminalSize;
+            if ( children >= _end )
+                return nullptr;
+            uint8_t childrenRemaining = *children++;
+            p = children;
+            uint64_t nodeOffset = 0;
+            for (; childrenRemaining > 0; --childrenRemaining) {
+                const char* ss        = s;
+                bool        wrongEdge = false;
+                // scan whole edge to get to next edge
+                // if edge is longer than target symbol name, don't read past end of symbol name
+                while ( (p < _end) && (*p != '\0') ) {
+                    if ( !wrongEdge ) {
+                        if ( (char)*p != *ss )
+                            wrongEdge = true;
+                        ++ss;
+                    }
+                    ++p;
+                }
+                ++p; // skip over zero terminator
+                if ( p >= _end ) {
+                    diag.error("malformed trie node, child node extends past end of trie\n");
+                    return nullptr;
+                }
+                if ( wrongEdge ) {
+                    // skip over uleb128 until last byte is found
+                    while ( (p < _end) && ((*p & 0x80) != 0) )
+                        ++p;
+                    ++p;
+                    continue;
+                }
+                nodeOffset = MachOLoaded::read_uleb128(diag, p, _end);
+                if ( diag.hasError() )
+                    return nullptr;
+                if ( (nodeOffset == 0) || (nodeOffset > (uint64_t)(_end - _start)) ) {
+                    diag.error("malformed trie child, nodeOffset=0x%llX out of range\n", nodeOffset);
+                    return nullptr;
+                }
+                s = ss;
+                break;
+            }
+            if ( nodeOffset == 0 )
+                return nullptr;
+
+            // check for cycles, and remember the node so that later symbols can start from it
+            for ( uint32_t i = 0; i < _depth; ++i ) {
+                if ( _path[i].nodeOffset == nodeOffset ) {
+                    diag.error("malformed trie child, cycle to nodeOffset=0x%llX\n", nodeOffset);
+                    return nullptr;
+                }
+            }
+            if ( _depth == kMaxDepth )
+                return MachOLoaded::trieWalk(diag, _start, _end, symbol);
+            _path[_depth++] = { (uint32_t)(s - symbol), (uint32_t)nodeOffset };
+            p = _start + nodeOffset;
+        }
+        return nullptr;
+    }
+
+private:
+    struct Step
+    {
+        uint32_t    symbolOffset;   // how much of the symbol was matched to reach the node
+        uint32_t    nodeOffset;
+    };
+    static const uint32_t kMaxDepth = 128;
+
+    const uint8_t*  _start;
+    const uint8_t*  _end;
+    const char*     _prevSymbol = nullptr;
+    Step            _path[kMaxDepth] = { { 0, 0 } };
+    uint32_t        _depth = 1;
+};
+
+void Loader::hasExportedSymbols(RuntimeState& state, std::span<const char* const> sortedSymbolNames, ExportedSymbolMode mode, ResolverMode resolverMode,
+                                void (^handler)(size_t nameIndex, bool found, const ResolvedSymbol& result)) const
+{
+    Diagnostics    trieDiag;
+    const uint8_t* trieStart = nullptr;
+    const uint8_t* trieEnd   = nullptr;
+    // dlsymNext does not search this image, so every name has to go the slow way
+    const bool       useTrie = (mode != dlsymNext) && this->exportsTrie(trieDiag, state, trieStart, trieEnd);
+    SortedTrieWalker walker(trieStart, trieEnd);
+    for ( size_t i = 0; i < sortedSymbolNames.size(); ++i ) {
+        const char*    symbolName = sortedSymbolNames[i];
+        Diagnostics    diag;
+        ResolvedSymbol result;
+        bool           found = false;
+        const uint8_t* node  = useTrie ? walker.find(diag, symbolName) : nullptr;
+        if ( node != nullptr ) {
+            found = this->exportedSymbolFromTrieNode(diag, state, symbolName, node, trieEnd, mode, resolverMode, &result, nullptr);
+        }
+        else {
+            // not in this image's trie, but may be in a re-exported dylib
+            diag.clearError();
+            found = this->hasExportedSymbol(diag, state, symbolName, mode, resolverMode, &result);
+        }
+        handler(i, found, result);
+    }
+}
+
 // FIXME: use of Image here is expensive, especially for PrebuiltLoaders.  Getting the function variants linkedit blob
 // should be different for JustInTimeLoaders and PrebuiltLoaders
 uint64_t Loader::selectFromFunctionVariants(Diagnostics& diag, const RuntimeState& state, const char* symbolName, uint32_t fvTableIndex) const
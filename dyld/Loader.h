@@ -24,6 +24,7 @@
 #ifndef Loader_h
 #define Loader_h
 
+#include <string.h>
 #include <TargetConditionals.h>
 
 #include "Defines.h"
@@ -174,6 +175,45 @@ public:
     struct BindTarget { const Loader* loader; uint64_t runtimeOffset; };
     typedef mach_o::LinkedDylibAttributes   LinkedDylibAttributes;
 
+    // The loaders a recursive hasExportedSymbol() has already searched.  Dylibs in the dyld cache, which is where
+    // umbrella frameworks and their re-exported sub-libraries are, are tracked in a bitmap keyed by cache dylib index.
+    // Any other loaders go in a short list.  Use STACK_ALLOC_SEARCHED_LOADERS() to make one
+    class SearchedLoaders
+    {
+    public:
+                    SearchedLoaders(uint64_t* cacheDylibBits, uint32_t cacheDylibCount, const Loader** others, uint32_t maxOthers)
+                        : _cacheDylibBits(cacheDylibBits), _cacheDylibCount(cacheDylibCount), _others(others, maxOthers)
+                    {
+                        memset(_cacheDylibBits, 0, bitmapWordCount(cacheDylibCount) * sizeof(uint64_t));
+                    }
+
+        // adds the loader, or returns false if it was already searched
+        bool        insert(const Loader* ldr)
+        {
+            if ( ldr->dylibInDyldCache && (ldr->ref.index < _cacheDylibCount) ) {
+                uint64_t& word = _cacheDylibBits[ldr->ref.index / 64];
+                uint64_t  bit  = 1ULL << (ldr->ref.index % 64);
+                if ( (word & bit) != 0 )
+                    return false;
+                word |= bit;
+                return true;
+            }
+            for ( const Loader* other : _others ) {
+                if ( other == ldr )
+                    return false;
+            }
+            _others.push_back(ldr);
+            return true;
+        }
+
+        static uint32_t bitmapWordCount(uint32_t cacheDylibCount) { return (cacheDylibCount + 63) / 64; }
+
+    private:
+        uint64_t*                   _cacheDylibBits;
+        uint32_t                    _cacheDylibCount;
+        dyld3::Array<const Loader*> _others;
+    };
+
     // stored in PrebuiltLoader when it references a file on disk
     struct FileValidationInfo
     {
@@ -264,7 +304,16 @@ public:
 #endif
     bool                    hasExportedSymbol(Diagnostics& diag, RuntimeState&, const char* symbolName, ExportedSymbolMode mode,
                                               ResolverMode resolverMode, ResolvedSymbol* result,
-                                              dyld3::Array<const Loader*>* searched=nullptr) const;
+                                              SearchedLoaders* searched=nullptr) const;
+    // looks up many symbols with the same semantics as hasExportedSymbol(), sharing the exports trie walk between names with
+    // common prefixes.  Any order works, but sorting the names with strcmp() shares the most work
+    void                    hasExportedSymbols(RuntimeState&, std::span<const char* const> sortedSymbolNames, ExportedSymbolMode mode,
+                                               ResolverMode resolverMode, void (^handler)(size_t nameIndex, bool found, const ResolvedSymbol& result)) const;
+    bool                    exportsTrie(Diagnostics& diag, const RuntimeState& state, const uint8_t*& trieStart, const uint8_t*& trieEnd) const;
+    bool                    exportedSymbolFromTrieNode(Diagnostics& diag, RuntimeState&, const char* symbolName, const uint8_t* node,
+                                                       const uint8_t* trieEnd, ExportedSymbolMode mode, ResolverMode resolverMode,
+                                                       ResolvedSymbol* result, SearchedLoaders* searched) const;
+    bool                    exportFilterMayContain(const RuntimeState& state, const char* symbolName) const;
     uint64_t                selectFromFunctionVariants(Diagnostics& diag, const RuntimeState& state, const char* symbolName, uint32_t fvTableIndex) const;
     void                    logSegmentsFromSharedCache(RuntimeState& state) const;
     bool                    hasConstantSegmentsToProtect() const;
@@ -423,4 +472,12 @@ static_assert(sizeof(Loader) == 32, "Invalid size");
 
 }
 
+//  STACK_ALLOC_SEARCHED_LOADERS(searched, state);
+//  searched is of type dyld4::Loader::SearchedLoaders, with room for every loader in the process
+#define STACK_ALLOC_SEARCHED_LOADERS(_name, _state)  \
+    uint64_t __##_name##_cache_bits[1 + dyld4::Loader::SearchedLoaders::bitmapWordCount((_state).config.dyldCache.dylibCount)]; \
+    uint64_t __##_name##_others_alloc[1 + (_state).loaded.size()]; \
+    __block dyld4::Loader::SearchedLoaders _name(__##_name##_cache_bits, (_state).config.dyldCache.dylibCount, \
+                                          (const dyld4::Loader**)__##_name##_others_alloc, (uint32_t)(_state).loaded.size());
+
 #endif /* Loader_h */
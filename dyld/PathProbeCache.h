@@ -0,0 +1,279 @@
+/*
+ * Copyright (c) 2025 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef PathProbeCache_h
+#define PathProbeCache_h
+
+#include <errno.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+#include <TargetConditionals.h>
+
+#include "Defines.h"
+#include "Allocator.h"
+#include "Vector.h"
+#include "MurmurHash.h"
+#include "DyldProcessConfig.h"
+#include "DyldRuntimeState.h"
+
+namespace dyld4 {
+
+//
+// Remembers which possible dylib paths are missing, so that searching DYLD_LIBRARY_PATH, @rpath, and the
+// fallback paths does not stat() the same missing file over and over.  After a few misses in one directory,
+// the whole directory is listed once and later probes in it are answered from the listing.  Only absence is
+// ever answered from the cache.  If a file might exist, it is always stat()ed, as the caller needs its FileID.
+//
+// The cache only lives for one top level load (launch, or one dlopen), as files can come and go in between.
+//
+class VIS_HIDDEN PathProbeCache
+{
+public:
+    struct Stats
+    {
+        uint32_t    probes          = 0;
+        uint32_t    cacheHits       = 0;
+        uint32_t    stats           = 0;
+        uint32_t    dirListings     = 0;
+    };
+
+                    PathProbeCache(Allocator& alloc) : _allocator(alloc), _dirs(alloc), _listedLeafs(alloc), _missingPaths(alloc) { }
+                    ~PathProbeCache() { clear(); }
+
+    // same as ProcessConfig::fileExists(), but may answer from the cache if the file is missing
+    bool            fileExists(const ProcessConfig& config, const char* path, FileID* fileID, int* errNum)
+    {
+        ++_stats.probes;
+
+        const char* lastSlash = strrchr(path, '/');
+        if ( (lastSlash == nullptr) || (lastSlash == path) || (lastSlash[1] == '\0') )
+            return stat(config, path, fileID, errNum);
+
+        uint64_t pathHash = hashPath(path, strlen(path));
+        for ( const MissingPath& missing : _missingPaths ) {
+            if ( (missing.hash == pathHash) && (strcmp(missing.path, path) == 0) )
+                return cacheHit(missing.errNum, errNum);
+        }
+
+        Dir& dir = findOrAddDir(path, lastSlash - path);
+        if ( (dir.state == Dir::State::unlisted) && (dir.misses >= kMissesBeforeListing) )
+            listDir(config, dir);
+
+        if ( dir.state == Dir::State::missing )
+            return cacheHit(dir.errNum, errNum);
+
+        // the listing is only used for plain ascii names, as the file system may compare names case and unicode insensitively
+        const char* leafName = lastSlash + 1;
+        uint64_t    leafHash = 0;
+        if ( (dir.state == Dir::State::listed) && hashLeaf(leafName, dir.hash, leafHash) ) {
+            if ( !std::binary_search(_listedLeafs.begin(), _listedLeafs.end(), leafHash) )
+                return cacheHit(ENOENT, errNum);
+        }
+
+        int  statErrNum = 0;
+        bool result     = stat(config, path, fileID, &statErrNum);
+        if ( errNum != nullptr )
+            *errNum = statErrNum;
+        if ( !result && ((statErrNum == ENOENT) || (statErrNum == ENOTDIR)) ) {
+            ++dir.misses;
+            _missingPaths.push_back({ pathHash, _allocator.strdup(path), statErrNum });
+        }
+        return result;
+    }
+
+    // forget everything, eg, because a nested dlopen() may have changed what is on disk
+    void            clear()
+    {
+        for ( Dir& dir : _dirs )
+            _allocator.free((void*)dir.path);
+        for ( MissingPath& missing : _missingPaths )
+            _allocator.free((void*)missing.path);
+        _dirs.clear();
+        _listedLeafs.clear();
+        _missingPaths.clear();
+    }
+
+    const Stats&    stats() const { return _stats; }
+
+    //
+    // Enables the cache in RuntimeState for the lifetime of the scope.  A scope nested in another, eg, a dlopen()
+    // from an initializer during launch, reuses the outer cache, but clears it first
+    //
+    class Scope
+    {
+    public:
+                    Scope(RuntimeState& state) : _state(state), _cache(state.persistentAllocator)
+                    {
+                        if ( _state.pathProbeCache != nullptr ) {
+                            _state.pathProbeCache->clear();
+                        }
+                        else {
+                            _state.pathProbeCache = &_cache;
+                            _owner                = true;
+                        }
+                    }
+                    ~Scope() { end(); }
+
+        void        end()
+        {
+            if ( !_owner )
+                return;
+            _owner = false;
+            _state.pathProbeCache = nullptr;
+            const Stats& stats = _cache.stats();
+            if ( _state.config.log.searching && (stats.probes != 0) ) {
+                _state.log("path probes: %u probes, %u answered from cache, %u stat() calls, %u directories listed\n",
+                           stats.probes, stats.cacheHits, stats.stats, stats.dirListings);
+            }
+            _cache.clear();
+        }
+
+    private:
+        RuntimeState&   _state;
+        PathProbeCache  _cache;
+        bool            _owner = false;
+    };
+
+private:
+    // don't list a directory until it has missed a couple of times, as listing costs more than a stat()
+    static const uint32_t kMissesBeforeListing  = 2;
+    // don't cache huge directories, eg, /usr/lib
+    static const uint32_t kMaxListedEntries     = 2048;
+
+    struct Dir
+    {
+        enum class State : uint8_t { unlisted, listed, missing, unlistable };
+
+        uint64_t        hash;
+        const char*     path;
+        uint32_t        misses;
+        int             errNum;
+        State           state;
+    };
+
+    struct MissingPath
+    {
+        uint64_t        hash;
+        const char*     path;
+        int             errNum;
+    };
+
+    bool            stat(const ProcessConfig& config, const char* path, FileID* fileID, int* errNum)
+    {
+        ++_stats.stats;
+        return config.fileExists(path, fileID, errNum);
+    }
+
+    bool            cacheHit(int cachedErrNum, int* errNum)
+    {
+        ++_stats.cacheHits;
+        if ( errNum != nullptr )
+            *errNum = cachedErrNum;
+        return false;
+    }
+
+    static uint64_t hashPath(const char* path, size_t length)
+    {
+        return murmurHash(path, (int)length, 0);
+    }
+
+    // hashes the leaf name folded to lower case, mixed with the directory hash.  Returns false if the name is not plain ascii
+    static bool     hashLeaf(const char* leafName, uint64_t dirHash, uint64_t& hash)
+    {
+        char   folded[256];
+        size_t length = 0;
+        for ( const char* s = leafName; *s != '\0'; ++s ) {
+            uint8_t c = (uint8_t)*s;
+            if ( (c >= 0x80) || (length == sizeof(folded)) )
+                return false;
+            folded[length++] = ((c >= 'A') && (c <= 'Z')) ? (char)(c + ('a' - 'A')) : (char)c;
+        }
+        hash = murmurHash(folded, (int)length, dirHash);
+        return true;
+    }
+
+    Dir&            findOrAddDir(const char* path, size_t dirLength)
+    {
+        uint64_t dirHash = hashPath(path, dirLength);
+        for ( Dir& dir : _dirs ) {
+            if ( (dir.hash == dirHash) && (strncmp(dir.path, path, dirLength) == 0) && (dir.path[dirLength] == '\0') )
+                return dir;
+        }
+        char* dirPath = (char*)_allocator.malloc(dirLength + 1);
+        memcpy(dirPath, path, dirLength);
+        dirPath[dirLength] = '\0';
+        _dirs.push_back({ dirHash, dirPath, 0, 0, Dir::State::unlisted });
+        return _dirs.back();
+    }
+
+    void            listDir(const ProcessConfig& config, Dir& dir)
+    {
+        ++_stats.dirListings;
+        uint64_t          startCount = _listedLeafs.size();
+        __block uint32_t  entryCount = 0;
+        __block bool      usable     = true;
+        Vector<uint64_t>& leafs      = _listedLeafs;
+        uint64_t          dirHash    = dir.hash;
+#if TARGET_OS_EXCLAVEKIT
+        (void)config;
+        int listErrNum = ENOTSUP;
+#else
+        int listErrNum = config.syscall.listDirectory(dir.path, ^(const char* leafName, bool& stop) {
+            // a non-ascii name might match an ascii one on a case insensitive file system, so we can't trust the listing
+            uint64_t leafHash;
+            if ( (++entryCount > kMaxListedEntries) || !hashLeaf(leafName, dirHash, leafHash) ) {
+                usable = false;
+                stop   = true;
+                return;
+            }
+            leafs.push_back(leafHash);
+        });
+#endif
+
+        if ( (listErrNum == ENOENT) || (listErrNum == ENOTDIR) ) {
+            dir.state  = Dir::State::missing;
+            dir.errNum = listErrNum;
+        }
+        else if ( (listErrNum != 0) || !usable ) {
+            dir.state = Dir::State::unlistable;
+        }
+        else {
+            dir.state = Dir::State::listed;
+            std::sort(_listedLeafs.begin(), _listedLeafs.end());
+            return;
+        }
+        _listedLeafs.erase(_listedLeafs.begin() + startCount, _listedLeafs.end());
+    }
+
+    Allocator&              _allocator;
+    Vector<Dir>             _dirs;
+    Vector<uint64_t>        _listedLeafs;
+    Vector<MissingPath>     _missingPaths;
+    Stats                   _stats;
+};
+
+} // namespace dyld4
+
+#endif /* PathProbeCache_h */
@@ -31,6 +31,8 @@
 #include <sys/types.h>
 #include <sys/fcntl.h>
 
+#include <algorithm>
+
 #include "Defines.h"
 #include "Header.h"
 #include "UUID.h"
@@ -44,6 +46,9 @@
 #include "PrebuiltObjC.h"
 #include "PrebuiltSwift.h"
 #include "ObjCVisitor.h"
+#if BUILDING_DYLD
+#include "Tracing.h"
+#endif
 #include "OptimizerObjC.h"
 #include "objc-shared-cache.h"
 
@@ -206,6 +211,15 @@ PrebuiltLoader::BindTargetRef PrebuiltLoader::BindTargetRef::makeAbsolute(uint64
     return PrebuiltLoader::BindTargetRef(value);
 }
 
+PrebuiltLoader::BindTargetRef PrebuiltLoader::BindTargetRef::makeImageOffset(LoaderRef loaderRef, uint64_t runtimeOffset) {
+    BindTargetRef result(0ULL);
+    result._regular.kind      = Kind::imageOffset;
+    result._regular.loaderRef = *(uint16_t*)(&loaderRef);
+    result._regular.high8     = runtimeOffset >> 56;
+    result._regular.low38     = runtimeOffset & 0x3FFFFFFFFFULL;
+    return result;
+}
+
 PrebuiltLoader::BindTargetRef::BindTargetRef(uint64_t absoluteValue) {
     uint64_t low54 = absoluteValue & 0x003FFFFFFFFFFFFFULL;
     uint64_t high8 = absoluteValue >> 56;
@@ -500,7 +514,8 @@ void PrebuiltLoader::applyFixups(Diagnostics& diag, RuntimeState& state, DyldCac
 
     // build targets table
     STACK_ALLOC_OVERFLOW_SAFE_ARRAY(const void*, targetAddrs, 512);
-    for ( const BindTargetRef& target : this->bindTargets() ) {
+    targetAddrs.reserve(this->bindTargetRefsCount);
+    this->forEachBindTargetRef(^(const BindTargetRef& target, bool& stop) {
         void* value = (void*)(long)target.value(state);
         if ( state.config.log.fixups ) {
             if ( target.isAbsolute() )
@@ -509,7 +524,7 @@ void PrebuiltLoader::applyFixups(Diagnostics& diag, RuntimeState& state, DyldCac
                 state.log("<%s/bind#%llu> -> %p (%s+0x%08llX)\n", this->leafName(state), targetAddrs.count(), value, target.loaderRef().loader(state)->leafName(state), target.offset());
         }
         targetAddrs.push_back(value);
-    }
+    });
     if ( diag.hasError() )
         return;
 
@@ -876,9 +891,97 @@ Array<Loader::Region> PrebuiltLoader::segments() const
     return Array<Region>((Region*)((uint8_t*)this + regionsOffset), regionsCount, regionsCount);
 }
 
-const Array<PrebuiltLoader::BindTargetRef> PrebuiltLoader::bindTargets() const
+//
+// Images with many bind targets store them as a stream instead of an array of BindTargetRef:
+//
+//    uleb128           dictionary count
+//    BindTargetRef[]   dictionary of targets which are used more than once
+//    runs, until there are bindTargetRefsCount targets, each starting with a uleb128 of (target count << 2) | BindTargetRunKind
+//      sameLoader:     uleb128 LoaderRef, then an sleb128 per target of its offset minus the offset of the previous target in the run
+//      dictionary:     uleb128 dictionary index per target
+//      raw:            BindTargetRef per target (absolute values and function variants)
+//
+// Binds into the same dylib tend to be next to each other, so most targets end up as a 2 to 4 byte delta instead of 8 bytes.
+//
+enum class BindTargetRunKind : uint8_t { sameLoader = 0, dictionary = 1, raw = 2 };
+
+static uint64_t readBindTargetUleb(const uint8_t*& p)
+{
+    uint64_t result = 0;
+    uint32_t bit    = 0;
+    uint8_t  byte;
+    do {
+        byte = *p++;
+        result |= ((uint64_t)(byte & 0x7F) << bit);
+        bit += 7;
+    } while ( byte & 0x80 );
+    return result;
+}
+
+static int64_t readBindTargetSleb(const uint8_t*& p)
 {
-    return Array<BindTargetRef>((BindTargetRef*)((uint8_t*)this + bindTargetRefsOffset), bindTargetRefsCount, bindTargetRefsCount);
+    int64_t  result = 0;
+    uint32_t bit    = 0;
+    uint8_t  byte;
+    do {
+        byte = *p++;
+        result |= ((uint64_t)(byte & 0x7F) << bit);
+        bit += 7;
+    } while ( byte & 0x80 );
+    // sign extend negative numbers
+    if ( ((byte & 0x40) != 0) && (bit < 64) )
+        result |= (~0ULL) << bit;
+    return result;
+}
+
+static PrebuiltLoader::BindTargetRef readBindTargetRef(const uint8_t*& p)
+{
+    PrebuiltLoader::BindTargetRef result = PrebuiltLoader::BindTargetRef::makeAbsolute(0);
+    memcpy((void*)&result, p, sizeof(result));
+    p += sizeof(result);
+    return result;
+}
+
+void PrebuiltLoader::forEachBindTargetRef(void (^callback)(const BindTargetRef& target, bool& stop)) const
+{
+    const uint8_t* p    = (uint8_t*)this + bindTargetRefsOffset;
+    bool           stop = false;
+    if ( !this->hasCompressedBindTargets ) {
+        for ( uint32_t i = 0; (i < bindTargetRefsCount) && !stop; ++i )
+            callback(((const BindTargetRef*)p)[i], stop);
+        return;
+    }
+
+    const uint64_t  dictionaryCount = readBindTargetUleb(p);
+    const uint8_t*  dictionary      = p;
+    p += dictionaryCount * sizeof(BindTargetRef);
+    for ( uint32_t targetIndex = 0; (targetIndex < bindTargetRefsCount) && !stop; ) {
+        const uint64_t          runHeader = readBindTargetUleb(p);
+        const BindTargetRunKind kind      = (BindTargetRunKind)(runHeader & 3);
+        const uint64_t          runCount  = runHeader >> 2;
+        uint64_t                rawLoaderRef = 0;
+        uint64_t                offset       = 0;
+        if ( kind == BindTargetRunKind::sameLoader )
+            rawLoaderRef = readBindTargetUleb(p);
+        for ( uint64_t i = 0; (i < runCount) && !stop; ++i, ++targetIndex ) {
+            switch ( kind ) {
+                case BindTargetRunKind::sameLoader: {
+                    uint16_t loaderRef16 = (uint16_t)rawLoaderRef;
+                    offset += readBindTargetSleb(p);
+                    callback(BindTargetRef::makeImageOffset(*(LoaderRef*)&loaderRef16, offset), stop);
+                    break;
+                }
+                case BindTargetRunKind::dictionary: {
+                    const uint8_t* entry = dictionary + readBindTargetUleb(p) * sizeof(BindTargetRef);
+                    callback(readBindTargetRef(entry), stop);
+                    break;
+                }
+                case BindTargetRunKind::raw:
+                    callback(readBindTargetRef(p), stop);
+                    break;
+            }
+        }
+    }
 }
 
 const Array<PrebuiltLoader::BindTargetRef> PrebuiltLoader::overrideBindTargets() const
@@ -1262,6 +1365,118 @@ void PrebuiltLoader::printObjCFixups(RuntimeState& state, FILE* out) const
 }
 #endif // BUILDING_CLOSURE_UTIL
 
+static void appendBindTargetUleb(OverflowSafeArray<uint8_t>& bytes, uint64_t value)
+{
+    do {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        if ( value != 0 )
+            byte |= 0x80;
+        bytes.push_back(byte);
+    } while ( value != 0 );
+}
+
+static void appendBindTargetSleb(OverflowSafeArray<uint8_t>& bytes, int64_t value)
+{
+    bool more = true;
+    while ( more ) {
+        uint8_t byte = value & 0x7F;
+        value >>= 7;
+        more = !(((value == 0) && ((byte & 0x40) == 0)) || ((value == -1) && ((byte & 0x40) != 0)));
+        if ( more )
+            byte |= 0x80;
+        bytes.push_back(byte);
+    }
+}
+
+static void appendBindTargetRef(OverflowSafeArray<uint8_t>& bytes, const PrebuiltLoader::BindTargetRef& target)
+{
+    const uint8_t* p = (const uint8_t*)&target;
+    for ( size_t i = 0; i != sizeof(target); ++i )
+        bytes.push_back(p[i]);
+}
+
+static uint64_t rawBindTargetRef(const PrebuiltLoader::BindTargetRef& target)
+{
+    uint64_t result;
+    memcpy(&result, (const void*)&target, sizeof(result));
+    return result;
+}
+
+// Encodes the targets in the stream format described at forEachBindTargetRef().  Returns false if the image has too few
+// bind targets to bother, or if the stream would not be smaller than the plain array
+static bool compressBindTargets(const Array<PrebuiltLoader::BindTargetRef>& targets, OverflowSafeArray<uint8_t>& stream)
+{
+    const uint64_t kMinCompressedBindTargets = 64;
+    if ( targets.count() < kMinCompressedBindTargets )
+        return false;
+
+    // targets used more than once go in the dictionary, which is sorted so that it can be binary searched
+    STACK_ALLOC_OVERFLOW_SAFE_ARRAY(uint64_t, sortedTargets, 512);
+    for ( const PrebuiltLoader::BindTargetRef& target : targets )
+        sortedTargets.push_back(rawBindTargetRef(target));
+    std::sort(sortedTargets.begin(), sortedTargets.end());
+    STACK_ALLOC_OVERFLOW_SAFE_ARRAY(uint64_t, dictionary, 64);
+    for ( uint64_t i = 1; i < sortedTargets.count(); ++i ) {
+        if ( (sortedTargets[i] == sortedTargets[i-1]) && (dictionary.empty() || (dictionary.back() != sortedTargets[i])) )
+            dictionary.push_back(sortedTargets[i]);
+    }
+    auto dictionaryIndex = [&](const PrebuiltLoader::BindTargetRef& target) -> int64_t {
+        const uint64_t* pos = std::lower_bound(dictionary.begin(), dictionary.end(), rawBindTargetRef(target));
+        if ( (pos == dictionary.end()) || (*pos != rawBindTargetRef(target)) )
+            return -1;
+        return pos - dictionary.begin();
+    };
+    auto runKind = [&](const PrebuiltLoader::BindTargetRef& target) -> BindTargetRunKind {
+        uint64_t fvTableOffset;
+        uint16_t variantIndex;
+        if ( dictionaryIndex(target) != -1 )
+            return BindTargetRunKind::dictionary;
+        if ( target.isAbsolute() || target.isFunctionVariant(fvTableOffset, variantIndex) )
+            return BindTargetRunKind::raw;
+        return BindTargetRunKind::sameLoader;
+    };
+    auto rawLoaderRef = [](const PrebuiltLoader::BindTargetRef& target) -> uint16_t {
+        PrebuiltLoader::LoaderRef loaderRef = target.loaderRef();
+        return *(uint16_t*)&loaderRef;
+    };
+
+    appendBindTargetUleb(stream, dictionary.count());
+    for ( uint64_t rawTarget : dictionary ) {
+        for ( size_t i = 0; i != sizeof(rawTarget); ++i )
+            stream.push_back(((const uint8_t*)&rawTarget)[i]);
+    }
+    for ( uint64_t runStart = 0; runStart < targets.count(); ) {
+        // a run is consecutive targets of the same kind, and for sameLoader runs, in the same loader
+        const BindTargetRunKind kind   = runKind(targets[runStart]);
+        uint64_t                runEnd = runStart + 1;
+        while ( (runEnd < targets.count()) && (runKind(targets[runEnd]) == kind)
+               && ((kind != BindTargetRunKind::sameLoader) || (rawLoaderRef(targets[runEnd]) == rawLoaderRef(targets[runStart]))) )
+            ++runEnd;
+
+        appendBindTargetUleb(stream, ((runEnd - runStart) << 2) | (uint64_t)kind);
+        if ( kind == BindTargetRunKind::sameLoader )
+            appendBindTargetUleb(stream, rawLoaderRef(targets[runStart]));
+        uint64_t lastOffset = 0;
+        for ( uint64_t i = runStart; i != runEnd; ++i ) {
+            switch ( kind ) {
+                case BindTargetRunKind::sameLoader:
+                    appendBindTargetSleb(stream, (int64_t)(targets[i].offset() - lastOffset));
+                    lastOffset = targets[i].offset();
+                    break;
+                case BindTargetRunKind::dictionary:
+                    appendBindTargetUleb(stream, dictionaryIndex(targets[i]));
+                    break;
+                case BindTargetRunKind::raw:
+                    appendBindTargetRef(stream, targets[i]);
+                    break;
+            }
+        }
+        runStart = runEnd;
+    }
+    return (stream.count() < (targets.count() * sizeof(PrebuiltLoader::BindTargetRef)));
+}
+
 void PrebuiltLoader::serialize(Diagnostics& diag, RuntimeState& state, const JustInTimeLoader& jitLoader, LoaderRef buildRef,
                                CacheWeakDefOverride cacheWeakDefFixup, PrebuiltObjC& prebuiltObjC,
                                const PrebuiltSwift& prebuiltSwift, BumpAllocator& allocator)
@@ -1375,6 +1590,7 @@ void PrebuiltLoader::serialize(Diagnostics& diag, RuntimeState& state, const Jus
     p->supportsCatalyst     = buildingMacOSCache && ((mach_o::Header*)mf)->builtForPlatform(Platform::macCatalyst);
     p->isCatalystOverride   = false;
     p->indexOfTwin          = kNoUnzipperedTwin;
+    p->hasCompressedBindTargets = false;
     p->reserved1            = 0;
     if ( buildingMacOSCache ) {
         // check if this is part of an unzippered twin
@@ -1411,7 +1627,7 @@ void PrebuiltLoader::serialize(Diagnostics& diag, RuntimeState& state, const Jus
         uint64_t off           = allocator.size() - serializationStart;
         p->bindTargetRefsOffset = off;
         assert(p->bindTargetRefsOffset == off && "uint16_t bindTargetRefsOffset overflow");
-        p->bindTargetRefsCount = 0;
+        STACK_ALLOC_OVERFLOW_SAFE_ARRAY(BindTargetRef, bindTargets, 512);
         jitLoader.forEachBindTarget(diag, state, cacheWeakDefFixup, true, ^(const ResolvedSymbol& resolvedTarget, bool& stop) {
             // Regular and lazy binds
             BindTargetRef bindRef(diag, state, resolvedTarget);
@@ -1419,9 +1635,7 @@ void PrebuiltLoader::serialize(Diagnostics& diag, RuntimeState& state, const Jus
                 stop = true;
                 return;
             }
-            allocator.append(&bindRef, sizeof(BindTargetRef));
-            p->bindTargetRefsCount += 1;
-            assert(p->bindTargetRefsCount != 0 && "bindTargetRefsCount overflow");
+            bindTargets.push_back(bindRef);
         }, ^(const ResolvedSymbol& resolvedTarget, bool& stop) {
             // Opcode based weak binds
             BindTargetRef bindRef(diag, state, resolvedTarget);
@@ -1433,6 +1647,19 @@ void PrebuiltLoader::serialize(Diagnostics& diag, RuntimeState& state, const Jus
         });
         if ( diag.hasError() )
             return;
+        p->bindTargetRefsCount = (uint32_t)bindTargets.count();
+        assert(p->bindTargetRefsCount == bindTargets.count() && "bindTargetRefsCount overflow");
+
+        STACK_ALLOC_OVERFLOW_SAFE_ARRAY(uint8_t, compressedBindTargets, 4096);
+        if ( compressBindTargets(bindTargets, compressedBindTargets) ) {
+            p->hasCompressedBindTargets = true;
+            allocator.append(compressedBindTargets.data(), compressedBindTargets.count());
+            // the stream is byte granular, but whatever follows it, including the next PrebuiltLoader, needs 8-byte alignment
+            allocator.align(8);
+        }
+        else if ( !bindTargets.empty() ) {
+            allocator.append(bindTargets.data(), sizeof(BindTargetRef) * bindTargets.count());
+        }
     }
 
     // Everything from this point onwards needs 32-bit offsets
@@ -1636,9 +1863,9 @@ void PrebuiltLoader::print(RuntimeState& state, FILE* out, bool printComments) c
     fprintf(out, "\n      ]");
     if ( bindTargetRefsOffset != 0 ) {
         fprintf(out, ",\n      \"targets\": [");
-        needComma = false;
-        for ( const BindTargetRef& target : this->bindTargets() ) {
-            if ( needComma )
+        __block bool needTargetComma = false;
+        this->forEachBindTargetRef(^(const BindTargetRef& target, bool& stop) {
+            if ( needTargetComma )
                 fprintf(out, ",");
             fprintf(out, "\n          {\n");
             if ( target.isAbsolute() ) {
@@ -1661,8 +1888,8 @@ void PrebuiltLoader::print(RuntimeState& state, FILE* out, bool printComments) c
                 }
             }
             fprintf(out, "          }");
-            needComma = true;
-        }
+            needTargetComma = true;
+        });
         fprintf(out, "\n      ]");
     }
 
@@ -2230,7 +2457,8 @@ void PrebuiltLoaderSet::print(RuntimeState& state, FILE* out, bool printComments
 }
 #endif // BUILDING_CLOSURE_UTIL
 
-const PrebuiltLoaderSet* PrebuiltLoaderSet::makeLaunchSet(Diagnostics& diag, RuntimeState& state, const MissingPaths& mustBeMissingPaths)
+const PrebuiltLoaderSet* PrebuiltLoaderSet::makeLaunchSet(Diagnostics& diag, RuntimeState& state, const MissingPaths& mustBeMissingPaths,
+                                                          bool parallelObjC)
 {
 #if BUILDING_DYLD
     if ( !state.interposingTuplesAll.empty() || !state.patchedObjCClasses.empty() || !state.patchedSingletons.empty() ) {
@@ -2285,9 +2513,17 @@ const PrebuiltLoaderSet* PrebuiltLoaderSet::makeLaunchSet(Diagnostics& diag, Run
     PrebuiltSwift prebuiltSwift;
     {
         Diagnostics objcDiag;
-        prebuiltObjC.make(objcDiag, state);
+        {
+#if BUILDING_DYLD
+            dyld3::ScopedTimer timer(DBG_DYLD_TIMING_BUILD_CLOSURE_OBJC, 0, 0, 0);
+#endif
+            prebuiltObjC.make(objcDiag, state, parallelObjC);
+        }
 
         if ( !objcDiag.hasError() ) {
+#if BUILDING_DYLD
+            dyld3::ScopedTimer timer(DBG_DYLD_TIMING_BUILD_CLOSURE_SWIFT, 0, 0, 0);
+#endif
             Diagnostics swiftDiag;
             prebuiltSwift.make(swiftDiag, prebuiltObjC, state);
         }
@@ -102,6 +102,9 @@ public:
         // To support ObjC, which wants to create pointers to values without symbols,
         // we need to allow creating references to arbitrary locations in the binaries
         static BindTargetRef makeAbsolute(uint64_t value);
+
+        // Used to rebuild targets from the compressed bind target encoding
+        static BindTargetRef makeImageOffset(LoaderRef loaderRef, uint64_t runtimeOffset);
     private:
         // To support the make* functions, we allow private constructors for values
         BindTargetRef(uint64_t absoluteValue);
@@ -154,7 +157,8 @@ public:
 
     uint32_t            objcBinaryInfoOffset;           // zero or offset to ObjCBinaryInfo
     uint16_t            indexOfTwin;                    // if in dyld cache and part of unzippered twin, then index of the other twin
-    uint16_t            reserved1;
+    uint16_t            hasCompressedBindTargets :  1,  // bind targets are a compressed stream, not an array of BindTargetRef
+                        reserved1                : 15;
 
     uint64_t            exportsTrieLoaderOffset;
     uint32_t            exportsTrieLoaderSize;
@@ -250,7 +254,7 @@ private:
     void                        setMF(RuntimeState& state, const dyld3::MachOFile* mf) const;
 #endif
     Array<Region>               segments() const;
-    const Array<BindTargetRef>  bindTargets() const;
+    void                        forEachBindTargetRef(void (^callback)(const BindTargetRef& target, bool& stop)) const;
     const Array<BindTargetRef>  overrideBindTargets() const;
     const FileValidationInfo*   fileValidationInfo() const;
     void                        applyObjCFixups(RuntimeState& state) const;
@@ -298,7 +302,8 @@ struct PrebuiltLoaderSet
     void                    forEachCachePatch(void (^handler)(const CachePatch&)) const;
 
 
-    static const PrebuiltLoaderSet*   makeLaunchSet(Diagnostics&, RuntimeState&, const MissingPaths&);
+    // parallelObjC visits the images concurrently when building the objc tables.  Only the tools support it
+    static const PrebuiltLoaderSet*   makeLaunchSet(Diagnostics&, RuntimeState&, const MissingPaths&, bool parallelObjC = false);
 #if BUILDING_CACHE_BUILDER || BUILDING_CACHE_BUILDER_UNIT_TESTS
     static const PrebuiltLoaderSet*   makeDyldCachePrebuiltLoaders(Diagnostics& diag, RuntimeState& state, const Array<const Loader*>& jitLoaders);
 #endif
@@ -44,6 +44,10 @@
 #include "PrebuiltObjC.h"
 #include "objc-shared-cache.h"
 
+#if BUILDING_CACHE_BUILDER || BUILDING_CLOSURE_UTIL
+#include <dispatch/dispatch.h>
+#endif
+
 using mach_o::Header;
 
 #if SUPPORT_PREBUILTLOADERS || BUILDING_UNIT_TESTS || BUILDING_CACHE_BUILDER_UNIT_TESTS
@@ -304,9 +308,17 @@ void ObjCOptimizerImage::visitReferenceToObjCSelector(const objc::SelectorHashTa
 
         //printf("Overriding fixup at 0x%08llX to cache offset 0x%08llX\n", selectorUseImageOffset, (uint64_t)objcSelOpt->getEntryForIndex(cacheSelectorIndex) - (uint64_t)state.config.dyldCache());
         selectorFixups.push_back(bindTarget);
+#if BUILDING_CACHE_BUILDER || BUILDING_CLOSURE_UTIL
+        selectorFixupStrings.push_back(nullptr);
+#endif
         return;
     }
 
+#if BUILDING_CACHE_BUILDER || BUILDING_CLOSURE_UTIL
+    // All the other cases below add a fixup for this string
+    selectorFixupStrings.push_back(selectorString);
+#endif
+
     // See if this selector is already in the app map from a previous image
     prebuilt_objc::ObjCStringKey selectorMapKey { selectorString };
     auto appSelectorIt = appSelectorMap.find(selectorMapKey);
@@ -628,11 +640,8 @@ static void optimizeObjCClasses(RuntimeState& state,
     if ( image.binaryInfo.classListCount == 0 )
         return;
 
-#if BUILDING_CACHE_BUILDER || BUILDING_CLOSURE_UTIL
-    image.calculateMissingWeakImports(state);
-    if ( image.diag.hasError() )
-        return;
-#endif
+    // Note the missing weak imports must have been calculated before calling this.  That binds symbols
+    // through the RuntimeState, so isn't safe to do when visiting images in parallel
 
     // FIXME: Don't make a duplicate one of these if we can pass one in instead
     __block objc_visitor::Visitor objcVisitor = makeObjCVisitor(image.diag, state, image.jitLoader);
@@ -855,6 +864,43 @@ void PrebuiltObjC::commitImage(const ObjCOptimizerImage& image)
     }
 }
 
+#if BUILDING_CACHE_BUILDER || BUILDING_CLOSURE_UTIL
+void PrebuiltObjC::mergeImageSelectors(ObjCOptimizerImage& image) const
+{
+    // If no earlier image added any selectors, then the image's results are already correct
+    if ( this->selectorMap.empty() )
+        return;
+
+    assert(image.selectorFixupStrings.count() == image.selectorFixups.count());
+
+    // Rebuild the image selector map, with only the selectors which weren't in an earlier image.
+    // We walk the fixups in order so that the map is in the same order as if we'd visited serially
+    SelectorMapTy imageSelectorMap;
+    for ( uint64_t i = 0; i != image.selectorFixups.count(); ++i ) {
+        const char* selectorString = image.selectorFixupStrings[i];
+
+        // Shared cache selectors don't depend on earlier images
+        if ( selectorString == nullptr )
+            continue;
+
+        prebuilt_objc::ObjCStringKey selectorMapKey { selectorString };
+        auto appSelectorIt = this->selectorMap.find(selectorMapKey);
+        if ( appSelectorIt != this->selectorMap.end() ) {
+            // This selector was found in a previous image, so use it here.
+            image.selectorFixups[i] = PrebuiltLoader::BindTargetRef(appSelectorIt->second.nameLocation);
+            continue;
+        }
+
+        // The selector is in this image, so keep the location found while visiting
+        auto imageSelectorIt = image.selectorMap.find(selectorMapKey);
+        assert(imageSelectorIt != image.selectorMap.end());
+        imageSelectorMap.insert({ selectorMapKey, imageSelectorIt->second });
+    }
+
+    image.selectorMap = std::move(imageSelectorMap);
+}
+#endif // BUILDING_CACHE_BUILDER || BUILDING_CLOSURE_UTIL
+
 uint32_t PrebuiltObjC::serializeSelectorMap(dyld4::BumpAllocator& alloc) const
 {
     // The key on the new map is the name bind target
@@ -1235,8 +1281,12 @@ static std::optional<VMOffset> getProtocolClassCacheOffset(RuntimeState& state)
 #endif // BUILDING_CACHE_BUILDER
 }
 
-void PrebuiltObjC::make(Diagnostics& diag, RuntimeState& state)
+void PrebuiltObjC::make(Diagnostics& diag, RuntimeState& state, bool parallelImages)
 {
+#if !BUILDING_CACHE_BUILDER && !BUILDING_CLOSURE_UTIL
+    // dyld can't use threads here, so always visits the images in serial
+    parallelImages = false;
+#endif
 
     // If we have the read only data, make sure it has a valid selector table inside.
     const objc::ClassHashTable*    objcClassOpt             = state.config.dyldCache.objcClassHashTable;
@@ -1350,23 +1400,74 @@ void PrebuiltObjC::make(Diagnostics& diag, RuntimeState& state)
         getPointerBasedSection("__objc_protorefs", image.binaryInfo.protocolRefsRuntimeOffset, image.binaryInfo.protocolRefsCount);
     }
 
-    for ( ObjCOptimizerImage& image : objcImages ) {
-        if ( image.diag.hasError() )
-            continue;
+#if BUILDING_CACHE_BUILDER || BUILDING_CLOSURE_UTIL
+    if ( parallelImages ) {
+        // Finding missing weak imports binds symbols through the RuntimeState, so do that serially first
+        for ( ObjCOptimizerImage& image : objcImages ) {
+            if ( image.diag.hasError() || (image.binaryInfo.classListCount == 0) )
+                continue;
+            image.calculateMissingWeakImports(state);
+        }
 
-        optimizeObjCClasses(state, objcClassOpt, sharedCacheImagesMap, duplicateSharedCacheClassMap, image);
-        if ( image.diag.hasError() )
-            continue;
+        // Visit each image in parallel.  Each image only writes to its own ObjCOptimizerImage, and
+        // sees empty app-wide maps, as nothing has been committed yet
+        SharedCacheImagesMapTy&    imagesMap     = sharedCacheImagesMap;
+        DuplicateClassesMapTy&     duplicatesMap = duplicateSharedCacheClassMap;
+        SelectorMapTy&             appSelectors  = selectorMap;
+        Array<ObjCOptimizerImage>& images        = objcImages;
+        dispatch_apply(images.count(), DISPATCH_APPLY_AUTO, ^(size_t index) {
+            ObjCOptimizerImage& image = images[index];
+            if ( image.diag.hasError() )
+                return;
 
-        optimizeObjCProtocols(state, objcProtocolOpt, sharedCacheImagesMap, image);
-        if ( image.diag.hasError() )
-            continue;
+            optimizeObjCClasses(state, objcClassOpt, imagesMap, duplicatesMap, image);
+            if ( image.diag.hasError() )
+                return;
 
-        optimizeObjCSelectors(state, objcSelOpt, selectorMap, image);
-        if ( image.diag.hasError() )
-            continue;
+            optimizeObjCProtocols(state, objcProtocolOpt, imagesMap, image);
+            if ( image.diag.hasError() )
+                return;
+
+            optimizeObjCSelectors(state, objcSelOpt, appSelectors, image);
+        });
+
+        // Merge in load order, so that the result is the same as the serial walk below
+        for ( ObjCOptimizerImage& image : objcImages ) {
+            if ( image.diag.hasError() )
+                continue;
+
+            mergeImageSelectors(image);
+            commitImage(image);
+        }
+    } else
+#endif // BUILDING_CACHE_BUILDER || BUILDING_CLOSURE_UTIL
+    {
+        for ( ObjCOptimizerImage& image : objcImages ) {
+            if ( image.diag.hasError() )
+                continue;
 
-        commitImage(image);
+#if BUILDING_CACHE_BUILDER || BUILDING_CLOSURE_UTIL
+            if ( image.binaryInfo.classListCount != 0 ) {
+                image.calculateMissingWeakImports(state);
+                if ( image.diag.hasError() )
+                    continue;
+            }
+#endif
+
+            optimizeObjCClasses(state, objcClassOpt, sharedCacheImagesMap, duplicateSharedCacheClassMap, image);
+            if ( image.diag.hasError() )
+                continue;
+
+            optimizeObjCProtocols(state, objcProtocolOpt, sharedCacheImagesMap, image);
+            if ( image.diag.hasError() )
+                continue;
+
+            optimizeObjCSelectors(state, objcSelOpt, selectorMap, image);
+            if ( image.diag.hasError() )
+                continue;
+
+            commitImage(image);
+        }
     }
 
     // If we successfully analyzed the classes and selectors, we can now make the maps
@@ -1374,11 +1475,28 @@ void PrebuiltObjC::make(Diagnostics& diag, RuntimeState& state)
 
     // Once we have the hash tables with the canonical protocols, we can generate the fixups
     // for the protorefs, which need to point to the canonical protocol
-    for ( ObjCOptimizerImage& image : objcImages ) {
-        if ( image.diag.hasError() )
-            continue;
+#if BUILDING_CACHE_BUILDER || BUILDING_CLOSURE_UTIL
+    if ( parallelImages ) {
+        // The protocol map is complete now, so each image can be visited independently
+        SharedCacheImagesMapTy&    imagesMap = sharedCacheImagesMap;
+        ProtocolMapTy&             protocols = protocolMap;
+        Array<ObjCOptimizerImage>& images    = objcImages;
+        dispatch_apply(images.count(), DISPATCH_APPLY_AUTO, ^(size_t index) {
+            ObjCOptimizerImage& image = images[index];
+            if ( image.diag.hasError() )
+                return;
 
-        optimizeObjCProtocolReferences(state, objcProtocolOpt, sharedCacheImagesMap, protocolMap, image);
+            optimizeObjCProtocolReferences(state, objcProtocolOpt, imagesMap, protocols, image);
+        });
+    } else
+#endif // BUILDING_CACHE_BUILDER || BUILDING_CLOSURE_UTIL
+    {
+        for ( ObjCOptimizerImage& image : objcImages ) {
+            if ( image.diag.hasError() )
+                continue;
+
+            optimizeObjCProtocolReferences(state, objcProtocolOpt, sharedCacheImagesMap, protocolMap, image);
+        }
     }
 
     uint32_t pointerSize = state.mainExecutableLoader->mf(state)->pointerSize();
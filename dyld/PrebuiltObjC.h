@@ -322,6 +322,13 @@ struct PrebuiltObjC
         dyld3::OverflowSafeArray<PrebuiltLoader::BindTargetRef> selectorFixups;
         SelectorMapTy                                           selectorMap;
 
+#if BUILDING_CACHE_BUILDER || BUILDING_CLOSURE_UTIL
+        // The selector string for each entry in selectorFixups, or nullptr if the fixup is to the shared cache.
+        // Images visited in parallel can't see the selectors from earlier images, so this lets us fix them
+        // up when we merge the images in order
+        dyld3::OverflowSafeArray<const char*>                   selectorFixupStrings;
+#endif
+
         // Protocol optimization data structures
         dyld3::OverflowSafeArray<PrebuiltLoader::BindTargetRef> protocolFixups;
 
@@ -331,11 +338,19 @@ struct PrebuiltObjC
     PrebuiltObjC() = default;
     ~PrebuiltObjC() = default;
 
-    void make(Diagnostics& diag, RuntimeState& state);
+    // If parallelImages is set, then the images are visited concurrently, and their results are merged
+    // in load order afterwards.  This is only supported in the tools, not in dyld itself
+    void make(Diagnostics& diag, RuntimeState& state, bool parallelImages = false);
 
     // Adds the results from this image to the tables for the whole app
     void commitImage(const ObjCOptimizerImage& image);
 
+#if BUILDING_CACHE_BUILDER || BUILDING_CLOSURE_UTIL
+    // Images visited in parallel didn't know about the selectors in earlier images.  This updates
+    // the image's selector fixups and map to match what a serial walk would have produced
+    void mergeImageSelectors(ObjCOptimizerImage& image) const;
+#endif
+
     // Generates the hash tables for classes and protocols.  Selectors are done already
     // We need to do this so that Swift can use the classMap later
     void generateHashTables();
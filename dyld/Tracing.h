@@ -76,6 +76,8 @@
 #define DBG_DYLD_REMOTE_IMAGE_NOTIFIER          (KDBG_CODE(DBG_DYLD, DBG_DYLD_INTERNAL_SUBCLASS, 12))
 #define DBG_DYLD_TIMING_BOOTSTRAP_START         (KDBG_CODE(DBG_DYLD, DBG_DYLD_INTERNAL_SUBCLASS, 13))
 #define DBG_DYLD_TIMING_VALIDATE_CLOSURE        (KDBG_CODE(DBG_DYLD, DBG_DYLD_INTERNAL_SUBCLASS, 14))
+#define DBG_DYLD_TIMING_BUILD_CLOSURE_OBJC      (KDBG_CODE(DBG_DYLD, DBG_DYLD_INTERNAL_SUBCLASS, 15))
+#define DBG_DYLD_TIMING_BUILD_CLOSURE_SWIFT     (KDBG_CODE(DBG_DYLD, DBG_DYLD_INTERNAL_SUBCLASS, 16))
 
 #define DBG_DYLD_TIMING_DLOPEN                  (KDBG_CODE(DBG_DYLD, DBG_DYLD_API_SUBCLASS, 0))
 #define DBG_DYLD_TIMING_DLOPEN_PREFLIGHT        (KDBG_CODE(DBG_DYLD, DBG_DYLD_API_SUBCLASS, 1))
@@ -79,6 +79,8 @@
 #include "DyldProcessConfig.h"
 #include "DyldRuntimeState.h"
 #include "DyldAPIs.h"
+#include "PathProbeCache.h"
+#include "AllocatorTrace.h"
 #include "ExternallyViewableState.h"
 
 #if !TARGET_OS_EXCLAVEKIT
@@ -95,6 +97,7 @@ using dyld3::MachOFile;
 using dyld3::MachOLoaded;
 using mach_o::Header;
 using lsl::Allocator;
+using lsl::AllocatorTraceRecorder;
 
 #if TARGET_OS_EXCLAVEKIT
   extern "C" void bootinfo_init(uintptr_t bootinfo);
@@ -529,6 +532,50 @@ static bool hasProgramVars(const Header* mainHdr, ProgramVars*& progVars, bool&
 #endif
 
 
+#if !TARGET_OS_EXCLAVEKIT
+// DYLD_PRINT_ALLOCATOR_STATS and DYLD_ALLOCATOR_TRACE_FILE instrument the persistent allocator, to help size its pools
+static void startAllocatorInstrumentation(RuntimeState& state)
+{
+    Allocator& allocator = state.persistentAllocator;
+    if ( state.config.log.allocator )
+        allocator.setStatistics(new (allocator.malloc(sizeof(Allocator::Statistics))) Allocator::Statistics());
+    if ( state.config.log.allocatorTraceDescriptor != -1 )
+        allocator.setTraceRecorder(new (allocator.malloc(sizeof(AllocatorTraceRecorder))) AllocatorTraceRecorder(state.config.log.allocatorTraceDescriptor));
+}
+
+static void finishAllocatorInstrumentation(RuntimeState& state)
+{
+    Allocator& allocator = state.persistentAllocator;
+    if ( AllocatorTraceRecorder* recorder = allocator.traceRecorder() ) {
+        // later calls are only written out when the recorder's buffer fills up
+        MemoryManager::withWritableMemory([&] {
+            recorder->flush();
+        });
+    }
+    const Allocator::Statistics* stats = allocator.statistics();
+    if ( stats == nullptr )
+        return;
+    Allocator::PoolUsage usage = allocator.poolUsage();
+    state.log("allocator: %llu allocated bytes (peak %llu), %llu pools using %llu bytes\n",
+              allocator.allocated_bytes(), stats->peakAllocatedBytes, usage.poolCount, usage.poolBytes);
+    state.log("allocator: %llu allocs, %llu frees, %llu reallocs (%llu failed)\n",
+              stats->allocations, stats->frees, stats->reallocs, stats->failedReallocs);
+    state.log("allocator: %llu free bytes, %llu in %llu holes (largest %llu), %llu%% fragmented\n",
+              usage.freeBytes, usage.holeBytes, usage.holeCount, usage.largestHole, usage.fragmentationPercent());
+    for ( uint32_t i = 0; i != Allocator::Statistics::kSizeClassCount; ++i ) {
+        const Allocator::Statistics::SizeClass& sizeClass = stats->sizeClasses[i];
+        if ( (sizeClass.allocations == 0) && (sizeClass.liveCount == 0) )
+            continue;
+        if ( i == Allocator::Statistics::kSizeClassCount - 1 )
+            state.log("allocator:   >%6llu bytes: %llu allocs, %llu live (peak %llu)\n", Allocator::Statistics::sizeClassLimit(i - 1),
+                      sizeClass.allocations, sizeClass.liveCount, sizeClass.peakLiveCount);
+        else
+            state.log("allocator:  <=%6llu bytes: %llu allocs, %llu live (peak %llu)\n", Allocator::Statistics::sizeClassLimit(i),
+                      sizeClass.allocations, sizeClass.liveCount, sizeClass.peakLiveCount);
+    }
+}
+#endif // !TARGET_OS_EXCLAVEKIT
+
 //
 // Load any dependent dylibs and bind all together.
 // Returns address of main() in target.
@@ -634,6 +681,8 @@ __attribute__((noinline)) static MainFunc prepare(APIs& state, const Header* dyl
             state.log("Note: interposing disabled by AMFI\n");
    }
 
+    startAllocatorInstrumentation(state);
+
 #if TARGET_OS_OSX
     const bool isSimulatorProgram = state.config.process.platform.isSimulator();
     if ( const char* simPrefixPath = state.config.pathOverrides.simRootPath() ) {
@@ -699,6 +748,9 @@ __attribute__((noinline)) static MainFunc prepare(APIs& state, const Header* dyl
     const bool needToWritePrebuiltLoaderSet = !mainLoader->isPrebuilt && (state.saveAppClosureFile() || state.failIfCouldBuildAppClosureFile());
 #endif // SUPPORT_PREBUILTLOADERS
 
+    // cache missing paths while searching for everything loaded at launch
+    PathProbeCache::Scope pathProbeScope(state);
+
     // load any inserted dylibs
     STACK_ALLOC_OVERFLOW_SAFE_ARRAY(Loader*, topLevelLoaders, 16);
     topLevelLoaders.push_back(mainLoader);
@@ -748,6 +800,7 @@ __attribute__((noinline)) static MainFunc prepare(APIs& state, const Header* dyl
             halt(depsDiag.errorMessage(), &state.structuredError);
         }
     }
+    pathProbeScope.end();
 
     uint64_t topCount = topLevelLoaders.count();
  
@@ -978,6 +1031,11 @@ __attribute__((noinline)) static MainFunc prepare(APIs& state, const Header* dyl
 #endif
     }
 
+    // the launch images are final, so from now on dladdr(), etc in initializers don't need the loaders lock
+    state.locks.withLoadersWriteLock(^{
+        state.publishLoadedSnapshot();
+    });
+
 #if !SUPPPORT_PRE_LC_MAIN
     // run all initializers
     state.externallyViewable->notifyMonitorOfDyldBeforeInitializers();
@@ -1002,6 +1060,10 @@ __attribute__((noinline)) static MainFunc prepare(APIs& state, const Header* dyl
         state.runAllInitializersForMain();
 #endif // !SUPPPORT_PRE_LC_MAIN
 
+#if !TARGET_OS_EXCLAVEKIT
+    finishAllocatorInstrumentation(state);
+#endif // !TARGET_OS_EXCLAVEKIT
+
     // notify we are about to call main
     state.externallyViewable->notifyMonitorOfMainCalled();
 
@@ -43,6 +43,7 @@
 #include "Introspection.h"
 #include "Header.h"
 #include "dyld_cache_format.h"
+#include "CompactLocalSymbols.h"
 
 #define NO_ULEB
 #include "FileAbstraction.hpp"
@@ -438,6 +439,22 @@ bool dyld_image_local_nlist_content_4Symbolication(dyld_image_t image,
         uint64_t textOffsetInCache = imageObjc.address - sharedCache.address;
         const dyld_cache_header* header = (const dyld_cache_header*)localSymbolData.bytes;
         const dyld_cache_local_symbols_info* localInfo = (dyld_cache_local_symbols_info*)((const uint8_t*)localSymbolData.bytes + header->localSymbolsOffset);
+        if ( const dyld_cache_local_symbols_compact_info* compactInfo = compact_local_symbols::compactInfo(localInfo) ) {
+            // The compact format is decoded in to a temporary nlist, for just this image
+            const dyld_cache_local_symbols_compact_entry* block = compact_local_symbols::findBlock(compactInfo, textOffsetInCache);
+            if ( block == nullptr )
+                return result;
+            if ( imageObjc.pointerSize == 8 ) {
+                return compact_local_symbols::withNLists<struct nlist_64>(compactInfo, *block, ^(const struct nlist_64* nlists, uint32_t nlistCount, const char* strings) {
+                    contentReader(nlists, nlistCount, strings);
+                });
+            } else if ( imageObjc.pointerSize == 4 ) {
+                return compact_local_symbols::withNLists<struct nlist>(compactInfo, *block, ^(const struct nlist* nlists, uint32_t nlistCount, const char* strings) {
+                    contentReader(nlists, nlistCount, strings);
+                });
+            }
+            return false;
+        }
         forEachLocalSymbolEntry(localInfo, ^(uint64_t dylibCacheVMOffset, uint32_t nlistStartIndex, uint32_t nlistCount, bool& stop){
             if ( dylibCacheVMOffset == textOffsetInCache ) {
                 if ( imageObjc.pointerSize == 8 ) {
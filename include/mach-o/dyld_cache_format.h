@@ -113,6 +113,8 @@ struct dyld_cache_header
     uint64_t    functionVariantInfoSize;// Size of all of the variant information pointed to via the dyld_cache_function_variant_info
     uint64_t    prewarmingDataOffset;   // file offset to dyld_prewarming_header
     uint64_t    prewarmingDataSize;     // byte size of prewarming data
+    uint64_t    exportFiltersAddr;      // (unslid) address of dyld_cache_export_filters
+    uint64_t    exportFiltersSize;      // byte size of dyld_cache_export_filters, including the filter words
 };
 
 // Uncomment this and check the build errors for the current mapping offset to check against when adding new fields.
@@ -572,6 +574,40 @@ struct dyld_cache_local_symbols_entry_64
     uint32_t    nlistCount;         // number of local symbols for this dylib
 };
 
+// The compact local symbols format starts with a dyld_cache_local_symbols_info whose nlist, strings, and
+// entries counts are all zero, so that older tools see no locals instead of misreading the data.
+// Each dylib then gets its own block of encoded symbols, which can be decoded without touching other blocks.
+// Within a block, symbols are in address order, and each symbol is encoded as:
+//      sleb128     n_value delta from the previous symbol in the block (from 0 for the first)
+//      uint8       n_type
+//      uint8       n_sect
+//      uleb128     n_desc
+//      uleb128     length of the prefix shared with the previous symbol name
+//      uleb128     length of the rest of the name
+//      char[]      rest of the name (not null terminated)
+#define DYLD_CACHE_LOCAL_SYMBOLS_COMPACT_MAGIC      0x6c6f6373  // 'locs'
+#define DYLD_CACHE_LOCAL_SYMBOLS_COMPACT_VERSION    1
+
+struct dyld_cache_local_symbols_compact_info
+{
+    struct dyld_cache_local_symbols_info    legacy;         // entriesOffset is sizeof(dyld_cache_local_symbols_compact_info), all counts are zero
+    uint32_t                                magic;          // DYLD_CACHE_LOCAL_SYMBOLS_COMPACT_MAGIC
+    uint32_t                                version;        // DYLD_CACHE_LOCAL_SYMBOLS_COMPACT_VERSION
+    uint32_t                                blocksOffset;   // offset into this chunk of array of dyld_cache_local_symbols_compact_entry
+    uint32_t                                blocksCount;    // number of elements in dyld_cache_local_symbols_compact_entry array, sorted by dylibOffset
+    uint32_t                                maxNameLength;  // longest symbol name in any block, not including the null terminator
+    uint32_t                                reserved;
+};
+
+struct dyld_cache_local_symbols_compact_entry
+{
+    uint64_t    dylibOffset;        // offset in cache buffer of start of dylib
+    uint32_t    dataOffset;         // offset into this chunk of the encoded symbols for this dylib
+    uint32_t    dataSize;           // byte count of the encoded symbols for this dylib
+    uint32_t    symbolCount;        // number of local symbols for this dylib
+    uint32_t    maxNameLength;      // longest symbol name in this block, not including the null terminator
+};
+
 struct dyld_subcache_entry_v1
 {
     uint8_t     uuid[16];           // The UUID of the subCache file
@@ -625,6 +661,21 @@ struct dyld_prewarming_header
     struct dyld_prewarming_entry entries[0];
 };
 
+// Bloom filter of the names in one cache dylib's exports trie (see ExportBloomFilter.h)
+struct dyld_cache_export_filter_entry
+{
+    uint32_t    wordsOffset;        // offset from the start of dyld_cache_export_filters to the uint64_t words, or 0 for no filter
+    uint32_t    wordCount;          // number of uint64_t words, always a power of 2
+};
+
+struct dyld_cache_export_filters
+{
+    uint32_t                                version;    // == 1 for now
+    uint32_t                                count;      // number of entries, in the same order as dyld_cache_image_info
+    struct dyld_cache_export_filter_entry   entries[0];
+    // Followed by the filter words, 8-byte aligned
+};
+
 // This is the  location of the macOS shared cache on macOS 11.0 and later
 #define MACOSX_MRM_DYLD_SHARED_CACHE_DIR   "/System/Library/dyld/"
 
@@ -23,6 +23,8 @@
 
 #include <stdint.h>
 
+#include <algorithm>
+
 #include "Defines.h"
 #include "Header.h"
 #include "Error.h"
@@ -44,6 +46,9 @@ Error ThreadLocalVariables::setUpImage(const DyldSharedCache* cache, const Heade
 {
 // driverkit and main OS use same dyld, but driverkit process do not support thread locals
 #if __has_feature(tls)
+    // find the initial content once, rather than each time a thread first uses the TLVs
+    addImageContent(hdr);
+
     if ( hdr->inDyldCache() ) {
         if ( Error err = this->initializeThunksInDyldCache(cache, hdr) )
             return err;
@@ -52,6 +57,7 @@ Error ThreadLocalVariables::setUpImage(const DyldSharedCache* cache, const Heade
         if ( Error err = this->initializeThunksFromDisk(hdr) )
             return err;
     }
+
     return Error::none();
 #else
     return Error::none();
@@ -89,6 +95,48 @@ void ThreadLocalVariables::findInitialContent(const Header* hdr, std::span<const
 #endif
 }
 
+// Note: only called from setUpImage(), which dyld serializes with its loader lock
+const ThreadLocalVariables::ImageContent& ThreadLocalVariables::addImageContent(const Header* hdr)
+{
+    std::span<const uint8_t>  initialContent;
+    bool                      allZeroFill;
+    findInitialContent(hdr, initialContent, allZeroFill);
+    ImageContent newContent = { hdr, initialContent.data(), initialContent.size(), allZeroFill };
+
+    // an image may be set up again if it was unloaded and another image loaded at the same address
+    if ( const ImageContent* existing = findImageContent(hdr) ) {
+        ImageContent& entry = *(ImageContent*)existing;
+        entry = newContent;
+        return entry;
+    }
+
+    ImageContentChunk* chunk = _imageContents.load(std::memory_order_acquire);
+    if ( (chunk == nullptr) || (chunk->count.load(std::memory_order_relaxed) == std::size(chunk->entries)) ) {
+        // Note: use system malloc because it is thread safe and does not require dyld's allocator to be made r/w
+        ImageContentChunk* newChunk = (ImageContentChunk*)::malloc(sizeof(ImageContentChunk));
+        newChunk->next = chunk;
+        newChunk->count.store(0, std::memory_order_relaxed);
+        _imageContents.store(newChunk, std::memory_order_release);
+        chunk = newChunk;
+    }
+    uint32_t index = chunk->count.load(std::memory_order_relaxed);
+    chunk->entries[index] = newContent;
+    chunk->count.store(index + 1, std::memory_order_release);
+    return chunk->entries[index];
+}
+
+const ThreadLocalVariables::ImageContent* ThreadLocalVariables::findImageContent(const Header* hdr) const
+{
+    for ( const ImageContentChunk* chunk = _imageContents.load(std::memory_order_acquire); chunk != nullptr; chunk = chunk->next ) {
+        uint32_t count = chunk->count.load(std::memory_order_acquire);
+        for ( uint32_t i = 0; i != count; ++i ) {
+            if ( chunk->entries[i].hdr == hdr )
+                return &chunk->entries[i];
+        }
+    }
+    return nullptr;
+}
+
 // most images have just one __thread_vars section, but some have one in __DATA and one in __DATA_DIRTY
 Error ThreadLocalVariables::forEachThunkSpan(const Header* hdr, Error (^visit)(std::span<Thunk>))
 {
@@ -133,6 +181,9 @@ void ThreadLocalVariables::initialize()
     // assign pthread_key for per-thread terminators
     // Note: if a thread is terminated, the value for this key is cleaned up by calling finalizeList()
     dyld_thread_key_create(&_terminatorsKey, &finalizeListTLV);
+
+    // assign pthread_key for the per-thread slab that TLV blocks are carved from
+    dyld_thread_key_create(&_slabKey, &finalizeSlab);
 }
 
 Error ThreadLocalVariables::initializeThunksFromDisk(const Header* hdr)
@@ -142,14 +193,20 @@ Error ThreadLocalVariables::initializeThunksFromDisk(const Header* hdr)
 #if BUILDING_UNIT_TESTS
     key = _key;
 #else
-    if ( dyld_thread_key_create(&key, &::free) )
+    if ( dyld_thread_key_create(&key, &freeBlock) )
         return Error("pthread_key_create() failed");
 #endif
 
     // find initial content for all TLVs in image
     std::span<const uint8_t>  initialContent;
     bool                      allZeroFill;
-    findInitialContent(hdr, initialContent, allZeroFill);
+    if ( const ImageContent* imageContent = findImageContent(hdr) ) {
+        initialContent = std::span<const uint8_t>(imageContent->content, imageContent->size);
+        allZeroFill    = imageContent->allZeroFill;
+    }
+    else {
+        findInitialContent(hdr, initialContent, allZeroFill);
+    }
 
     // set the thunk function pointer and key for every thread local variable
     Error err = forEachThunkSpan(hdr, ^(std::span<Thunk> thunks) {
@@ -223,8 +280,8 @@ Error ThreadLocalVariables::initializeThunksInDyldCache(const DyldSharedCache* c
         }
         else {
             // dyld cache builder assigned a static key for these TLVs but we need to register
-            // that free() should be called on the key's value if the thread goes away
-            dyld_thread_key_init_np(staticKey, &::free);
+            // that the block should be freed if the thread goes away
+            dyld_thread_key_init_np(staticKey, &freeBlock);
         }
         // thunks in the dyld shared cache are normally correct, but we may need to be correct them if root of libdyld.dylib is in use
         void* getAddrFunc = (void*)&_tlv_get_addr;
@@ -250,24 +307,18 @@ void ThreadLocalVariables::addTermFunc(TermFunc func, void* objAddr)
 {
     // NOTE: this does not need locks because it only operates on current thread data
     TerminatorList* list = (TerminatorList*)::dyld_thread_getspecific(_terminatorsKey);
-    if ( list == nullptr ) {
+    if ( (list == nullptr) || (list->count == list->capacity) ) {
+        // if there is no list, or the newest is full, add a bigger one in front of it
+        uint32_t capacity = (list == nullptr) ? kFirstTerminatorCapacity : std::min(list->capacity * 2, kMaxTerminatorCapacity);
         // Note: use system malloc because it is thread safe and does not require dyld's allocator to be made r/w
-        list = (TerminatorList*)::malloc(sizeof(TerminatorList));
-        bzero(list, sizeof(TerminatorList));
-        dyld_thread_setspecific(_terminatorsKey, list);
-    }
-    // go to end of chain
-    while (list->next != nullptr)
-        list = list->next;
-    // make sure there is space to add another element
-    if ( list->count == 7 ) {
-        // if list is full, add a chain
-        TerminatorList* nextList = (TerminatorList*)::malloc(sizeof(TerminatorList));
-        bzero(nextList, sizeof(TerminatorList));
-        list->next = nextList;
-        list = nextList;
+        TerminatorList* newList = (TerminatorList*)::malloc(sizeof(TerminatorList) + capacity * sizeof(Terminator));
+        newList->older    = list;
+        newList->count    = 0;
+        newList->capacity = capacity;
+        dyld_thread_setspecific(_terminatorsKey, newList);
+        list = newList;
     }
-    list->elements[list->count++] = { func, objAddr };
+    list->elements()[list->count++] = { func, objAddr };
 }
 
 // <rdar://problem/13741816>
@@ -288,22 +339,15 @@ void ThreadLocalVariables::exit()
     }
 }
 
-void ThreadLocalVariables::TerminatorList::reverseWalkChain(void (^visit)(TerminatorList*))
-{
-    if ( this->next != nullptr )
-        this->next->reverseWalkChain(visit);
-    visit(this);
-}
-
 // on entry, libc has set the TSD slot to nullptr and passed us the previous value
 // this is done to handle destructors that re-animate the key value
 void ThreadLocalVariables::finalizeList(void* l)
 {
+    // call term functions in reverse order of construction, which is newest list first
     TerminatorList* list = (TerminatorList*)l;
-    // call term functions in reverse order of construction
-    list->reverseWalkChain(^(TerminatorList* chain) {
-        for ( uintptr_t i = chain->count; i > 0; --i ) {
-            const Terminator& entry = chain->elements[i - 1];
+    while ( list != nullptr ) {
+        for ( uint32_t i = list->count; i > 0; --i ) {
+            const Terminator& entry = list->elements()[i - 1];
             if ( entry.termFunc != nullptr )
                 (*entry.termFunc)(entry.objAddr);
 
@@ -315,12 +359,67 @@ void ThreadLocalVariables::finalizeList(void* l)
                 this->finalizeList(newlist);
             }
         }
-    });
+        // nothing else refers to this list once its terminators have run
+        TerminatorList* older = list->older;
+        ::free(list);
+        list = older;
+    }
+}
 
-    // free entire chain
-    list->reverseWalkChain(^(TerminatorList* chain) {
-        ::free(chain);
-    });
+// carves a block for one image's thread-locals out of the current thread's slab.  If initialContent is null, the block is zero filled
+void* ThreadLocalVariables::allocateBlock(size_t size, const uint8_t* initialContent)
+{
+    const size_t blockSize = slabBlockSize(size);
+    SlabChunk*   chunk     = (SlabChunk*)::dyld_thread_getspecific(_slabKey);
+    if ( (chunk == nullptr) || ((chunk->size - chunk->used) < blockSize) ) {
+        // start small, so a thread using a few thread-locals doesn't pay for every image's, then double each new slab
+        size_t chunkSize = (chunk == nullptr) ? kMinSlabSize : std::min((size_t)chunk->size * 2, (size_t)kMaxSlabSize);
+        chunkSize = std::max(chunkSize, blockSize);
+        if ( chunkSize > 0xFFFFFFFFUL )
+            return nullptr;
+        // Note: use system calloc because it is thread safe and does not require dyld's allocator to be made r/w
+        SlabChunk* newChunk = (SlabChunk*)::calloc(sizeof(SlabChunk) + chunkSize, 1);
+        if ( newChunk == nullptr )
+            return nullptr;
+        newChunk->size     = (uint32_t)chunkSize;
+        newChunk->used     = 0;
+        newChunk->refCount = 1;
+        dyld_thread_setspecific(_slabKey, newChunk);
+        // the old slab is freed once all the blocks in it are
+        if ( chunk != nullptr )
+            releaseSlabChunk(chunk);
+        chunk = newChunk;
+    }
+    SlabBlockHeader* header = (SlabBlockHeader*)((uint8_t*)(chunk + 1) + chunk->used);
+    header->chunk = chunk;
+    chunk->used  += (uint32_t)blockSize;
+    chunk->refCount += 1;
+
+    // the slab is calloc()ed so zero fill blocks need no more work
+    void* block = header + 1;
+    if ( initialContent != nullptr )
+        memcpy(block, initialContent, size);
+    return block;
+}
+
+void ThreadLocalVariables::releaseSlabChunk(SlabChunk* chunk)
+{
+    // slabs are only used by one thread, so this does not need to be atomic
+    if ( --chunk->refCount == 0 )
+        ::free(chunk);
+}
+
+// destructor for each image's key, called when a thread goes away
+void ThreadLocalVariables::freeBlock(void* block)
+{
+    SlabBlockHeader* header = (SlabBlockHeader*)block - 1;
+    releaseSlabChunk(header->chunk);
+}
+
+// destructor for the slab key, called when a thread goes away
+void ThreadLocalVariables::finalizeSlab(void* chunk)
+{
+    releaseSlabChunk((SlabChunk*)chunk);
 }
 
 // called lazily when TLV is first accessed
@@ -334,6 +433,11 @@ void* ThreadLocalVariables::instantiateVariable(const Thunk& thunk)
         return result;
 #endif // TARGET_OS_EXCLAVEKIT
 
+#if BUILDING_UNIT_TESTS
+    ThreadLocalVariables& tlvs = *this;
+#else
+    ThreadLocalVariables& tlvs = sThreadLocalVariables;
+#endif
     void*               buffer = nullptr;
     dyld_thread_key_t   key    = 0;
 #if __LP64__
@@ -341,14 +445,13 @@ void* ThreadLocalVariables::instantiateVariable(const Thunk& thunk)
     key    = thunkv2->key;
     if ( thunkv2->initialContentDelta != 0 ) {
         // initial content of thread-locals is non-zero so copy initial bytes from template
-        buffer = ::malloc(thunkv2->initialContentSize);
         const uint8_t* initialContent = (uint8_t*)(&thunkv2->initialContentDelta) + thunkv2->initialContentDelta;
-        memcpy(buffer, initialContent, thunkv2->initialContentSize);
+        buffer = tlvs.allocateBlock(thunkv2->initialContentSize, initialContent);
         if (verbose) fprintf(stderr, "instantiateVariable(%p) buffer=%p, init-content=%p size=%d\n", &thunk, buffer, initialContent, thunkv2->initialContentSize);
     }
     else {
         // initial content of thread-locals is all zeros
-        buffer = ::calloc(thunkv2->initialContentSize, 1);
+        buffer = tlvs.allocateBlock(thunkv2->initialContentSize, nullptr);
         if (verbose) fprintf(stderr, "instantiateVariable(%p) buffer=%p, zero-fill, size=%d\n", &thunk, buffer, thunkv2->initialContentSize);
     }
 #else
@@ -360,13 +463,15 @@ void* ThreadLocalVariables::instantiateVariable(const Thunk& thunk)
         if ( const Header* hdr = Header::isMachO(bytes) ) {
             std::span<const uint8_t>  initialContent;
             bool                      allZeroFill;
-            findInitialContent(hdr, initialContent, allZeroFill);
+            if ( const ImageContent* imageContent = tlvs.findImageContent(hdr) )
+                initialContent = std::span<const uint8_t>(imageContent->content, imageContent->size);
+            else
+                tlvs.findInitialContent(hdr, initialContent, allZeroFill);
             if ( initialContent.empty() ) {
                 fprintf(stderr, "ThreadLocalVariables::getInitialContent(%p) failed\n", hdr);
                 return nullptr;  // abort? something has gone wrong
             }
-            buffer = ::malloc(initialContent.size());
-            memcpy(buffer, initialContent.data(), initialContent.size());
+            buffer = tlvs.allocateBlock(initialContent.size(), initialContent.data());
             if (verbose) fprintf(stderr, "instantiateVariable(%p) buffer=%p, init-content=%p size=%lu\n", thunkv2, buffer, initialContent.data(), initialContent.size());
         }
         else {
@@ -376,7 +481,7 @@ void* ThreadLocalVariables::instantiateVariable(const Thunk& thunk)
     }
     else {
         // in zerofill case, machHeaderDelta is size to allocate
-        buffer = ::calloc(thunkv2->machHeaderDelta, 1);
+        buffer = tlvs.allocateBlock(thunkv2->machHeaderDelta, nullptr);
         key    = thunkv2->key;
         if (verbose) fprintf(stderr, "instantiateVariable(%p) buffer=%p, zero-fill, size=%d\n", thunkv2, buffer, thunkv2->machHeaderDelta);
     }
@@ -399,6 +504,8 @@ void ThreadLocalVariables::setMock(int tlvKey, std::span<Thunk> thunks, std::spa
 {
     _key                = tlvKey;
     _thunks             = thunks;
+    if ( _slabKey == 0 )
+        dyld_thread_key_create(&_slabKey, &finalizeSlab);
     _initialContent     = content;
     _allZeroFillContent = true;
     for (uint8_t byte : content) {
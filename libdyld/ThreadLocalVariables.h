@@ -27,6 +27,8 @@
 
 #include <stdint.h>
 
+#include <atomic>
+
 #include "Defines.h"
 #include "Error.h"
 #include "Header.h"
@@ -87,6 +89,12 @@ using mach_o::Header;
     It turns out the slow path (first use of a TLV) required taking a lock and walking dyld data
     structures to find the image containing the TLV and the initial content for it.
 
+    Rather than malloc() one block per image per thread, the blocks are carved out of a per-thread
+    slab.  The first slab is small, and each new slab is twice the size of the last, up to 64KB.  So a
+    thread which uses the TLVs of many images only does a few calloc()s.  Each block is preceded by
+    a pointer to its slab, and the slab is reference counted by its blocks, so that the per-image
+    key destructors and the slab key destructor can run in any order when the thread goes away.
+
     In Spring 2025 releases, an optimization was made to how TLVs work to optimize the slow path.
     The code below implements this optimization which repacks the fields in the thunk after the
     func pointer to contain all the info needed for the fast and slow paths.  That means dyld
@@ -173,6 +181,50 @@ private:
 #endif
     mach_o::Error                   forEachThunkSpan(const Header* hdr, mach_o::Error (^visit)(std::span<Thunk>));
 
+    // initial content of an image's TLVs, found once when the image is set up
+    struct ImageContent
+    {
+        const Header*   hdr;
+        const uint8_t*  content;
+        size_t          size;
+        bool            allZeroFill;
+    };
+
+    // ImageContents are only added while dyld holds its loader lock, but can be read by any thread, so they are
+    // kept in chunks which are never moved or freed, and each entry is published by bumping the chunk's count
+    struct ImageContentChunk
+    {
+        ImageContentChunk*      next;
+        std::atomic<uint32_t>   count;
+        ImageContent            entries[31];
+    };
+
+    const ImageContent&             addImageContent(const Header* hdr);
+    const ImageContent*             findImageContent(const Header* hdr) const;
+
+    // per-thread storage that the TLV blocks of all images are carved from
+    struct alignas(16) SlabChunk
+    {
+        uint32_t      size;         // bytes available after this header
+        uint32_t      used;
+        uintptr_t     refCount;     // one per block carved from it, plus one while it is the thread's current slab
+    };
+
+    // precedes every TLV block, so that the block's key destructor can find the slab
+    struct alignas(16) SlabBlockHeader
+    {
+        SlabChunk*    chunk;
+    };
+
+    static constexpr uint32_t kMinSlabSize  = 256;
+    static constexpr uint32_t kMaxSlabSize  = 64*1024;
+
+    void*                           allocateBlock(size_t size, const uint8_t* initialContent);
+    static void                     releaseSlabChunk(SlabChunk* chunk);
+    static void                     freeBlock(void* block);
+    static void                     finalizeSlab(void* chunk);
+    static size_t                   slabBlockSize(size_t contentSize) { return sizeof(SlabBlockHeader) + ((contentSize + 15) & ~(size_t)15); }
+
     // used to record _tlv_atexit() entries to clean up on thread exit
     struct Terminator
     {
@@ -180,16 +232,24 @@ private:
         void*         objAddr;
     };
 
+    // Terminators are kept in per-thread arrays, which double in size as needed.  The thread's key holds the
+    // newest array, which links to the older ones, so adding is constant time and exit walks each array backwards
     struct TerminatorList {
-        TerminatorList* next  = nullptr;
-        uintptr_t       count = 0;
-        Terminator      elements[7];
-        void                reverseWalkChain(void (^work)(TerminatorList*));
+        TerminatorList* older;
+        uint32_t        count;
+        uint32_t        capacity;
+
+        Terminator*         elements() { return (Terminator*)(this + 1); }
     };
 
+    static constexpr uint32_t kFirstTerminatorCapacity = 8;
+    static constexpr uint32_t kMaxTerminatorCapacity   = 1024;
+
     static const bool verbose = false;
 
     dyld_thread_key_t               _terminatorsKey      = 0;
+    dyld_thread_key_t               _slabKey             = 0;
+    std::atomic<ImageContentChunk*> _imageContents       = nullptr;
 #if BUILDING_UNIT_TESTS
     dyld_thread_key_t               _key;
     std::span<Thunk>                _thunks;
@@ -28,6 +28,7 @@
 
 #include "dyld_introspection.h"
 #include "dyld_cache_format.h"
+#include "CompactLocalSymbols.h"
 #include "ProcessAtlas.h"
 #include "MachOLoaded.h"
 #include "DyldProcessConfig.h"
@@ -502,6 +503,22 @@ bool dyld_image_local_nlist_content_4Symbolication(dyld_image_t image,
         uint64_t textOffsetInCache = atlasImage->sharedCacheVMOffset();
 
         const dyld_cache_local_symbols_info* localInfo = localsFileData->localInfo();
+        if ( const dyld_cache_local_symbols_compact_info* compactInfo = compact_local_symbols::compactInfo(localInfo) ) {
+            // The compact format is decoded in to a temporary nlist, for just this image
+            const dyld_cache_local_symbols_compact_entry* block = compact_local_symbols::findBlock(compactInfo, textOffsetInCache);
+            if ( block == nullptr )
+                return result;
+            if ( atlasImage->pointerSize() == 8 ) {
+                return compact_local_symbols::withNLists<struct nlist_64>(compactInfo, *block, ^(const struct nlist_64* nlists, uint32_t nlistCount, const char* strings) {
+                    contentReader(nlists, nlistCount, strings);
+                });
+            } else if ( atlasImage->pointerSize() == 4 ) {
+                return compact_local_symbols::withNLists<struct nlist>(compactInfo, *block, ^(const struct nlist* nlists, uint32_t nlistCount, const char* strings) {
+                    contentReader(nlists, nlistCount, strings);
+                });
+            }
+            return false;
+        }
         forEachLocalSymbolEntry(localInfo, localsFileData->use64BitDylibOffsets(),
                                 ^(uint64_t dylibCacheVMOffset, uint32_t nlistStartIndex, uint32_t nlistCount, bool& stop){
             if ( dylibCacheVMOffset == textOffsetInCache ) {
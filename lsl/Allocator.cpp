@@ -25,6 +25,7 @@
 #include <string.h>
 #include <cstdio>
 #include <algorithm>
+#include <bit>
 #include <compare>
 #include <TargetConditionals.h>
 #include "Defines.h"
@@ -42,6 +43,7 @@
 #include <sanitizer/asan_interface.h>
 
 #include "Allocator.h"
+#include "AllocatorTrace.h"
 #include "BTree.h"
 #include "BitUtils.h"
 #include "StringUtils.h"
@@ -481,6 +483,8 @@ Allocator& Allocator::operator=(Allocator&& other) {
     _firstPool      =   other._firstPool;
     _currentPool    =   other._currentPool;
     _allocatedBytes =   other._allocatedBytes;
+    _statistics     =   other._statistics;
+    _traceRecorder  =   other._traceRecorder;
 
     return *this;
 }
@@ -507,6 +511,62 @@ uint64_t Allocator::allocated_bytes() const {
     return _allocatedBytes;
 }
 
+uint32_t Allocator::Statistics::sizeClass(uint64_t size) {
+    if (size <= kGranuleSize) { return 0; }
+    const uint32_t result = std::bit_width(size - 1) - std::bit_width(kGranuleSize - 1);
+    return std::min(result, kSizeClassCount - 1);
+}
+
+uint64_t Allocator::Statistics::sizeClassLimit(uint32_t sizeClass) {
+    if (sizeClass == kSizeClassCount - 1) { return ~0ULL; }
+    return kGranuleSize << sizeClass;
+}
+
+uint64_t Allocator::PoolUsage::fragmentationPercent() const {
+    if (freeBytes == 0) { return 0; }
+    return (holeBytes * 100) / freeBytes;
+}
+
+void Allocator::setStatistics(Statistics* statistics) {
+    _statistics = statistics;
+    if (!_statistics) { return; }
+    // Count the blocks allocated before now as live, so that freeing them later balances out
+    _statistics->peakAllocatedBytes = std::max(_statistics->peakAllocatedBytes, _allocatedBytes);
+    forEachPool(^(const Pool& pool) {
+        pool.forEachAllocation(^(void* ptr, uint64_t size) {
+            auto& sizeClass = _statistics->sizeClasses[Statistics::sizeClass(size)];
+            sizeClass.peakLiveCount = std::max(sizeClass.peakLiveCount, ++sizeClass.liveCount);
+        });
+    });
+}
+
+const Allocator::Statistics* Allocator::statistics() const {
+    return _statistics;
+}
+
+Allocator::PoolUsage Allocator::poolUsage() const {
+    PoolUsage result;
+    for (auto pool = _currentPool; pool != nullptr; pool = pool->prevPool()) {
+        pool->addUsage(result);
+    }
+    return result;
+}
+
+void Allocator::setTraceRecorder(AllocatorTraceRecorder* recorder) {
+    _traceRecorder = recorder;
+    if (!_traceRecorder) { return; }
+    // Start the trace with the blocks allocated before now, so their frees and reallocs can be matched up
+    forEachPool(^(const Pool& pool) {
+        pool.forEachAllocation(^(void* ptr, uint64_t size) {
+            _traceRecorder->recordAlloc(ptr, kGranuleSize, size);
+        });
+    });
+}
+
+AllocatorTraceRecorder* Allocator::traceRecorder() const {
+    return _traceRecorder;
+}
+
 Allocator::Allocator(MemoryManager& memoryManager, Pool& pool) :
     _firstPool(&pool), _currentPool(&pool), _allocatedBytes(0) {}
 
@@ -594,6 +654,16 @@ void* Allocator::aligned_alloc(uint64_t alignment, uint64_t size) {
     }
     assert(result);
     _allocatedBytes += targetSize;
+    if (_statistics) {
+        auto& sizeClass = _statistics->sizeClasses[Statistics::sizeClass(AllocationMetadata::forPtr(result)->size())];
+        ++_statistics->allocations;
+        ++sizeClass.allocations;
+        sizeClass.peakLiveCount = std::max(sizeClass.peakLiveCount, ++sizeClass.liveCount);
+        _statistics->peakAllocatedBytes = std::max(_statistics->peakAllocatedBytes, _allocatedBytes);
+    }
+    if (_traceRecorder) {
+        _traceRecorder->recordAlloc(result, targetAlignment, targetSize);
+    }
     ALLOCATOR_LOG("ALLOCATOR(0x%llx/%llu)\taligned_alloc: (%llu %% %llu) -> 0x%llx\n",
                   (uint64_t)this, _logID++, targetSize, targetAlignment, (uint64_t)result);
     ALLOCATOR_TRACE("void* alloc%llu = allocator.aligned_alloc(%llu, %llu);\n", (uint64_t)result, targetAlignment, targetSize);
@@ -622,6 +692,13 @@ void Allocator::free(void* ptr) {
     ALLOCATOR_TRACE("allocator.free(alloc%llu);\n", (uint64_t)ptr);
     AllocationMetadata* metadata = AllocationMetadata::forPtr(ptr);
     _allocatedBytes -= metadata->size();
+    if (_statistics) {
+        ++_statistics->frees;
+        --_statistics->sizeClasses[Statistics::sizeClass(metadata->size())].liveCount;
+    }
+    if (_traceRecorder) {
+        _traceRecorder->recordFree(ptr);
+    }
     metadata->deallocate();
     validate();
 #endif /* !DYLD_FEATURE_USE_INTERNAL_ALLOCATOR */
@@ -644,6 +721,21 @@ bool Allocator::realloc(void* ptr, uint64_t size) {
     if (result) {
         _allocatedBytes += (targetSize - currentSize);
     }
+    if (_statistics) {
+        ++_statistics->reallocs;
+        if (result) {
+            // The allocation may have moved to a different size class
+            --_statistics->sizeClasses[Statistics::sizeClass(currentSize)].liveCount;
+            auto& sizeClass = _statistics->sizeClasses[Statistics::sizeClass(metadata->size())];
+            sizeClass.peakLiveCount = std::max(sizeClass.peakLiveCount, ++sizeClass.liveCount);
+            _statistics->peakAllocatedBytes = std::max(_statistics->peakAllocatedBytes, _allocatedBytes);
+        } else {
+            ++_statistics->failedReallocs;
+        }
+    }
+    if (_traceRecorder) {
+        _traceRecorder->recordRealloc(ptr, targetSize, result);
+    }
     ALLOCATOR_LOG("ALLOCATOR(0x%llx/%llu)\trealloc:       (0x%llx):  %llu -> %s)\n",
                   (uint64_t)this, _logID++, (uint64_t)ptr, targetSize, result ? "true" : "false");
     ALLOCATOR_TRACE("allocator.realloc(alloc%llu, %llu);\n", (uint64_t)ptr, targetSize);
@@ -718,7 +810,10 @@ void* Allocator::Pool::aligned_alloc(uint64_t alignment, uint64_t size) {
     // We need to reserve some space to align the buffer,
     if (_lastFreeMetadata->firstAddress() != freeBuffer.address) {
         uint16_t alignmentSize = (uint64_t)freeBuffer.address - (uint64_t)_lastFreeMetadata->firstAddress() - kGranuleSize;
+        AllocationMetadata* alignmentMetadata = _lastFreeMetadata;
         _lastFreeMetadata->reserve(alignmentSize, false);
+        // The alignment padding is no longer the last block, so it can be reused by the best fit path
+        addToFreeBin(alignmentMetadata);
          _lastFreeMetadata->logAddressSpace("aligned_alloc");
     }
 
@@ -750,7 +845,7 @@ void* Allocator::Pool::aligned_alloc(uint64_t alignment, uint64_t size) {
 // An alternate aligned_alloc implementation for use in persistent pools where memory density matters
 // The goal is for this algorithm to be very simple and reuse other parts of the allocator. As such it works like this:
 // 1. It only workse with 16 byte aligned granules, anything that requires greater alignment goes to the normal path
-// 2. It finds a slice of metadata which can hold the allocation, with as little extras space as possible
+// 2. It finds a free block which can hold the allocation, with as little extras space as possible, using the free bins
 // 3. It marks the whole allocation as allocated
 // 4. It reuses the code from realloc() (returnToNext()) to return the excess capacity back to the pool
 void* Allocator::Pool::aligned_alloc_best_fit(uint64_t alignment, uint64_t size) {
@@ -759,27 +854,14 @@ void* Allocator::Pool::aligned_alloc_best_fit(uint64_t alignment, uint64_t size)
     if (alignment != kGranuleSize) {
         return aligned_alloc(alignment, size);
     }
-    AllocationMetadata* candidateMetadata = nullptr;
-    uint64_t candidateMetadataWastedBytes = ~0ULL;
-    for (auto metadata = _lastFreeMetadata->previous(); metadata != nullptr; metadata = metadata->previous()) {
-        if (metadata->allocated()) { continue; }
-        if (metadata->size() < size) { continue; }
-        uint64_t waste = metadata->size() - size;
-        if (waste == 0) {
-            candidateMetadata = metadata;
-            break;
-        } else if (waste < candidateMetadataWastedBytes) {
-            candidateMetadata = metadata;
-            candidateMetadataWastedBytes = waste;
-        }
-    }
-
+    AllocationMetadata* candidateMetadata = findFreeBinFit(size);
     if (!candidateMetadata) {
-        // We do not check the last metadata, which is what the sdefault allocation policy uses, so call that
+        // The bins do not hold the last metadata, which is what the sdefault allocation policy uses, so call that
         return aligned_alloc(alignment,  size);
     }
 
     void* result = candidateMetadata->firstAddress();
+    removeFromFreeBin(candidateMetadata);
     candidateMetadata->markAllocated();
     candidateMetadata->validate();
     if (candidateMetadata->size() > size) {
@@ -796,6 +878,77 @@ void* Allocator::Pool::aligned_alloc_best_fit(uint64_t alignment, uint64_t size)
     return result;
 }
 
+uint32_t Allocator::Pool::freeBinIndex(uint64_t size) {
+    if (size <= kMaxExactBinSize) {
+        return (uint32_t)(size / kGranuleSize) - (uint32_t)(AllocationMetadata::kMinBinnedSize / kGranuleSize);
+    }
+    // The first shared bin holds sizes in (kMaxExactBinSize, 2*kMaxExactBinSize)
+    const uint32_t firstSharedBin   = freeBinIndex(kMaxExactBinSize) + 1;
+    const uint32_t log2Size         = 63 - std::countl_zero(size);
+    const uint32_t log2MaxExactSize = 63 - std::countl_zero(kMaxExactBinSize);
+    return std::min(firstSharedBin + (log2Size - log2MaxExactSize), kFreeBinCount - 1);
+}
+
+void Allocator::Pool::addToFreeBin(AllocationMetadata* metadata) {
+    if (!metadata->binnable()) { return; }
+    const uint32_t binIndex = freeBinIndex(metadata->size());
+    AllocationMetadata::FreeLinks* links = metadata->freeLinks();
+    links->prev = nullptr;
+    links->next = _freeBins[binIndex];
+    if (links->next) {
+        links->next->freeLinks()->prev = metadata;
+    }
+    _freeBins[binIndex] = metadata;
+    _freeBinMap |= (1ULL << binIndex);
+}
+
+void Allocator::Pool::removeFromFreeBin(AllocationMetadata* metadata) {
+    if (!metadata->binnable()) { return; }
+    const uint32_t binIndex = freeBinIndex(metadata->size());
+    AllocationMetadata::FreeLinks* links = metadata->freeLinks();
+    if (links->prev) {
+        links->prev->freeLinks()->next = links->next;
+    } else {
+        assert(_freeBins[binIndex] == metadata);
+        _freeBins[binIndex] = links->next;
+        if (!links->next) {
+            _freeBinMap &= ~(1ULL << binIndex);
+        }
+    }
+    if (links->next) {
+        links->next->freeLinks()->prev = links->prev;
+    }
+}
+
+Allocator::AllocationMetadata* Allocator::Pool::findFreeBinFit(uint64_t size) const {
+    // Blocks too small to be binned are only reused once they coalesce in to bigger blocks
+    size = std::max<uint64_t>(roundToNextAligned<kGranuleSize>(size), AllocationMetadata::kMinBinnedSize);
+    const uint32_t lastExactBin = freeBinIndex(kMaxExactBinSize);
+    uint64_t binMap = _freeBinMap & (~0ULL << freeBinIndex(size));
+    while (binMap != 0) {
+        const uint32_t binIndex = std::countr_zero(binMap);
+        binMap &= binMap - 1;
+        // Every block in an exact bin is the same size, so the first one is as good as any
+        if (binIndex <= lastExactBin) {
+            return _freeBins[binIndex];
+        }
+        // Shared bins hold a range of sizes, so look at the first few blocks for the best fit
+        AllocationMetadata* candidateMetadata = nullptr;
+        uint32_t scanned = 0;
+        for (auto metadata = _freeBins[binIndex]; metadata && (scanned < kMaxBinScan); metadata = metadata->freeLinks()->next, ++scanned) {
+            if (metadata->size() < size) { continue; }
+            if (!candidateMetadata || (metadata->size() < candidateMetadata->size())) {
+                candidateMetadata = metadata;
+                if (metadata->size() == size) { break; }
+            }
+        }
+        if (candidateMetadata) {
+            return candidateMetadata;
+        }
+    }
+    return nullptr;
+}
+
 void Allocator::Pool::free(void* ptr) {
     AllocationMetadata* metadata = AllocationMetadata::forPtr(ptr);
     metadata->deallocate();
@@ -855,9 +1008,40 @@ void Allocator::Pool::validate() const {
         }
         metadata->validate();
     }
+    // Every block on a free bin must be free, not the last block, and in the right bin
+    for (uint32_t binIndex = 0; binIndex < kFreeBinCount; ++binIndex) {
+        assert(((_freeBinMap >> binIndex) & 1) == (_freeBins[binIndex] != nullptr));
+        for (auto metadata = _freeBins[binIndex]; metadata != nullptr; metadata = metadata->freeLinks()->next) {
+            assert(metadata->binnable());
+            assert(freeBinIndex(metadata->size()) == binIndex);
+        }
+    }
 #endif
 }
 
+void Allocator::Pool::addUsage(PoolUsage& usage) const {
+    usage.poolCount += 1;
+    usage.poolBytes += _poolBuffer.size;
+    // The last block is the unused space at the end of the pool, everything else free is a hole
+    if (_lastFreeMetadata->free()) {
+        usage.freeBytes += _lastFreeMetadata->size();
+    }
+    for (auto metadata = _lastFreeMetadata->previous(); metadata != nullptr; metadata = metadata->previous()) {
+        if (metadata->allocated()) { continue; }
+        usage.freeBytes     += metadata->size();
+        usage.holeBytes     += metadata->size();
+        usage.holeCount     += 1;
+        usage.largestHole   = std::max(usage.largestHole, metadata->size());
+    }
+}
+
+void Allocator::Pool::forEachAllocation(void (^callback)(void* ptr, uint64_t size)) const {
+    for (auto metadata = _lastFreeMetadata; metadata != nullptr; metadata = metadata->previous()) {
+        if (!metadata->allocated()) { continue; }
+        callback(metadata->firstAddress(), metadata->size());
+    }
+}
+
 void Allocator::Pool::dump() const {
     // Find the first free block. This is expensive, but only used in the debug path
     auto metadata = _lastFreeMetadata;
@@ -991,6 +1175,7 @@ Allocator::Pool* Allocator::AllocationMetadata::pool(bool useHints) const {
 void Allocator::AllocationMetadata::coalesce(Pool* pool) {
     AllocationMetadata* currentMetadata = this;
     if (next() && next()->free()) {
+        pool->removeFromFreeBin(next());
         _next = next()->_next;
         // We only need to (and only can) update the previous entry in the next metadata if this is not the last free block. If it
         // is the last free block then trying to read the metadata past it will fault
@@ -1000,6 +1185,7 @@ void Allocator::AllocationMetadata::coalesce(Pool* pool) {
     }
     // Next try to consolidate with the block immediately before this one if it is exists
     if (previous() && previous()->free()) {
+        pool->removeFromFreeBin(previous());
         previous()->_next = _next;
         currentMetadata = previous();
         // We only need to (and only can) update the previous entry in the next metadata if this is not the last free block. If it
@@ -1009,6 +1195,7 @@ void Allocator::AllocationMetadata::coalesce(Pool* pool) {
         }
     }
     currentMetadata->setPoolHint(pool);
+    pool->addToFreeBin(currentMetadata);
 
     // Finally update the free region if this was the last entry in the pool to reflect the new free memory available
     if (currentMetadata->last()) {
@@ -1057,12 +1244,16 @@ bool Allocator::AllocationMetadata::consumeFromNext(uint64_t size) {
         // If the size we need is less than the size of the next block we can realloc() by moving the next metadata within the
         // the block.
         void* nextAddr = (void*)((uint64_t)this+sizeof(AllocationMetadata)+size);
+        Pool* pool = next()->pool();
+        pool->removeFromFreeBin(next());
 
         new (nextAddr) AllocationMetadata(this, nextSize-requiredSize, next()->_next & ~kNextBlockAddressMask, _next & ~kNextBlockAddressMask);
+        pool->addToFreeBin(next());
         return true;
     } else if (!next()->last() && (requiredSize == nextSize + sizeof(AllocationMetadata))) {
         // if we are not reallocating into the last entry we can get an extra sizeof(AllocationMetadata) by deleting the block
         // entirely and using the space from its metadata tag
+        next()->pool()->removeFromFreeBin(next());
         _next = next()->_next | kNextBlockAllocatedFlag;
         next()->_prev = (uint64_t)this;
         return true;
@@ -1072,6 +1263,15 @@ bool Allocator::AllocationMetadata::consumeFromNext(uint64_t size) {
     return false;
 }
 
+bool Allocator::AllocationMetadata::binnable() const {
+    return free() && !last() && (size() >= kMinBinnedSize);
+}
+
+Allocator::AllocationMetadata::FreeLinks* Allocator::AllocationMetadata::freeLinks() const {
+    // The pool hint is at the start of the free block, so the links go after it
+    return (FreeLinks*)((uint64_t)firstAddress() + sizeof(Pool*));
+}
+
 Allocator::AllocationMetadata* Allocator::AllocationMetadata::forPtr(void* ptr) {
     AllocationMetadata* castPtr = static_cast<AllocationMetadata*>(ptr);
     return castPtr-1;
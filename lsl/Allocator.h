@@ -597,6 +597,8 @@ struct VIS_HIDDEN UniquePtr;
 template<typename T>
 struct VIS_HIDDEN SharedPtr;
 
+struct AllocatorTraceRecorder;
+
 
 
 struct __attribute__((aligned(16))) VIS_HIDDEN Allocator {
@@ -646,6 +648,45 @@ struct __attribute__((aligned(16))) VIS_HIDDEN Allocator {
     Allocator& operator=(Allocator&& other);
 
     uint64_t      allocated_bytes() const;
+
+    // Opt-in counters for sizing pools. The caller owns the storage, and nothing is counted until setStatistics() is called,
+    // other than the blocks which are already allocated then, which start out as live
+    struct Statistics {
+        // Size classes are powers of 2 starting at kGranuleSize, the last class also holds everything bigger
+        static const uint32_t kSizeClassCount = 14;
+        struct SizeClass {
+            uint64_t    allocations;
+            uint64_t    liveCount;
+            uint64_t    peakLiveCount;
+        };
+        SizeClass   sizeClasses[kSizeClassCount]    = {};
+        uint64_t    allocations                     = 0;
+        uint64_t    frees                           = 0;
+        uint64_t    reallocs                        = 0;
+        uint64_t    failedReallocs                  = 0;
+        uint64_t    peakAllocatedBytes              = 0;
+
+        static uint32_t sizeClass(uint64_t size);
+        static uint64_t sizeClassLimit(uint32_t sizeClass);
+    };
+    // Filled in by walking the pools, as it is too expensive to track on every call
+    struct PoolUsage {
+        uint64_t    poolCount       = 0;
+        uint64_t    poolBytes       = 0;
+        uint64_t    freeBytes       = 0;    // Includes the unused space at the end of each pool
+        uint64_t    holeBytes       = 0;    // Free space between allocations, which can only be reused by allocations that fit
+        uint64_t    holeCount       = 0;
+        uint64_t    largestHole     = 0;
+        // The percentage of free space which is in holes rather than at the end of a pool
+        uint64_t    fragmentationPercent() const;
+    };
+    void setStatistics(Statistics* statistics);
+    const Statistics* statistics() const;
+    PoolUsage poolUsage() const;
+    // Records every call in the binary format described in AllocatorTrace.h, after an alloc for each block which is already
+    // allocated. The recorder is owned by the caller
+    void setTraceRecorder(AllocatorTraceRecorder* recorder);
+    AllocatorTraceRecorder* traceRecorder() const;
     // For debugging
     //    virtual void        validate() const {};
     //    virtual void        debugDump() const {};
@@ -678,6 +719,15 @@ struct __attribute__((aligned(16))) VIS_HIDDEN Allocator {
 
         void validate() const;
         void logAddressSpace(const char* prefix) const;
+
+        // A free block on one of its pool's free bins stores the links after the pool hint, so it needs room for both
+        struct FreeLinks {
+            AllocationMetadata* next;
+            AllocationMetadata* prev;
+        };
+        constexpr static uint64_t kMinBinnedSize = 32;
+        bool binnable() const;
+        FreeLinks* freeLinks() const;
     private:
         void setPoolHint(Pool* pool);
         // We use the low bit of previous to indicate if the pointer points to another metadata, or the pool
@@ -710,6 +760,8 @@ struct __attribute__((aligned(16))) VIS_HIDDEN Allocator {
         Allocator* allocator() const;
         void validate() const;
         void dump() const;
+        void addUsage(PoolUsage& usage) const;
+        void forEachAllocation(void (^callback)(void* ptr, uint64_t size)) const;
         bool vmAllocated() const {
             return _vmAllocated;
         }
@@ -718,6 +770,19 @@ struct __attribute__((aligned(16))) VIS_HIDDEN Allocator {
         }
     private:
         friend struct AllocationMetadata;
+        // Free blocks other than the last one are kept on free lists by size, so the best fit path can find a block without
+        // walking every block in the pool.  Sizes up to kMaxExactBinSize each get a bin, larger sizes share a bin per power of 2
+        constexpr static uint32_t kFreeBinCount     = 64;
+        constexpr static uint64_t kMaxExactBinSize  = 512;
+        // how many blocks of a shared bin to look at when looking for the best fit
+        constexpr static uint32_t kMaxBinScan       = 16;
+        static uint32_t freeBinIndex(uint64_t size);
+        void addToFreeBin(AllocationMetadata* metadata);
+        void removeFromFreeBin(AllocationMetadata* metadata);
+        AllocationMetadata* findFreeBinFit(uint64_t size) const;
+
+        AllocationMetadata* _freeBins[kFreeBinCount] = {};
+        uint64_t            _freeBinMap         = 0;     // bit N is set if _freeBins[N] is not empty
         Allocator*          _allocator          = nullptr;
         Pool*               _nextPool           = nullptr;
         Pool*               _prevPool           = nullptr;
@@ -734,6 +799,8 @@ struct __attribute__((aligned(16))) VIS_HIDDEN Allocator {
     Pool*               _currentPool    = nullptr;
     uint64_t            _allocatedBytes = 0;
     uint64_t            _logID          = 0;
+    Statistics*         _statistics     = nullptr;
+    AllocatorTraceRecorder* _traceRecorder = nullptr;
     bool                _bestFit        = false;
 #endif /* DYLD_FEATURE_USE_INTERNAL_ALLOCATOR */
 private:
@@ -0,0 +1,246 @@
+/* -*- mode: C++; c-basic-offset: 4; tab-width: 4 -*- vim: ft=cpp et ts=4 sw=4:
+ *
+ * Copyright (c) 2025 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef LSL_AllocatorTrace_h
+#define LSL_AllocatorTrace_h
+
+#include <TargetConditionals.h>
+#include <cstdint>
+#include <cstring>
+#include <bit>
+
+#if !TARGET_OS_EXCLAVEKIT
+#include <unistd.h>
+#endif // !TARGET_OS_EXCLAVEKIT
+
+#include "Defines.h"
+
+/* A compact binary log of the calls made on an Allocator, so that a real workload can be replayed against allocator variants
+ * (best fit on or off, different pool sizes, etc) with allocator_replay.
+ *
+ * All fields are little endian:
+ *
+ *   header:
+ *     char       magic[8]      "lslatrc\0"
+ *     uint32_t   version       1
+ *     uint32_t   reserved      0
+ *   records, until the end of the file:
+ *     uint8_t    op            AllocatorTrace::Op
+ *     sleb128    address       delta in granules from the address in the previous record
+ *     uleb128    log2(alignment)   alloc only
+ *     uleb128    size          alloc and realloc only
+ *
+ * A trace started on an allocator which is already in use begins with an alloc for each block allocated before it started,
+ * with an alignment of one granule.
+ *
+ * Addresses are only used to match up allocations with their frees and reallocs. Consecutive calls usually touch nearby
+ * addresses, so recording them as deltas keeps most records to a few bytes.
+ */
+
+namespace lsl {
+
+struct VIS_HIDDEN AllocatorTrace {
+    enum class Op : uint8_t {
+        alloc               = 1,
+        free                = 2,
+        reallocSucceeded    = 3,
+        reallocFailed       = 4,
+    };
+    struct Header {
+        char        magic[8];
+        uint32_t    version;
+        uint32_t    reserved;
+    };
+    struct Record {
+        Op          op;
+        uint64_t    address;
+        uint64_t    alignment;
+        uint64_t    size;
+    };
+    static constexpr char       kMagic[8]       = { 'l', 's', 'l', 'a', 't', 'r', 'c', '\0' };
+    static constexpr uint32_t   kVersion        = 1;
+    static constexpr uint64_t   kGranuleSize    = 16;
+
+    // Calls the handler for each record in the log. Returns false if the log is malformed
+    static bool forEachRecord(const uint8_t* start, uint64_t size, void (^handler)(const Record& record, bool& stop)) {
+        if ((size < sizeof(Header)) || (memcmp(start, kMagic, sizeof(kMagic)) != 0)) { return false; }
+        if (((const Header*)start)->version != kVersion) { return false; }
+        const uint8_t*  p           = start + sizeof(Header);
+        const uint8_t*  end         = start + size;
+        uint64_t        lastAddress = 0;
+        bool            stop        = false;
+        while ((p != end) && !stop) {
+            Record record = {};
+            record.op = (Op)*p++;
+            int64_t addressDelta;
+            if (!readSleb(p, end, addressDelta)) { return false; }
+            lastAddress += (uint64_t)addressDelta * kGranuleSize;
+            record.address = lastAddress;
+            switch (record.op) {
+                case Op::alloc: {
+                    uint64_t alignmentLog2;
+                    if (!readUleb(p, end, alignmentLog2) || (alignmentLog2 > 63) || !readUleb(p, end, record.size)) { return false; }
+                    record.alignment = 1ULL << alignmentLog2;
+                    break;
+                }
+                case Op::free:
+                    break;
+                case Op::reallocSucceeded:
+                case Op::reallocFailed:
+                    if (!readUleb(p, end, record.size)) { return false; }
+                    break;
+                default:
+                    return false;
+            }
+            handler(record, stop);
+        }
+        return true;
+    }
+
+    static bool readUleb(const uint8_t*& p, const uint8_t* end, uint64_t& value) {
+        value = 0;
+        for (uint32_t bit = 0; (p != end) && (bit < 64); bit += 7) {
+            uint8_t byte = *p++;
+            value |= ((uint64_t)(byte & 0x7F) << bit);
+            if ((byte & 0x80) == 0) { return true; }
+        }
+        return false;
+    }
+
+    static bool readSleb(const uint8_t*& p, const uint8_t* end, int64_t& value) {
+        value = 0;
+        for (uint32_t bit = 0; (p != end) && (bit < 64); ) {
+            uint8_t byte = *p++;
+            value |= ((int64_t)(byte & 0x7F) << bit);
+            bit += 7;
+            if ((byte & 0x80) == 0) {
+                // sign extend negative numbers
+                if (((byte & 0x40) != 0) && (bit < 64)) {
+                    value |= (~0ULL) << bit;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// Buffers trace records and writes them to a file descriptor whenever the buffer fills up. This does not allocate, so it can
+// be attached to any allocator, including the one it lives in.
+struct VIS_HIDDEN AllocatorTraceRecorder {
+    AllocatorTraceRecorder(int fd) : _fd(fd) {
+        AllocatorTrace::Header header = {};
+        memcpy(header.magic, AllocatorTrace::kMagic, sizeof(header.magic));
+        header.version = AllocatorTrace::kVersion;
+        memcpy(_buffer, &header, sizeof(header));
+        _used = sizeof(header);
+    }
+
+    void recordAlloc(void* ptr, uint64_t alignment, uint64_t size) {
+        uint8_t* p = start(AllocatorTrace::Op::alloc, ptr);
+        p = writeUleb(p, std::countr_zero(alignment));
+        p = writeUleb(p, size);
+        finish(p);
+    }
+
+    void recordFree(void* ptr) {
+        finish(start(AllocatorTrace::Op::free, ptr));
+    }
+
+    void recordRealloc(void* ptr, uint64_t size, bool succeeded) {
+        uint8_t* p = start(succeeded ? AllocatorTrace::Op::reallocSucceeded : AllocatorTrace::Op::reallocFailed, ptr);
+        finish(writeUleb(p, size));
+    }
+
+    void flush() {
+#if !TARGET_OS_EXCLAVEKIT
+        const uint8_t* p = _buffer;
+        while ((_fd != -1) && (p != &_buffer[_used])) {
+            ssize_t written = ::write(_fd, p, &_buffer[_used] - p);
+            if (written <= 0) {
+                // Stop tracing rather than write a log with a hole in it
+                _fd = -1;
+                break;
+            }
+            p += written;
+        }
+#endif // !TARGET_OS_EXCLAVEKIT
+        _used = 0;
+    }
+
+private:
+    // An op, a 10 byte address delta, and two 10 byte ulebs
+    static constexpr uint32_t kMaxRecordSize    = 31;
+    static constexpr uint32_t kBufferSize       = 4096;
+
+    uint8_t* start(AllocatorTrace::Op op, void* ptr) {
+        if (_used + kMaxRecordSize > kBufferSize) {
+            flush();
+        }
+        uint8_t* p = &_buffer[_used];
+        *p++ = (uint8_t)op;
+        int64_t addressDelta = (int64_t)((uint64_t)ptr - _lastAddress) / (int64_t)AllocatorTrace::kGranuleSize;
+        _lastAddress = (uint64_t)ptr;
+        return writeSleb(p, addressDelta);
+    }
+
+    void finish(uint8_t* p) {
+        _used = (uint32_t)(p - _buffer);
+    }
+
+    static uint8_t* writeUleb(uint8_t* p, uint64_t value) {
+        do {
+            uint8_t byte = value & 0x7F;
+            value >>= 7;
+            if (value != 0) {
+                byte |= 0x80;
+            }
+            *p++ = byte;
+        } while (value != 0);
+        return p;
+    }
+
+    static uint8_t* writeSleb(uint8_t* p, int64_t value) {
+        bool more = true;
+        while (more) {
+            uint8_t byte = value & 0x7F;
+            value >>= 7;
+            more = !(((value == 0) && ((byte & 0x40) == 0)) || ((value == -1) && ((byte & 0x40) != 0)));
+            if (more) {
+                byte |= 0x80;
+            }
+            *p++ = byte;
+        }
+        return p;
+    }
+
+    uint8_t     _buffer[kBufferSize];
+    uint32_t    _used           = 0;
+    uint64_t    _lastAddress    = 0;
+    int         _fd             = -1;
+};
+
+} // namespace lsl
+
+#endif /* LSL_AllocatorTrace_h */
@@ -28,10 +28,13 @@
 #include "Archive.h"
 
 // stl
+#include <algorithm>
+#include <array>
 #include <string_view>
 
 // Darwin
 #include <ar.h>
+#include <dispatch/dispatch.h>
 #include <mach-o/ranlib.h>
 #include <mach/mach.h>
 #include <mach/vm_map.h>
@@ -131,6 +134,19 @@ void Entry::getName(char *buf, int bufsz) const
   }
 }
 
+std::string_view Entry::name() const
+{
+    // same as getName(), but without the copy
+    if ( hasLongName() ) {
+        const char* longName = ((char*)this) + sizeof(ar_hdr);
+        return std::string_view(longName, strnlen(longName, (size_t)getLongNameSpace()));
+    }
+    size_t len = 0;
+    while ( (len < sizeof(ar_name)) && (ar_name[len] != '\0') && (ar_name[len] != ' ') )
+        ++len;
+    return std::string_view(ar_name, len);
+}
+
 uint64_t Entry::modificationTime() const
 {
     char temp[14];
@@ -196,12 +212,11 @@ std::optional<Archive> Archive::isArchive(std::span<const uint8_t> buffer)
     return std::nullopt;
 }
 
-Error Archive::forEachMember(void (^handler)(const Member&, bool& stop)) const
+Error Archive::forEachEntry(void (^handler)(const Entry*, std::span<const uint8_t> content, unsigned memberIndex, bool& stop)) const
 {
     const Entry* current = (Entry*)(buffer.data() + archive_magic.size());
     const Entry* const end = (Entry*)(buffer.data() + buffer.size());
 
-    std::array<char, 256> nameBuffer;
     bool stop = false;
     unsigned memberIndex = 1;
     while ( !stop && current < end ) {
@@ -221,8 +236,7 @@ Error Archive::forEachMember(void (^handler)(const Member&, bool& stop)) const
         if ( next > end )
             return Error("malformed archive, member exceeds file size");
 
-        current->getName(nameBuffer.data(), nameBuffer.size());
-        handler(Member{ nameBuffer.data(), content, current->modificationTime(), memberIndex }, stop);
+        handler(current, content, memberIndex, stop);
         current = next;
         memberIndex++;
     }
@@ -230,8 +244,26 @@ Error Archive::forEachMember(void (^handler)(const Member&, bool& stop)) const
     return Error::none();
 }
 
+Error Archive::forEachMember(void (^handler)(const Member&, bool& stop)) const
+{
+    __block std::array<char, 256> nameBuffer;
+    return forEachEntry(^(const Entry* entry, std::span<const uint8_t> content, unsigned memberIndex, bool& stop) {
+        entry->getName(nameBuffer.data(), nameBuffer.size());
+        handler(Member{ nameBuffer.data(), content, entry->modificationTime(), memberIndex }, stop);
+    });
+}
+
+Error Archive::makeMemberIndex(std::vector<Member>& members) const
+{
+    return forEachEntry(^(const Entry* entry, std::span<const uint8_t> content, unsigned memberIndex, bool& stop) {
+        members.push_back(Member{ entry->name(), content, entry->modificationTime(), memberIndex });
+    });
+}
+
 static bool isBitCodeHeader(std::span<const uint8_t> contents)
 {
+    if ( contents.size() < 4 )
+        return false;
     return (contents[0] == 0xDE) && (contents[1] == 0xC0) && (contents[2] == 0x17) && (contents[3] == 0x0B);
 }
 
@@ -269,6 +301,51 @@ Error Archive::forEachMachO(void (^handler)(const Member&, const mach_o::Header*
     return std::move(err);
 }
 
+static bool isSymdefName(std::string_view name)
+{
+    return (name == SYMDEF) || (name == SYMDEF_SORTED) || (name == SYMDEF_64) || (name == SYMDEF_64_SORTED);
+}
+
+void Archive::forEachMachOConcurrently(std::span<const Member> members,
+                                       void (^handler)(const Member&, const mach_o::Header*, const mach_o::Error& memberError)) const
+{
+    // Only the first SYMDEF is allowed, so find it up front rather than have the workers agree on it
+    size_t firstSymdefIndex = members.size();
+    for ( size_t i = 0; i != members.size(); ++i ) {
+        if ( isSymdefName(members[i].name) && !Header::isMachO(members[i].contents) && !isBitCodeHeader(members[i].contents) ) {
+            firstSymdefIndex = i;
+            break;
+        }
+    }
+
+    dispatch_apply(members.size(), DISPATCH_APPLY_AUTO, ^(size_t i) {
+        const Member& indexMember = members[i];
+
+        // the index names aren't NUL terminated, but clients expect them to be
+        std::array<char, 256> nameBuffer;
+        size_t nameLength = std::min(indexMember.name.size(), nameBuffer.size() - 1);
+        memcpy(nameBuffer.data(), indexMember.name.data(), nameLength);
+        nameBuffer[nameLength] = '\0';
+        const Member member = { std::string_view(nameBuffer.data(), nameLength), indexMember.contents, indexMember.mtime, indexMember.memberIndex };
+
+        if ( const Header* header = Header::isMachO(member.contents) ) {
+            handler(member, header, Error::none());
+        }
+        else if ( isBitCodeHeader(member.contents) ) {
+            handler(member, nullptr, Error::none());
+        }
+        else if ( i == firstSymdefIndex ) {
+            return;
+        }
+        else if ( isSymdefName(member.name) ) {
+            handler(member, nullptr, Error("multiple SYMDEF member files found in an archive"));
+        }
+        else {
+            handler(member, nullptr, Error("archive member '%s' not a mach-o file", member.name.data()));
+        }
+    });
+}
+
 }
 
 #endif // !TARGET_OS_EXCLAVEKIT
@@ -34,6 +34,8 @@
 // stl
 #include <string_view>
 #include <optional>
+#include <span>
+#include <vector>
 
 // mach_o
 #include "Header.h"
@@ -44,6 +46,7 @@ class Entry : ar_hdr
 {
 public:
     void                        getName(char *, int) const;
+    std::string_view            name() const;
     uint64_t                    modificationTime() const;
     Error                       content(std::span<const uint8_t>& content) const;
     Error                       next(Entry*& next) const;
@@ -84,6 +87,16 @@ public:
     mach_o::Error   forEachMember(void (^handler)(const Member&, bool& stop)) const;
     mach_o::Error   forEachMachO(void (^handler)(const Member&, const mach_o::Header*, bool& stop)) const;
 
+    // Records every member in one pass over the archive.  Nothing is copied, the names and contents point in to
+    // the archive buffer, so the names are not NUL terminated, and the index is only valid while the buffer is mapped
+    mach_o::Error   makeMemberIndex(std::vector<Member>& members) const;
+
+    // Calls the handler concurrently for each member in the index.  Members which are not mach-o or bitcode are
+    // passed to the handler with a memberError (and a null header), and don't stop the other members being visited.
+    // The name of the Member passed to the handler is NUL terminated
+    void            forEachMachOConcurrently(std::span<const Member> members,
+                                             void (^handler)(const Member&, const mach_o::Header*, const mach_o::Error& memberError)) const;
+
     std::span<const uint8_t> buffer;
 
     constexpr static std::string_view archive_magic = "!<arch>\n";
@@ -91,6 +104,8 @@ public:
 protected:
 
     Archive(std::span<const uint8_t> buffer): buffer(buffer) {}
+
+    mach_o::Error   forEachEntry(void (^handler)(const Entry*, std::span<const uint8_t> content, unsigned memberIndex, bool& stop)) const;
 };
 }
 
@@ -24,6 +24,7 @@
 #include <limits.h>
 #include <stdlib.h>
 #include <string.h>
+#include <algorithm>
 #include <unordered_map>
 #include <unordered_set>
 
@@ -415,6 +416,8 @@ bool CompactUnwind::findUnwindInfo(uint32_t targetFunctionOffset, UnwindInfo& re
 {
     // binary search first level table
     const unwind_info_section_header_index_entry* firstLevelTable = (unwind_info_section_header_index_entry*)(((uint8_t*)_unwindTable) + _unwindTable->indexSectionOffset);
+    if ( _unwindTable->indexCount < 2 )
+        return false;  // no functions, just the end sentinel
     if ( targetFunctionOffset < firstLevelTable[0].functionOffset )
         return false;  // target before range covered by unwind info
     uint32_t low  = 0;
@@ -436,15 +439,18 @@ bool CompactUnwind::findUnwindInfo(uint32_t targetFunctionOffset, UnwindInfo& re
         }
     }
     const uint32_t firstLevelIndex             = low;
+    if ( firstLevelIndex == last )
+        return false;  // target at or beyond the end sentinel
     const uint32_t firstLevelFunctionOffset    = firstLevelTable[firstLevelIndex].functionOffset;
     const uint32_t firstLevelEndFunctionOffset = firstLevelTable[firstLevelIndex+1].functionOffset;
     const void*    secondLevelAddr             = (uint8_t*)_unwindTable + firstLevelTable[firstLevelIndex].secondLevelPagesSectionOffset;
 
-    if ( targetFunctionOffset > firstLevelEndFunctionOffset )
+    if ( targetFunctionOffset >= firstLevelEndFunctionOffset )
         return false;  // target beyond range covered by unwind info
 
     // do a binary search of second level page index, where index[e].offset <= targetOffset < index[e+1].offset
     uint32_t pageKind    = *((uint32_t*)secondLevelAddr);
+    bool     found       = false;
     if ( pageKind == UNWIND_SECOND_LEVEL_REGULAR ) {
         // regular page
         const unwind_info_regular_second_level_page_header* pageHeader = (unwind_info_regular_second_level_page_header*)secondLevelAddr;
@@ -461,6 +467,7 @@ bool CompactUnwind::findUnwindInfo(uint32_t targetFunctionOffset, UnwindInfo& re
                     result.encoding   = entries[mid].encoding;
                     result.lsdaOffset = 0;
                     result.personalityOffset = 0;
+                    found = true;
                     break;
                 }
                 else {
@@ -479,8 +486,9 @@ bool CompactUnwind::findUnwindInfo(uint32_t targetFunctionOffset, UnwindInfo& re
         const uint32_t                                         targetOffset    = targetFunctionOffset - firstLevelFunctionOffset;
         const uint32_t*                                        commonEncodings = (uint32_t*)(((uint8_t*)_unwindTable)+_unwindTable->commonEncodingsArraySectionOffset);
         const uint32_t*                                        pageEncodings   = (uint32_t*)(((uint8_t*)pageHeader)+pageHeader->encodingsPageOffset);
-        last = pageHeader->entryCount - 1;
+        low  = 0;
         high = pageHeader->entryCount;
+        last = pageHeader->entryCount - 1;
         while ( low < high ) {
             uint32_t mid = (low + high)/2;
             if ( UNWIND_INFO_COMPRESSED_ENTRY_FUNC_OFFSET(entries[mid]) <= targetOffset ) {
@@ -490,10 +498,11 @@ bool CompactUnwind::findUnwindInfo(uint32_t targetFunctionOffset, UnwindInfo& re
                     if ( encodingIndex < _unwindTable->commonEncodingsArrayCount )
                         result.encoding = commonEncodings[encodingIndex];
                     else
-                        result.encoding = pageEncodings[encodingIndex];
+                        result.encoding = pageEncodings[encodingIndex - _unwindTable->commonEncodingsArrayCount];
                     result.lsdaOffset = 0;
                     result.personalityOffset = 0;
-                   break;
+                    found = true;
+                    break;
                 }
                 else {
                     low = mid+1;
@@ -504,9 +513,8 @@ bool CompactUnwind::findUnwindInfo(uint32_t targetFunctionOffset, UnwindInfo& re
             }
         }
     }
-    else {
-        return false;
-    }
+    if ( !found )
+        return false;  // target before the first function in the page, or unknown page kind
 
     if ( result.encoding & UNWIND_HAS_LSDA ) {
         // binary search lsda table range for entry with exact match for functionOffset
@@ -531,7 +539,7 @@ bool CompactUnwind::findUnwindInfo(uint32_t targetFunctionOffset, UnwindInfo& re
         uint32_t personalityIndex = (result.encoding & UNWIND_PERSONALITY_MASK) >> (__builtin_ctz(UNWIND_PERSONALITY_MASK));
         if ( personalityIndex != 0 ) {
             --personalityIndex; // change 1-based to zero-based index
-            if ( personalityIndex > _unwindTable->personalityArrayCount )
+            if ( personalityIndex >= _unwindTable->personalityArrayCount )
                  return false;
             const uint32_t* personalityArray = (uint32_t*)((uint8_t*)_unwindTable + _unwindTable->personalityArraySectionOffset);
             result.personalityOffset = personalityArray[personalityIndex];
@@ -541,6 +549,96 @@ bool CompactUnwind::findUnwindInfo(uint32_t targetFunctionOffset, UnwindInfo& re
 }
 
 
+void CompactUnwindLookupTable::build() const
+{
+    // malformed tables are left to the slow path, which only reads what it needs
+    if ( _unwind.valid() )
+        return;
+
+    const unwind_info_section_header*             header          = _unwind._unwindTable;
+    const size_t                                  tableSize       = _unwind._unwindTableSize;
+    const uint8_t*                                tableStart      = (uint8_t*)header;
+    const unwind_info_section_header_index_entry* firstLevelTable = (unwind_info_section_header_index_entry*)(tableStart + header->indexSectionOffset);
+    const uint32_t*                               commonEncodings = (uint32_t*)(tableStart + header->commonEncodingsArraySectionOffset);
+    if ( header->indexCount < 2 )
+        return;
+
+    std::vector<Entry> entries;
+    for ( uint32_t i = 0; i < header->indexCount - 1; ++i ) {
+        const unwind_info_section_header_index_entry& firstLevel = firstLevelTable[i];
+        if ( firstLevel.secondLevelPagesSectionOffset + sizeof(unwind_info_compressed_second_level_page_header) > tableSize )
+            return;
+        const uint8_t* secondLevelAddr = tableStart + firstLevel.secondLevelPagesSectionOffset;
+        uint32_t       pageKind        = *((uint32_t*)secondLevelAddr);
+        if ( pageKind == UNWIND_SECOND_LEVEL_REGULAR ) {
+            const unwind_info_regular_second_level_page_header* pageHeader = (unwind_info_regular_second_level_page_header*)secondLevelAddr;
+            const unwind_info_regular_second_level_entry*       pageEntries = (unwind_info_regular_second_level_entry*)(secondLevelAddr + pageHeader->entryPageOffset);
+            if ( (uint8_t*)(pageEntries + pageHeader->entryCount) > tableStart + tableSize )
+                return;
+            for ( uint32_t j = 0; j < pageHeader->entryCount; ++j )
+                entries.push_back({ pageEntries[j].functionOffset, pageEntries[j].encoding });
+        }
+        else if ( pageKind == UNWIND_SECOND_LEVEL_COMPRESSED ) {
+            const unwind_info_compressed_second_level_page_header* pageHeader    = (unwind_info_compressed_second_level_page_header*)secondLevelAddr;
+            const uint32_t*                                        pageEntries   = (uint32_t*)(secondLevelAddr + pageHeader->entryPageOffset);
+            const uint32_t*                                        pageEncodings = (uint32_t*)(secondLevelAddr + pageHeader->encodingsPageOffset);
+            if ( (uint8_t*)(pageEntries + pageHeader->entryCount) > tableStart + tableSize )
+                return;
+            if ( (uint8_t*)(pageEncodings + pageHeader->encodingsCount) > tableStart + tableSize )
+                return;
+            for ( uint32_t j = 0; j < pageHeader->entryCount; ++j ) {
+                uint32_t encodingIndex = UNWIND_INFO_COMPRESSED_ENTRY_ENCODING_INDEX(pageEntries[j]);
+                uint32_t encoding;
+                if ( encodingIndex < header->commonEncodingsArrayCount )
+                    encoding = commonEncodings[encodingIndex];
+                else if ( encodingIndex - header->commonEncodingsArrayCount < pageHeader->encodingsCount )
+                    encoding = pageEncodings[encodingIndex - header->commonEncodingsArrayCount];
+                else
+                    return;
+                entries.push_back({ UNWIND_INFO_COMPRESSED_ENTRY_FUNC_OFFSET(pageEntries[j]) + firstLevel.functionOffset, encoding });
+            }
+        }
+        else {
+            return;
+        }
+    }
+
+    // the linker emits functions in address order, so anything else is malformed
+    if ( !std::is_sorted(entries.begin(), entries.end(), [](const Entry& l, const Entry& r) { return l.funcOffset < r.funcOffset; }) )
+        return;
+
+    _entries       = std::move(entries);
+    _endFuncOffset = firstLevelTable[header->indexCount - 1].functionOffset;
+    _useTable      = true;
+}
+
+bool CompactUnwindLookupTable::findUnwindInfo(uint32_t funcOffset, CompactUnwind::UnwindInfo& info) const
+{
+    std::call_once(_buildOnce, [this]() { build(); });
+    if ( !_useTable )
+        return _unwind.findUnwindInfo(funcOffset, info);
+
+    if ( _entries.empty() || (funcOffset < _entries.front().funcOffset) || (funcOffset >= _endFuncOffset) )
+        return false;
+
+    // find the last function starting at or before funcOffset
+    auto it = std::upper_bound(_entries.begin(), _entries.end(), funcOffset, [](uint32_t offset, const Entry& entry) {
+        return offset < entry.funcOffset;
+    });
+    const Entry& entry = *(it - 1);
+
+    // LSDAs and personalities are rare, and need the first level index, so let the full lookup find them
+    if ( entry.encoding & UNWIND_HAS_LSDA )
+        return _unwind.findUnwindInfo(funcOffset, info);
+
+    info.funcOffset        = entry.funcOffset;
+    info.encoding          = entry.encoding;
+    info.lsdaOffset        = 0;
+    info.personalityOffset = 0;
+    return true;
+}
+
+
 uint32_t CompactUnwind::compactUnwindEntrySize(bool is64)
 {
     return is64 ? (4 * sizeof(uint64_t)) : (5 * sizeof(uint32_t));
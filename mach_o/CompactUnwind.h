@@ -27,6 +27,8 @@
 
 #include <span>
 #include <stdint.h>
+#include <mutex>
+#include <vector>
 
 #include "MachODefines.h"
 #include "Error.h"
@@ -58,6 +60,8 @@ protected:
                         // used by the CompactUnwindWriter subclass
                         CompactUnwind() = default;
 
+    friend class CompactUnwindLookupTable;
+
 private:
     Error               forEachFirstLevelTableEntry(void (^callback)(uint32_t funcsStartOffset, uint32_t funcsEndOffset, uint32_t secondLevelOffset, uint32_t lsdaIndexOffset)) const;
     Error               forEachSecondLevelRegularTableEntry(const struct unwind_info_regular_second_level_page_header*, void (^callback)(const UnwindInfo&)) const;
@@ -73,6 +77,35 @@ protected:
 };
 
 
+/*!
+ * @class CompactUnwindLookupTable
+ *
+ * @abstract
+ *      Accelerates repeated findUnwindInfo() queries on one CompactUnwind, eg, from an offline unwinder.
+ *      On first use, the (funcOffset, encoding) of every function is copied out of the two level table
+ *      in to one sorted array, so each lookup is a single binary search over contiguous memory.
+ *      Thread safe.  The CompactUnwind must outlive the lookup table.
+ */
+class VIS_HIDDEN CompactUnwindLookupTable
+{
+public:
+                        CompactUnwindLookupTable(const CompactUnwind& unwind) : _unwind(unwind) { }
+
+    bool                findUnwindInfo(uint32_t funcOffset, CompactUnwind::UnwindInfo& info) const;
+
+private:
+    struct Entry { uint32_t funcOffset; uint32_t encoding; };
+
+    void                build() const;
+
+    const CompactUnwind&        _unwind;
+    mutable std::once_flag      _buildOnce;
+    mutable std::vector<Entry>  _entries;
+    mutable uint32_t            _endFuncOffset = 0;
+    mutable bool                _useTable      = false;
+};
+
+
 } // namespace mach_o
 
 #endif // mach_o_CompactUnwind_h
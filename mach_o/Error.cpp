@@ -40,19 +40,6 @@
 namespace mach_o {
 
 
-Error::Error(Error&& other)
-{
-    _buffer = other._buffer;
-    other._buffer = nullptr;
-}
-
-Error& Error::operator=(Error&& other)
-{
-    _buffer = other._buffer;
-    other._buffer = nullptr;
-    return *this;
-}
-
 
 Error Error::copy(const Error& other)
 {
@@ -61,7 +48,7 @@ Error Error::copy(const Error& other)
     return Error("%s", other.message());
 }
 
-Error::~Error()
+void Error::release()
 {
 //#if TARGET_OS_EXCLAVEKIT
 //    *_strBuf = '\0';
@@ -47,10 +47,10 @@ public:
                     Error() = default;
                     Error(const char* format, ...)  __attribute__((format(printf, 2, 3)));
                     Error(const char* format, va_list_wrap vaWrap) __attribute__((format(printf, 2, 0)));
-                    Error(Error&&); // can move
+                    Error(Error&& other) : _buffer(other._buffer) { other._buffer = nullptr; } // can move
                     Error& operator=(const Error&) = delete; //  can't copy assign
                     Error& operator=(Error&&); // can move
-                    ~Error();
+                    ~Error() { if ( _buffer != nullptr ) release(); } // success path is inline and never allocates
 
 
     void            append(const char* format, ...)  __attribute__((format(printf, 2, 3)));
@@ -65,6 +65,7 @@ public:
     static Error    none() { return Error(); }
 
 private:
+    void            release();
 
 #if TARGET_OS_EXCLAVEKIT
     char            _strBuf[1024];
@@ -72,6 +73,17 @@ private:
     void*           _buffer = nullptr;
 };
 
+inline Error& Error::operator=(Error&& other)
+{
+    if ( this != &other ) {
+        if ( _buffer != nullptr )
+            release();
+        _buffer       = other._buffer;
+        other._buffer = nullptr;
+    }
+    return *this;
+}
+
 
 
 } // namespace mach_o
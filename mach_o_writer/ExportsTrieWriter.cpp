@@ -75,17 +75,15 @@ struct VIS_HIDDEN GenericTrieNode
     std::string_view    cummulativeString;
     std::vector<Edge>   children;
     std::span<uint8_t>  terminalPayload;
-    uint32_t            trieOffset = 0;
-    uint32_t            trieSize = 0;
+    uint32_t            flatIndex = 0;
 
     GenericTrieNode(const std::string_view& s) : cummulativeString(s) {}
     ~GenericTrieNode() = default;
-
-    void  updateOffset(uint32_t& curOffset);
-    void  writeToStream(std::span<uint8_t>& bytes) const;
 };
 
 using Node = GenericTrieNode;
+using FlatNode = GenericTrieFlatNode;
+using FlatEdge = GenericTrieFlatEdge;
 
 struct VIS_HIDDEN SubtreeRoot
 {
@@ -104,17 +102,19 @@ struct VIS_HIDDEN TrieBuilder
     void  addTerminalNode(Node& parentNode, const WriterEntry&);
 };
 
-struct VIS_HIDDEN NodeWriter
-{
-    // root nodes of subtrees that are written concurrently
-    std::vector<const Node*> subtreeRoots;
-    // list of nodes that are written written separately, without their children
-    std::vector<const Node*> standaloneNodes;
-    std::span<uint8_t>       bytes;
-
-    void collectRecursive(const Node* node, size_t depth);
-    void write(const Node& node);
-    void writeRecursive(const Node& node);
+// The flattened nodes are split in to segments, each of which is a contiguous range of nodes.
+// Nodes near the root are standalone segments of 1 node.  Below them, each subtree is a segment,
+// which can be flattened and laid out without looking at any other segment
+struct VIS_HIDDEN TrieSegment
+{
+    Node*       node        = nullptr;
+    bool        isSubtree   = false;
+    uint32_t    firstNode   = 0;
+    uint32_t    nodeCount   = 0;
+    uint32_t    firstEdge   = 0;
+    uint32_t    edgeCount   = 0;
+    uint32_t    trieOffset  = 0;
+    uint32_t    trieSize    = 0;
 };
 
 //
@@ -437,12 +437,213 @@ const uint8_t* GenericTrieWriter::bytes(size_t& size)
     return _trieStart;
 }
 
-static void updateOffsetPostorder(Node* node, uint32_t& curOffset)
+// Nodes at this depth and below are flattened and laid out as part of a subtree segment
+static const size_t subtreeSegmentDepth = 4;
+
+// Segments are collected in the order their nodes are written, ie, the children of standalone nodes come first
+static void collectSegments(Node* node, size_t depth, std::vector<TrieSegment>& segments)
+{
+    if ( depth >= subtreeSegmentDepth ) {
+        segments.push_back({ node, true });
+        return;
+    }
+
+    for ( Edge& e : node->children )
+        collectSegments(e.child, depth + 1, segments);
+    segments.push_back({ node, false });
+}
+
+static void countSubtree(const Node* node, uint32_t& nodeCount, uint32_t& edgeCount)
+{
+    ++nodeCount;
+    edgeCount += (uint32_t)node->children.size();
+    for ( const Edge& e : node->children )
+        countSubtree(e.child, nodeCount, edgeCount);
+}
+
+// Flattens the subtree in postorder, and returns the index of 'node'
+static uint32_t flattenSubtree(Node* node, uint32_t& nextNode, uint32_t& nextEdge,
+                               std::vector<FlatNode>& flatNodes, std::vector<FlatEdge>& flatEdges)
+{
+    const uint32_t firstEdge = nextEdge;
+    nextEdge += (uint32_t)node->children.size();
+    for ( uint32_t i = 0; i != node->children.size(); ++i ) {
+        const Edge& e = node->children[i];
+        uint32_t childIndex = flattenSubtree(e.child, nextNode, nextEdge, flatNodes, flatEdges);
+        flatEdges[firstEdge + i] = { e.partialString, childIndex };
+    }
+
+    uint32_t index = nextNode++;
+    FlatNode& flatNode = flatNodes[index];
+    flatNode.terminalPayload = node->terminalPayload;
+    flatNode.firstEdge       = firstEdge;
+    flatNode.edgeCount       = (uint32_t)node->children.size();
+    node->flatIndex          = index;
+    return index;
+}
+
+// Flattens a node whose children have already been flattened
+static void flattenStandaloneNode(Node* node, uint32_t index, uint32_t firstEdge,
+                                  std::vector<FlatNode>& flatNodes, std::vector<FlatEdge>& flatEdges)
+{
+    for ( uint32_t i = 0; i != node->children.size(); ++i ) {
+        const Edge& e = node->children[i];
+        flatEdges[firstEdge + i] = { e.partialString, e.child->flatIndex };
+    }
+
+    FlatNode& flatNode = flatNodes[index];
+    flatNode.terminalPayload = node->terminalPayload;
+    flatNode.firstEdge       = firstEdge;
+    flatNode.edgeCount       = (uint32_t)node->children.size();
+    node->flatIndex          = index;
+}
+
+// byte for terminal node size in bytes, or 0x00 if not terminal node
+// teminal node (uleb128 flags, uleb128 addr [uleb128 other])
+// byte for child node count
+//  each child: zero terminated substring, uleb128 node offset
+static uint32_t nodeSize(const FlatNode& node, const std::vector<FlatNode>& flatNodes, const std::vector<FlatEdge>& flatEdges,
+                         bool useMaxChildOffsets = false)
 {
-    for ( Edge& e : node->children ) {
-        updateOffsetPostorder(e.child, curOffset);
+    uint32_t trieSize = 1; // length of node payload info when there is no payload (non-terminal)
+    if ( !node.terminalPayload.empty() ) {
+        // in terminal nodes, size is uleb128 encoded, so we include that in calculation
+        trieSize = (uint32_t)node.terminalPayload.size();
+        trieSize += uleb128_size(trieSize);
+    }
+    // add children
+    ++trieSize; // byte for count of chidren
+    for ( uint32_t i = 0; i != node.edgeCount; ++i ) {
+        const FlatEdge& edge = flatEdges[node.firstEdge + i];
+        uint32_t childOffset = useMaxChildOffsets ? UINT_MAX : flatNodes[edge.childIndex].trieOffset;
+        trieSize += edge.partialString.size() + 1 + uleb128_size(childOffset);
+    }
+    return trieSize;
+}
+
+static void writeNode(const FlatNode& node, const std::vector<FlatNode>& flatNodes, const std::vector<FlatEdge>& flatEdges,
+                      std::span<uint8_t>& bytes)
+{
+    if ( !node.terminalPayload.empty() ) {
+        std::span<const uint8_t> payload = node.terminalPayload;
+        write_uleb128(payload.size(), bytes);
+        std::copy(payload.begin(), payload.end(), bytes.begin());
+        bytes = bytes.subspan(payload.size());
+    }
+    else {
+        // no terminal uleb128 of zero is one byte of zero
+        *bytes.data() = 0;
+        bytes = bytes.subspan(1);
+    }
+    // write number of children
+    *bytes.data() = node.edgeCount;
+    bytes = bytes.subspan(1);
+    // write each child
+    for ( uint32_t i = 0; i != node.edgeCount; ++i ) {
+        const FlatEdge& e = flatEdges[node.firstEdge + i];
+        write_string(e.partialString, bytes);
+        write_uleb128(flatNodes[e.childIndex].trieOffset, bytes);
+    }
+}
+
+// Flattens all the nodes in to one array in the order they'll be written.  Subtrees are counted
+// and flattened in parallel, in to ranges given by a prefix sum of their counts
+static void flattenNodes(Node* rootNode, std::vector<TrieSegment>& segments,
+                         std::vector<FlatNode>& flatNodes, std::vector<FlatEdge>& flatEdges)
+{
+    for ( Edge& e : rootNode->children )
+        collectSegments(e.child, 1, segments);
+
+    dispatchForEach(std::span(segments), 1, [](size_t, TrieSegment& segment) {
+        if ( segment.isSubtree ) {
+            countSubtree(segment.node, segment.nodeCount, segment.edgeCount);
+        } else {
+            segment.nodeCount = 1;
+            segment.edgeCount = (uint32_t)segment.node->children.size();
+        }
+    });
+
+    // The root is always first
+    uint32_t nodeCount = 1;
+    uint32_t edgeCount = (uint32_t)rootNode->children.size();
+    for ( TrieSegment& segment : segments ) {
+        segment.firstNode = nodeCount;
+        segment.firstEdge = edgeCount;
+        nodeCount += segment.nodeCount;
+        edgeCount += segment.edgeCount;
+    }
+    flatNodes.resize(nodeCount);
+    flatEdges.resize(edgeCount);
+
+    dispatchForEach(std::span(segments), 1, [&flatNodes, &flatEdges](size_t, TrieSegment& segment) {
+        if ( !segment.isSubtree )
+            return;
+        uint32_t nextNode = segment.firstNode;
+        uint32_t nextEdge = segment.firstEdge;
+        flattenSubtree(segment.node, nextNode, nextEdge, flatNodes, flatEdges);
+        assert(nextNode == (segment.firstNode + segment.nodeCount));
+        assert(nextEdge == (segment.firstEdge + segment.edgeCount));
+    });
+
+    // Standalone nodes are after their children, so those have all been flattened already
+    for ( TrieSegment& segment : segments ) {
+        if ( !segment.isSubtree )
+            flattenStandaloneNode(segment.node, segment.firstNode, segment.firstEdge, flatNodes, flatEdges);
     }
-    node->updateOffset(curOffset);
+    flattenStandaloneNode(rootNode, 0, 0, flatNodes, flatEdges);
+}
+
+// Computes the offset and size of every node, and returns the size of the trie.
+// The size of a node depends on the uleb128 size of its children's offsets, and children come before parents.
+// So given the offset of a subtree, its layout can be computed without looking at any other segment.
+// This guesses the subtree offsets, lays out all subtrees in parallel, and then walks the segments in order
+// to find the real subtree offsets.  That repeats until the guesses are right.  Offsets only grow each time,
+// so this converges, and as the result is consistent it matches what a single postorder walk would produce
+static uint32_t updateOffsets(std::vector<TrieSegment>& segments,
+                              std::vector<FlatNode>& flatNodes, std::vector<FlatEdge>& flatEdges)
+{
+    // use a dummy large trie offset for all chidren of the root node to ensure
+    // enough space is reserved for their actual offset, so that the root
+    // node size is stable
+    FlatNode& root = flatNodes[0];
+    root.trieOffset = 0;
+    root.trieSize   = nodeSize(root, flatNodes, flatEdges, true);
+
+    uint32_t curOffset = root.trieSize;
+    bool     changed   = true;
+    while ( changed ) {
+        dispatchForEach(std::span(segments), 1, [&flatNodes, &flatEdges](size_t, TrieSegment& segment) {
+            if ( !segment.isSubtree )
+                return;
+            uint32_t offset = segment.trieOffset;
+            for ( uint32_t i = segment.firstNode; i != (segment.firstNode + segment.nodeCount); ++i ) {
+                FlatNode& node = flatNodes[i];
+                node.trieSize   = nodeSize(node, flatNodes, flatEdges);
+                node.trieOffset = offset;
+                offset += node.trieSize;
+            }
+            segment.trieSize = offset - segment.trieOffset;
+        });
+
+        changed   = false;
+        curOffset = root.trieSize;
+        for ( TrieSegment& segment : segments ) {
+            if ( segment.isSubtree ) {
+                if ( segment.trieOffset != curOffset ) {
+                    segment.trieOffset = curOffset;
+                    changed = true;
+                }
+                curOffset += segment.trieSize;
+            } else {
+                FlatNode& node = flatNodes[segment.firstNode];
+                node.trieSize   = nodeSize(node, flatNodes, flatEdges);
+                node.trieOffset = curOffset;
+                curOffset += node.trieSize;
+            }
+        }
+    }
+
+    return curOffset;
 }
 
 void GenericTrieWriter::buildNodes(std::span<const WriterEntry> entries)
@@ -485,58 +686,18 @@ void GenericTrieWriter::buildNodes(std::span<const WriterEntry> entries)
     dumpNodes(&rootNode);
 #endif
 
-    uint32_t curOffset = 0;
-    {
-        // set a dummy large trie offset for all chidren of the root node to ensure
-        // enough space is reserved for their actual offset, so that the root
-        // node size is stable
-        for ( Edge& e : _rootNode->children ) {
-            e.child->trieOffset = UINT_MAX;
-        }
-        _rootNode->updateOffset(curOffset);
-    }
+    if ( _buildError.hasError() )
+        return;
 
-    // now that the size of the root node is known, offsets can
-    // be computed recursively in a single iteration through a postorder traversal
-    for ( Edge& e : _rootNode->children )
-        updateOffsetPostorder(e.child, curOffset);
-    _trieSize = curOffset;
+    // flatten the nodes in to the order they'll be written, then lay them out
+    std::vector<TrieSegment> segments;
+    flattenNodes(_rootNode, segments, _flatNodes, _flatEdges);
+    _trieSize = updateOffsets(segments, _flatNodes, _flatEdges);
 
     if ( uint32_t pad = _trieSize % 8; pad != 0 )
         _trieSize += 8 - pad;
 }
 
-void NodeWriter::collectRecursive(const Node* node, size_t depth)
-{
-    standaloneNodes.push_back(node);
-
-    if ( (depth + 1) > 4 ) {
-        subtreeRoots.reserve(subtreeRoots.size() + node->children.size());
-        std::transform(node->children.begin(), node->children.end(), std::back_inserter(subtreeRoots), [](const Edge& e) { return e.child; });
-    } else {
-        for ( const Edge& e : node->children ) {
-            collectRecursive(e.child, depth + 1);
-        }
-    }
-}
-
-void NodeWriter::write(const Node& node)
-{
-    std::span<uint8_t> nodeChunk = bytes.subspan(node.trieOffset);
-    assert(nodeChunk.size() >= node.trieSize);
-    nodeChunk = nodeChunk.subspan(0, node.trieSize);
-    node.writeToStream(nodeChunk);
-}
-
-void NodeWriter::writeRecursive(const Node& node)
-{
-    write(node);
-
-    for ( const Edge& e : node.children ) {
-        writeRecursive(*e.child);
-    }
-}
-
 void GenericTrieWriter::writeTrieBytes(std::span<uint8_t> bytes)
 {
     // set up trie buffer
@@ -544,66 +705,18 @@ void GenericTrieWriter::writeTrieBytes(std::span<uint8_t> bytes)
     _trieEnd   = bytes.end().base();
 
     assert(_rootNode != nullptr);
-
-    NodeWriter writer;
-    // reserve some initial space for nodes
-    writer.subtreeRoots.reserve(0x1000);
-    writer.standaloneNodes.reserve(0x1000);
-    writer.bytes = bytes;
-    writer.collectRecursive(_rootNode, 0);
-
-    // write subtrees
-    dispatchForEach(std::span(writer.subtreeRoots), 1, [&writer](size_t, const Node* node) {
-        writer.writeRecursive(*node);
+    assert(!_flatNodes.empty());
+
+    // every node already has its offset and size, and nodes don't overlap, so any
+    // range of nodes can be written concurrently with any other
+    const std::vector<FlatNode>& flatNodes = _flatNodes;
+    const std::vector<FlatEdge>& flatEdges = _flatEdges;
+    dispatchForEach(std::span(_flatNodes), 0x400, [bytes, &flatNodes, &flatEdges](size_t, const FlatNode& node) {
+        std::span<uint8_t> nodeChunk = bytes.subspan(node.trieOffset);
+        assert(nodeChunk.size() >= node.trieSize);
+        nodeChunk = nodeChunk.subspan(0, node.trieSize);
+        writeNode(node, flatNodes, flatEdges, nodeChunk);
     });
-    // write standalone nodes
-    dispatchForEach(std::span(writer.standaloneNodes), 64, [&writer](size_t, const Node* node) {
-        writer.write(*node);
-    });
-}
-
-// byte for terminal node size in bytes, or 0x00 if not terminal node
-// teminal node (uleb128 flags, uleb128 addr [uleb128 other])
-// byte for child node count
-//  each child: zero terminated substring, uleb128 node offset
-void Node::updateOffset(uint32_t& curOffset)
-{
-    trieSize = 1; // length of node payload info when there is no payload (non-terminal)
-    if ( !terminalPayload.empty() ) {
-        // in terminal nodes, size is uleb128 encoded, so we include that in calculation
-        trieSize = (uint32_t)terminalPayload.size();
-        trieSize += uleb128_size(trieSize);
-    }
-    // add children
-    ++trieSize; // byte for count of chidren
-    for ( Edge& edge : this->children ) {
-        trieSize += edge.partialString.size() + 1 + uleb128_size(edge.child->trieOffset);
-    }
-    trieOffset = curOffset;
-    curOffset += trieSize;
-}
-
-void Node::writeToStream(std::span<uint8_t>& bytes) const
-{
-    if ( !terminalPayload.empty() ) {
-        std::span<const uint8_t> payload = terminalPayload;
-        write_uleb128(payload.size(), bytes);
-        std::copy(payload.begin(), payload.end(), bytes.begin());
-        bytes = bytes.subspan(payload.size());
-    }
-    else {
-        // no terminal uleb128 of zero is one byte of zero
-        *bytes.data() = 0;
-        bytes = bytes.subspan(1);
-    }
-    // write number of children
-    *bytes.data() = children.size();
-    bytes = bytes.subspan(1);
-    // write each child
-    for ( const Edge& e : children ) {
-        write_string(e.partialString, bytes);
-        write_uleb128(e.child->trieOffset, bytes);
-    }
 }
 
 template<typename WriterEntryGetter>
@@ -51,6 +51,22 @@ using namespace mach_o;
 struct GenericTrieWriterEntry;
 struct GenericTrieNode;
 
+// Trie nodes are flattened in to the order they are written: the root, then every other node in postorder
+struct VIS_HIDDEN GenericTrieFlatEdge
+{
+    std::string_view            partialString;
+    uint32_t                    childIndex = 0;
+};
+
+struct VIS_HIDDEN GenericTrieFlatNode
+{
+    std::span<const uint8_t>    terminalPayload;
+    uint32_t                    firstEdge  = 0;
+    uint32_t                    edgeCount  = 0;
+    uint32_t                    trieOffset = 0;
+    uint32_t                    trieSize   = 0;
+};
+
 /*!
  * @class GenericTrieWriter
  *
@@ -71,10 +87,12 @@ public:
 protected:
     void            buildNodes(std::span<const GenericTrieWriterEntry> entries);
 
-    Error                _buildError;
-    std::vector<uint8_t> _trieBytes;
-    GenericTrieNode*     _rootNode=nullptr;
-    size_t               _trieSize;
+    Error                            _buildError;
+    std::vector<uint8_t>             _trieBytes;
+    GenericTrieNode*                 _rootNode=nullptr;
+    std::vector<GenericTrieFlatNode> _flatNodes;
+    std::vector<GenericTrieFlatEdge> _flatEdges;
+    size_t                           _trieSize;
 
     ChunkBumpAllocatorZone _allocatorZone;
 };
@@ -0,0 +1,594 @@
+/* -*- mode: C++; c-basic-offset: 4; tab-width: 4 -*-
+ *
+ * Copyright (c) 2025 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+#ifndef other_tools_DyldTraceFile_h
+#define other_tools_DyldTraceFile_h
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sstream>
+
+//
+// Reader, writer, and latency aggregation for dyld trace files.
+//
+// A dyld trace file is the dyld events from a ktrace session, saved in a simple format which can be
+// read without libktrace, eg, to aggregate traces from many devices on another machine.  dyld_usage -x
+// writes this format from a live session, or from a ktrace artifact with -R.
+//
+// This file only uses the C++ standard library, so that the traces can be read and aggregated on any
+// platform.  dyld_usage -A and dyld_trace_aggregate both use it.
+//
+// All fields are little endian:
+//
+//   header:
+//     char       magic[8]      "dyldtrc\0"
+//     uint32_t   version       1
+//     uint32_t   eventSize     size of each event record, currently 56.  Readers skip any extra bytes
+//   events, in timestamp order, until the end of the file:
+//     uint64_t   timestampNs   nanoseconds since an arbitrary per-file epoch
+//     uint64_t   threadID
+//     uint64_t   arg1..arg4    the raw kdebug arguments
+//     uint32_t   debugID       the raw kdebug debugid, including the DBG_FUNC_START/END bits
+//     uint32_t   pid
+//
+// Only events in the DBG_DYLD class are written, plus the global trace string events so that paths
+// and symbol names can be recovered.  Aggregation only uses the DBG_DYLD timing events.
+//
+namespace dyld_trace {
+
+static const char     kMagic[8]      = { 'd', 'y', 'l', 'd', 't', 'r', 'c', '\0' };
+static const uint32_t kVersion       = 1;
+
+// The parts of the kdebug debugid encoding we need, as <sys/kdebug.h> is only on Darwin.  dyld_usage checks
+// these against the real definitions
+static constexpr uint32_t kFuncStart        = 0x1;
+static constexpr uint32_t kFuncEnd          = 0x2;
+static constexpr uint32_t kEventIDMask      = 0xfffffffc;
+static constexpr uint32_t kDyldClass        = 31;
+static constexpr uint32_t kInternalSubclass = 7;
+static constexpr uint32_t kAPISubclass      = 8;
+
+static constexpr uint32_t eventID(uint32_t subclass, uint32_t code)
+{
+    return ((kDyldClass & 0xff) << 24) | ((subclass & 0xff) << 16) | ((code & 0x3fff) << 2);
+}
+
+struct FileHeader
+{
+    char        magic[8];
+    uint32_t    version;
+    uint32_t    eventSize;
+};
+
+struct Event
+{
+    uint64_t    timestampNs;
+    uint64_t    threadID;
+    uint64_t    arg1;
+    uint64_t    arg2;
+    uint64_t    arg3;
+    uint64_t    arg4;
+    uint32_t    debugID;
+    uint32_t    pid;
+};
+static_assert(sizeof(FileHeader) == 16, "dyld trace file header size changed");
+static_assert(sizeof(Event) == 56, "dyld trace event size changed");
+
+// The file is little endian whatever the host is, so fields are always read and written a byte at a time
+inline uint32_t loadLE32(const uint8_t* p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+inline uint64_t loadLE64(const uint8_t* p)
+{
+    return (uint64_t)loadLE32(p) | ((uint64_t)loadLE32(p + 4) << 32);
+}
+
+inline void storeLE32(uint8_t* p, uint32_t value)
+{
+    for ( int i = 0; i != 4; ++i )
+        p[i] = (uint8_t)(value >> (i * 8));
+}
+
+inline void storeLE64(uint8_t* p, uint64_t value)
+{
+    storeLE32(p, (uint32_t)value);
+    storeLE32(p + 4, (uint32_t)(value >> 32));
+}
+
+inline void encodeHeader(const FileHeader& header, uint8_t bytes[sizeof(FileHeader)])
+{
+    memcpy(bytes, header.magic, sizeof(header.magic));
+    storeLE32(bytes + 8,  header.version);
+    storeLE32(bytes + 12, header.eventSize);
+}
+
+inline FileHeader decodeHeader(const uint8_t bytes[sizeof(FileHeader)])
+{
+    FileHeader header;
+    memcpy(header.magic, bytes, sizeof(header.magic));
+    header.version   = loadLE32(bytes + 8);
+    header.eventSize = loadLE32(bytes + 12);
+    return header;
+}
+
+inline void encodeEvent(const Event& event, uint8_t bytes[sizeof(Event)])
+{
+    storeLE64(bytes + 0,  event.timestampNs);
+    storeLE64(bytes + 8,  event.threadID);
+    storeLE64(bytes + 16, event.arg1);
+    storeLE64(bytes + 24, event.arg2);
+    storeLE64(bytes + 32, event.arg3);
+    storeLE64(bytes + 40, event.arg4);
+    storeLE32(bytes + 48, event.debugID);
+    storeLE32(bytes + 52, event.pid);
+}
+
+inline Event decodeEvent(const uint8_t bytes[sizeof(Event)])
+{
+    Event event;
+    event.timestampNs = loadLE64(bytes + 0);
+    event.threadID    = loadLE64(bytes + 8);
+    event.arg1        = loadLE64(bytes + 16);
+    event.arg2        = loadLE64(bytes + 24);
+    event.arg3        = loadLE64(bytes + 32);
+    event.arg4        = loadLE64(bytes + 40);
+    event.debugID     = loadLE32(bytes + 48);
+    event.pid         = loadLE32(bytes + 52);
+    return event;
+}
+
+//
+// Writes events to a dyld trace file.  Not thread safe, as ktrace delivers events serially
+//
+class TraceWriter
+{
+public:
+    ~TraceWriter() { close(); }
+
+    bool open(const char* path, std::string& error)
+    {
+        _file = ::fopen(path, "wb");
+        if ( _file == nullptr ) {
+            error = std::string("could not create '") + path + "' (" + strerror(errno) + ")";
+            return false;
+        }
+        FileHeader header;
+        memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version   = kVersion;
+        header.eventSize = sizeof(Event);
+        uint8_t bytes[sizeof(FileHeader)];
+        encodeHeader(header, bytes);
+        if ( ::fwrite(bytes, sizeof(bytes), 1, _file) != 1 ) {
+            error = std::string("could not write to '") + path + "' (" + strerror(errno) + ")";
+            return false;
+        }
+        return true;
+    }
+
+    bool isOpen() const { return _file != nullptr; }
+
+    void write(const Event& event)
+    {
+        uint8_t bytes[sizeof(Event)];
+        encodeEvent(event, bytes);
+        ::fwrite(bytes, sizeof(bytes), 1, _file);
+    }
+
+    void close()
+    {
+        if ( _file != nullptr )
+            ::fclose(_file);
+        _file = nullptr;
+    }
+
+private:
+    FILE*   _file = nullptr;
+};
+
+// Reads all the events from a dyld trace file.  Returns false and sets 'error' if the file is not a valid trace.
+// If the file ends part way through an event, eg, the writer was killed, 'error' is set but the complete events
+// are still returned, along with true
+inline bool readTraceFile(const char* path, std::vector<Event>& events, std::string& error)
+{
+    FILE* file = ::fopen(path, "rb");
+    if ( file == nullptr ) {
+        error = std::string("could not open (") + strerror(errno) + ")";
+        return false;
+    }
+
+    uint8_t    headerBytes[sizeof(FileHeader)];
+    FileHeader header;
+    if ( ::fread(headerBytes, sizeof(headerBytes), 1, file) == 1 )
+        header = decodeHeader(headerBytes);
+    else
+        memset(&header, 0, sizeof(header));
+    if ( memcmp(header.magic, kMagic, sizeof(kMagic)) != 0 ) {
+        error = "not a dyld trace file";
+        ::fclose(file);
+        return false;
+    }
+    if ( header.version != kVersion ) {
+        error = "unsupported dyld trace version " + std::to_string(header.version);
+        ::fclose(file);
+        return false;
+    }
+    if ( header.eventSize < sizeof(Event) ) {
+        error = "event size " + std::to_string(header.eventSize) + " is too small";
+        ::fclose(file);
+        return false;
+    }
+
+    // Read in large chunks, as traces can have millions of events.  A partial event at the end of a chunk is
+    // moved to the start of the buffer, to be completed by the next read
+    std::vector<uint8_t> buffer((size_t)header.eventSize * 4096);
+    size_t used = 0;
+    size_t count;
+    while ( (count = ::fread(&buffer[used], 1, buffer.size() - used, file)) != 0 ) {
+        used += count;
+        size_t eventCount = used / header.eventSize;
+        for ( size_t i = 0; i != eventCount; ++i )
+            events.push_back(decodeEvent(&buffer[i * header.eventSize]));
+        size_t consumed = eventCount * header.eventSize;
+        memmove(buffer.data(), &buffer[consumed], used - consumed);
+        used -= consumed;
+    }
+
+    bool result = true;
+    if ( ::ferror(file) ) {
+        error = std::string("read failed (") + strerror(errno) + ")";
+        result = false;
+    }
+    else if ( used != 0 ) {
+        error = "truncated event at end of file (" + std::to_string(used) + " of " + std::to_string(header.eventSize) + " bytes)";
+    }
+    ::fclose(file);
+    return result;
+}
+
+//
+// A latency histogram which can be merged with other histograms.  Values below 16ns get a bucket each,
+// and each power of 2 above that is split in to 16 linear buckets, so percentiles are within 1/16th of
+// the real value.
+//
+class LatencyHistogram
+{
+public:
+    void add(uint64_t value)
+    {
+        ++_buckets[bucketIndex(value)];
+        if ( (_count == 0) || (value < _min) )
+            _min = value;
+        if ( value > _max )
+            _max = value;
+        ++_count;
+        _sum += value;
+    }
+
+    void merge(const LatencyHistogram& other)
+    {
+        if ( other._count == 0 )
+            return;
+        for ( uint32_t i = 0; i != kBucketCount; ++i )
+            _buckets[i] += other._buckets[i];
+        if ( (_count == 0) || (other._min < _min) )
+            _min = other._min;
+        if ( other._max > _max )
+            _max = other._max;
+        _count += other._count;
+        _sum   += other._sum;
+    }
+
+    // Returns the value at percentile 'p', which is in the range [0, 100]
+    uint64_t percentile(double p) const
+    {
+        if ( _count == 0 )
+            return 0;
+        uint64_t rank = (uint64_t)((p / 100.0) * (double)_count + 0.5);
+        if ( rank == 0 )
+            rank = 1;
+        if ( rank > _count )
+            rank = _count;
+
+        uint64_t seen = 0;
+        for ( uint32_t i = 0; i != kBucketCount; ++i ) {
+            seen += _buckets[i];
+            if ( seen >= rank ) {
+                // Report the middle of the bucket, clamped to what we actually saw
+                uint64_t value = bucketLowerBound(i) + bucketWidth(i) / 2;
+                if ( value < _min )
+                    value = _min;
+                if ( value > _max )
+                    value = _max;
+                return value;
+            }
+        }
+        return _max;
+    }
+
+    uint64_t count() const  { return _count; }
+    uint64_t min() const    { return _min; }
+    uint64_t max() const    { return _max; }
+    uint64_t mean() const   { return (_count == 0) ? 0 : (_sum / _count); }
+
+private:
+    static const uint32_t kSubBucketBits  = 4;
+    static const uint32_t kSubBucketCount = 1 << kSubBucketBits;
+    static const uint32_t kBucketCount    = kSubBucketCount + (64 - kSubBucketBits) * kSubBucketCount;
+
+    static uint32_t bucketIndex(uint64_t value)
+    {
+        if ( value < kSubBucketCount )
+            return (uint32_t)value;
+        uint32_t exponent = 63 - __builtin_clzll(value);
+        uint32_t subBucket = (uint32_t)(value >> (exponent - kSubBucketBits)) & (kSubBucketCount - 1);
+        return kSubBucketCount + (exponent - kSubBucketBits) * kSubBucketCount + subBucket;
+    }
+
+    static uint64_t bucketLowerBound(uint32_t index)
+    {
+        if ( index < kSubBucketCount )
+            return index;
+        uint32_t exponent  = (index - kSubBucketCount) / kSubBucketCount + kSubBucketBits;
+        uint32_t subBucket = (index - kSubBucketCount) % kSubBucketCount;
+        return (1ULL << exponent) + ((uint64_t)subBucket << (exponent - kSubBucketBits));
+    }
+
+    static uint64_t bucketWidth(uint32_t index)
+    {
+        if ( index < kSubBucketCount )
+            return 1;
+        uint32_t exponent = (index - kSubBucketCount) / kSubBucketCount + kSubBucketBits;
+        return 1ULL << (exponent - kSubBucketBits);
+    }
+
+    uint64_t    _buckets[kBucketCount] = { };
+    uint64_t    _count = 0;
+    uint64_t    _sum   = 0;
+    uint64_t    _min   = 0;
+    uint64_t    _max   = 0;
+};
+
+// The dyld APIs and launch phases we aggregate, named as dyld_usage names them
+struct API
+{
+    uint32_t        eventID;
+    const char*     name;
+};
+
+// The event IDs are the DBG_DYLD_TIMING_* values from Tracing.h
+static constexpr API kAPIs[] = {
+    { eventID(kAPISubclass, 0),         "dlopen"                },
+    { eventID(kAPISubclass, 1),         "dlopen_preflight"      },
+    { eventID(kAPISubclass, 3),         "dlsym"                 },
+    { eventID(kAPISubclass, 4),         "dladdr"                },
+    { eventID(kAPISubclass, 2),         "dlclose"               },
+    { eventID(kInternalSubclass, 1),    "app_launch"            },
+    { eventID(kInternalSubclass, 2),    "map_image"             },
+    { eventID(kInternalSubclass, 3),    "apply_fixups"          },
+    { eventID(kInternalSubclass, 4),    "attach_codesignature"  },
+    { eventID(kInternalSubclass, 5),    "build_closure"         },
+    { eventID(kInternalSubclass, 14),   "validate_closure"      },
+    { eventID(kInternalSubclass, 0),    "static_init"           },
+    { eventID(kInternalSubclass, 6),    "add_image"             },
+    { eventID(kInternalSubclass, 7),    "remove_image"          },
+    { eventID(kInternalSubclass, 8),    "objc_init"             },
+    { eventID(kInternalSubclass, 9),    "objc_map"              },
+};
+static constexpr uint32_t kAPICount = sizeof(kAPIs) / sizeof(kAPIs[0]);
+
+inline int apiIndex(uint32_t eventID)
+{
+    for ( uint32_t i = 0; i != kAPICount; ++i ) {
+        if ( kAPIs[i].eventID == eventID )
+            return (int)i;
+    }
+    return -1;
+}
+
+//
+// Latencies for each API, from one or more trace files
+//
+struct Aggregate
+{
+    LatencyHistogram    histograms[kAPICount];
+    uint64_t            eventCount          = 0;
+    uint64_t            unmatchedEnds       = 0;    // end events with no start, eg, the trace started mid call
+    uint64_t            unterminatedStarts  = 0;    // start events with no end, eg, the trace stopped mid call
+
+    // Adds the latencies of the paired start/end events.  Events on each thread nest, so an end
+    // event pairs with the most recent start event of the same type on that thread
+    void addEvents(const std::vector<Event>& events)
+    {
+        struct Start { uint32_t eventID; uint64_t timestampNs; };
+        std::map<uint64_t, std::vector<Start>> threadStacks;
+
+        for ( const Event& event : events ) {
+            uint32_t eventID = event.debugID & kEventIDMask;
+            if ( apiIndex(eventID) == -1 )
+                continue;
+            ++eventCount;
+
+            std::vector<Start>& stack = threadStacks[event.threadID];
+            if ( event.debugID & kFuncStart ) {
+                stack.push_back({ eventID, event.timestampNs });
+                continue;
+            }
+            if ( (event.debugID & kFuncEnd) == 0 )
+                continue;
+
+            // Anything above the matching start lost its end event
+            size_t i = stack.size();
+            while ( (i != 0) && (stack[i - 1].eventID != eventID) )
+                --i;
+            if ( i == 0 ) {
+                ++unmatchedEnds;
+                continue;
+            }
+            const Start& start = stack[i - 1];
+            if ( event.timestampNs >= start.timestampNs )
+                histograms[apiIndex(eventID)].add(event.timestampNs - start.timestampNs);
+            unterminatedStarts += stack.size() - i;
+            stack.resize(i - 1);
+        }
+
+        for ( const auto& threadAndStack : threadStacks )
+            unterminatedStarts += threadAndStack.second.size();
+    }
+
+    void merge(const Aggregate& other)
+    {
+        for ( uint32_t i = 0; i != kAPICount; ++i )
+            histograms[i].merge(other.histograms[i]);
+        eventCount         += other.eventCount;
+        unmatchedEnds      += other.unmatchedEnds;
+        unterminatedStarts += other.unterminatedStarts;
+    }
+};
+
+struct FileError
+{
+    std::string     path;
+    std::string     message;
+};
+
+// Reads and aggregates the trace files in parallel, with a thread per core each claiming the next file.
+// The per-file results are merged in file order, so the result doesn't depend on scheduling
+inline Aggregate aggregateTraceFiles(const std::vector<std::string>& paths, std::vector<FileError>& errors)
+{
+    std::vector<Aggregate>   fileAggregates(paths.size());
+    std::vector<std::string> fileErrors(paths.size());
+
+    std::atomic<size_t> nextIndex(0);
+    auto worker = [&] {
+        for ( size_t index = nextIndex++; index < paths.size(); index = nextIndex++ ) {
+            std::vector<Event> events;
+            if ( readTraceFile(paths[index].c_str(), events, fileErrors[index]) )
+                fileAggregates[index].addEvents(events);
+        }
+    };
+    // hardware_concurrency() may return 0 if it can't tell.  This thread is a worker too
+    size_t threadCount = std::min<size_t>(std::max(std::thread::hardware_concurrency(), 1U), paths.size());
+    std::vector<std::thread> threads;
+    for ( size_t i = 1; i < threadCount; ++i )
+        threads.emplace_back(worker);
+    worker();
+    for ( std::thread& thread : threads )
+        thread.join();
+
+    Aggregate result;
+    for ( size_t i = 0; i != paths.size(); ++i ) {
+        if ( !fileErrors[i].empty() )
+            errors.push_back({ paths[i], fileErrors[i] });
+        result.merge(fileAggregates[i]);
+    }
+    return result;
+}
+
+inline std::string jsonEscape(const std::string& str)
+{
+    std::string result;
+    for ( char c : str ) {
+        if ( (c == '"') || (c == '\\') ) {
+            result += '\\';
+            result += c;
+        }
+        else if ( (unsigned char)c < 0x20 ) {
+            char buffer[8];
+            snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+            result += buffer;
+        }
+        else {
+            result += c;
+        }
+    }
+    return result;
+}
+
+// Prints the aggregate as JSON.  APIs which were never seen are omitted
+inline void printAggregateJSON(const Aggregate& aggregate, size_t fileCount, const std::vector<FileError>& errors, std::ostringstream& sstr)
+{
+    sstr << "{\"files\":" << fileCount << ",\"events\":" << aggregate.eventCount;
+    sstr << ",\"unmatched_ends\":" << aggregate.unmatchedEnds << ",\"unterminated_starts\":" << aggregate.unterminatedStarts;
+    sstr << ",\"apis\":{";
+    bool first = true;
+    for ( uint32_t i = 0; i != kAPICount; ++i ) {
+        const LatencyHistogram& histogram = aggregate.histograms[i];
+        if ( histogram.count() == 0 )
+            continue;
+        if ( !first )
+            sstr << ",";
+        first = false;
+        sstr << "\"" << kAPIs[i].name << "\":{\"count\":" << histogram.count();
+        sstr << ",\"min_nano\":" << histogram.min() << ",\"p50_nano\":" << histogram.percentile(50);
+        sstr << ",\"p99_nano\":" << histogram.percentile(99) << ",\"max_nano\":" << histogram.max();
+        sstr << ",\"mean_nano\":" << histogram.mean() << "}";
+    }
+    sstr << "}";
+    if ( !errors.empty() ) {
+        sstr << ",\"errors\":[";
+        for ( size_t i = 0; i != errors.size(); ++i ) {
+            if ( i != 0 )
+                sstr << ",";
+            sstr << "{\"file\":\"" << jsonEscape(errors[i].path) << "\",\"error\":\"" << jsonEscape(errors[i].message) << "\"}";
+        }
+        sstr << "]";
+    }
+    sstr << "}" << std::endl;
+}
+
+// Prints the aggregate as a table, with times in microseconds
+inline void printAggregateTable(const Aggregate& aggregate, size_t fileCount, const std::vector<FileError>& errors, std::ostringstream& sstr)
+{
+    for ( const FileError& error : errors )
+        sstr << "warning: " << error.path << ": " << error.message << std::endl;
+
+    char line[256];
+    snprintf(line, sizeof(line), "%-22s %10s %12s %12s %12s %12s\n", "API", "COUNT", "MIN(us)", "P50(us)", "P99(us)", "MAX(us)");
+    sstr << line;
+    for ( uint32_t i = 0; i != kAPICount; ++i ) {
+        const LatencyHistogram& histogram = aggregate.histograms[i];
+        if ( histogram.count() == 0 )
+            continue;
+        snprintf(line, sizeof(line), "%-22s %10llu %12.3f %12.3f %12.3f %12.3f\n", kAPIs[i].name, (unsigned long long)histogram.count(),
+                 histogram.min() / 1000.0, histogram.percentile(50) / 1000.0, histogram.percentile(99) / 1000.0, histogram.max() / 1000.0);
+        sstr << line;
+    }
+    sstr << fileCount << " files, " << aggregate.eventCount << " events, " << aggregate.unmatchedEnds << " unmatched ends, ";
+    sstr << aggregate.unterminatedStarts << " unterminated starts" << std::endl;
+}
+
+} // namespace dyld_trace
+
+#endif /* other_tools_DyldTraceFile_h */
@@ -35,6 +35,8 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <vector>
+
 #include <AvailabilityMacros.h>
 #include <mach-o/dyld_introspection.h>
 #include <mach-o/dyld_priv.h>
@@ -86,13 +88,47 @@ void forSelectedSliceInPaths(std::span<const char*> paths, std::span<const char*
                              void (^handler)(const char* path, const Header* slice, size_t len))
 {
     const auto handleArchive = [handler](const char* path, const Archive& ar) {
-        Error err1 = ar.forEachMachO(^(const Archive::Member& m, const mach_o::Header * header, bool &stop) {
-            char objPath[PATH_MAX];
-            snprintf(objPath, sizeof(objPath), "%s(%s)", path, m.name.data());
-            handler(objPath, header, m.contents.size());
+        // Static archives can have tens of thousands of members, so index them in one pass, then check each
+        // member's load commands concurrently.  The handler is still called serially, in member order
+        std::vector<Archive::Member> members;
+        if ( Error err = ar.makeMemberIndex(members) ) {
+            fprintf(stderr, "malformed archive '%s': %s\n", path, err.message());
+            return;
+        }
+
+        struct MemberResult
+        {
+            bool            visited = false;    // the first SYMDEF is not visited
+            const Header*   header  = nullptr;  // null for bitcode
+            Error           error;
+        };
+        std::vector<MemberResult> results(members.size());
+        MemberResult*             resultsArray = results.data();
+        const Archive::Member*    membersStart = members.data();
+        ar.forEachMachOConcurrently(members, ^(const Archive::Member& m, const Header* header, const Error& memberError) {
+            // the member passed in is a copy with a NUL terminated name, so find its slot from the index entry
+            MemberResult& result = resultsArray[m.memberIndex - membersStart[0].memberIndex];
+            result.visited = true;
+            if ( memberError.hasError() )
+                result.error = Error("%s", memberError.message());
+            else if ( header != nullptr )
+                result.error = header->validStructureLoadCommands(m.contents.size());
+            result.header = header;
         });
-        if ( err1.hasError() )
-            fprintf(stderr, "malformed archive '%s': %s\n", path, err1.message());
+
+        // bad members are reported, but don't stop the rest of the archive being processed
+        for ( size_t i = 0; i != members.size(); ++i ) {
+            const MemberResult& result = results[i];
+            if ( !result.visited )
+                continue;
+            char objPath[PATH_MAX];
+            snprintf(objPath, sizeof(objPath), "%s(%.*s)", path, (int)members[i].name.size(), members[i].name.data());
+            if ( result.error.hasError() ) {
+                fprintf(stderr, "malformed archive member '%s': %s\n", objPath, result.error.message());
+                continue;
+            }
+            handler(objPath, result.header, members[i].contents.size());
+        }
     };
 
     for (const char* path : paths) {
@@ -0,0 +1,233 @@
+/*
+ * Copyright (c) 2025 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+//
+// Replays a log written with DYLD_ALLOCATOR_TRACE_FILE against lsl::Allocator, once with the default
+// allocation policy and once with best fit, and prints the statistics of each run side by side.
+//
+// This is built the same way as the allocator unit tests (BUILDING_ALLOCATOR_UNIT_TESTS), so that it uses
+// the internal allocator.  Other pool sizes can be compared by building with -DALLOCATOR_DEFAULT_POOL_SIZE=...
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+
+#include <unordered_map>
+
+#include "Allocator.h"
+#include "AllocatorTrace.h"
+
+using lsl::Allocator;
+using lsl::AllocatorTrace;
+using lsl::MemoryManager;
+
+struct ReplayResult
+{
+    uint64_t                records     = 0;
+    uint64_t                movedReallocs = 0;     // reallocs which worked when traced, but have to move in the replay
+    uint64_t                unknownFrees  = 0;     // frees and reallocs of addresses the trace never allocated
+    uint64_t                unknownReallocs = 0;
+    uint64_t                timeNs      = 0;
+    uint64_t                endBytes    = 0;
+    Allocator::Statistics   stats;
+    Allocator::PoolUsage    usage;
+};
+
+static void usage()
+{
+    fprintf(stderr, "Usage: allocator_replay [-v] <trace-file> ...\n"
+                    "\t-v    also print the allocations by size class\n");
+}
+
+static bool replay(const uint8_t* trace, uint64_t traceSize, bool bestFit, ReplayResult& result)
+{
+    // Set up a fresh allocator, with the same initial pool size as dyld's persistent allocator
+    const uint64_t  storageSize = ALLOCATOR_DEFAULT_POOL_SIZE;
+    void*           storage     = ::malloc(storageSize);
+    Allocator&      allocator   = __stackAllocatorInternal(storage, storageSize);
+    allocator.setBestFit(bestFit);
+    allocator.setStatistics(&result.stats);
+
+    // Addresses in the trace are only used to match up frees and reallocs with their allocations
+    __block std::unordered_map<uint64_t, void*> liveAllocations;
+    __block uint64_t recordCount = 0;
+    __block uint64_t movedReallocs = 0;
+    __block uint64_t unknownFrees = 0;
+    __block uint64_t unknownReallocs = 0;
+    uint64_t startTime = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    bool valid = AllocatorTrace::forEachRecord(trace, traceSize, ^(const AllocatorTrace::Record& record, bool& stop) {
+        ++recordCount;
+        switch ( record.op ) {
+            case AllocatorTrace::Op::alloc:
+                liveAllocations[record.address] = allocator.aligned_alloc(record.alignment, record.size);
+                break;
+            case AllocatorTrace::Op::free: {
+                auto it = liveAllocations.find(record.address);
+                if ( it == liveAllocations.end() ) {
+                    // Skip it, as there is nothing to free.  These are counted and reported after the replay
+                    ++unknownFrees;
+                    return;
+                }
+                allocator.free(it->second);
+                liveAllocations.erase(it);
+                break;
+            }
+            case AllocatorTrace::Op::reallocSucceeded: {
+                auto it = liveAllocations.find(record.address);
+                if ( it == liveAllocations.end() ) {
+                    ++unknownReallocs;
+                    return;
+                }
+                if ( !allocator.realloc(it->second, record.size) ) {
+                    // Do what callers do when realloc() fails, so the rest of the trace still lines up
+                    void* newAllocation = allocator.malloc(record.size);
+                    allocator.free(it->second);
+                    it->second = newAllocation;
+                    ++movedReallocs;
+                }
+                break;
+            }
+            case AllocatorTrace::Op::reallocFailed:
+                // The caller allocated a new buffer instead, which is in the following records
+                break;
+        }
+    });
+    result.timeNs           = clock_gettime_nsec_np(CLOCK_UPTIME_RAW) - startTime;
+    result.records          = recordCount;
+    result.movedReallocs    = movedReallocs;
+    result.unknownFrees     = unknownFrees;
+    result.unknownReallocs  = unknownReallocs;
+    result.endBytes         = allocator.allocated_bytes();
+    result.usage            = allocator.poolUsage();
+
+    allocator.~Allocator();
+    ::free(storage);
+    return valid;
+}
+
+static void printResults(const ReplayResult results[2], bool verbose)
+{
+    printf("%-24s %16s %16s\n", "", "default", "best fit");
+    printf("%-24s %16llu %16llu\n", "records",          results[0].records,                 results[1].records);
+    printf("%-24s %16llu %16llu\n", "replay time (us)",   results[0].timeNs / 1000,           results[1].timeNs / 1000);
+    printf("%-24s %16llu %16llu\n", "allocated bytes",   results[0].endBytes,                results[1].endBytes);
+    printf("%-24s %16llu %16llu\n", "peak allocated bytes", results[0].stats.peakAllocatedBytes, results[1].stats.peakAllocatedBytes);
+    printf("%-24s %16llu %16llu\n", "pools",             results[0].usage.poolCount,         results[1].usage.poolCount);
+    printf("%-24s %16llu %16llu\n", "pool bytes",        results[0].usage.poolBytes,         results[1].usage.poolBytes);
+    printf("%-24s %16llu %16llu\n", "free bytes",        results[0].usage.freeBytes,         results[1].usage.freeBytes);
+    printf("%-24s %16llu %16llu\n", "hole bytes",        results[0].usage.holeBytes,         results[1].usage.holeBytes);
+    printf("%-24s %16llu %16llu\n", "holes",             results[0].usage.holeCount,         results[1].usage.holeCount);
+    printf("%-24s %16llu %16llu\n", "largest hole",      results[0].usage.largestHole,       results[1].usage.largestHole);
+    printf("%-24s %15llu%% %15llu%%\n", "fragmentation", results[0].usage.fragmentationPercent(), results[1].usage.fragmentationPercent());
+    printf("%-24s %16llu %16llu\n", "failed reallocs",   results[0].stats.failedReallocs,    results[1].stats.failedReallocs);
+    printf("%-24s %16llu %16llu\n", "moved reallocs",    results[0].movedReallocs,           results[1].movedReallocs);
+    printf("%-24s %16llu %16llu\n", "unknown frees",     results[0].unknownFrees,            results[1].unknownFrees);
+    printf("%-24s %16llu %16llu\n", "unknown reallocs",  results[0].unknownReallocs,         results[1].unknownReallocs);
+    if ( !verbose )
+        return;
+
+    // Size classes only depend on the trace, so the counts are the same for both runs
+    printf("\n%-24s %16s %16s\n", "size class", "allocs", "peak live");
+    for ( uint32_t i = 0; i != Allocator::Statistics::kSizeClassCount; ++i ) {
+        const Allocator::Statistics::SizeClass& sizeClass = results[0].stats.sizeClasses[i];
+        if ( sizeClass.allocations == 0 )
+            continue;
+        char name[32];
+        if ( i == Allocator::Statistics::kSizeClassCount - 1 )
+            snprintf(name, sizeof(name), "> %llu", Allocator::Statistics::sizeClassLimit(i - 1));
+        else
+            snprintf(name, sizeof(name), "<= %llu", Allocator::Statistics::sizeClassLimit(i));
+        printf("%-24s %16llu %16llu\n", name, sizeClass.allocations, sizeClass.peakLiveCount);
+    }
+}
+
+int main(int argc, const char* argv[], const char* envp[], const char* apple[])
+{
+    if ( argc == 1 ) {
+        usage();
+        return 1;
+    }
+
+    MemoryManager::init(envp, apple);
+
+    bool verbose = false;
+    int  result  = 0;
+    for ( int i = 1; i < argc; ++i ) {
+        const char* arg = argv[i];
+        if ( strcmp(arg, "-v") == 0 ) {
+            verbose = true;
+            continue;
+        }
+        else if ( arg[0] == '-' ) {
+            fprintf(stderr, "allocator_replay: unknown option: %s\n", arg);
+            usage();
+            return 1;
+        }
+
+        int fd = ::open(arg, O_RDONLY, 0);
+        if ( fd == -1 ) {
+            fprintf(stderr, "allocator_replay: could not open %s\n", arg);
+            result = 1;
+            continue;
+        }
+        struct stat statBuf;
+        if ( (::fstat(fd, &statBuf) != 0) || (statBuf.st_size == 0) ) {
+            fprintf(stderr, "allocator_replay: could not stat %s\n", arg);
+            ::close(fd);
+            result = 1;
+            continue;
+        }
+        const uint8_t* trace = (const uint8_t*)::mmap(nullptr, (size_t)statBuf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if ( trace == MAP_FAILED ) {
+            fprintf(stderr, "allocator_replay: could not map %s\n", arg);
+            result = 1;
+            continue;
+        }
+
+        ReplayResult results[2];
+        bool valid = replay(trace, statBuf.st_size, false, results[0]) && replay(trace, statBuf.st_size, true, results[1]);
+        ::munmap((void*)trace, (size_t)statBuf.st_size);
+        if ( !valid ) {
+            fprintf(stderr, "allocator_replay: %s is not a valid allocator trace\n", arg);
+            result = 1;
+            continue;
+        }
+        printf("%s:\n", arg);
+        printResults(results, verbose);
+        if ( (results[0].unknownFrees != 0) || (results[0].unknownReallocs != 0) ) {
+            // The trace is missing allocations, eg, it was recorded by an older dyld which did not log the blocks
+            // allocated before tracing started, so the numbers above are not the whole story
+            fprintf(stderr, "allocator_replay: %s has %llu frees and %llu reallocs of unknown allocations\n",
+                    arg, results[0].unknownFrees, results[0].unknownReallocs);
+            result = 1;
+        }
+    }
+    return result;
+}
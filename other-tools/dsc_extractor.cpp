@@ -657,17 +657,52 @@ public:
 
         __block macho_nlist<P>* localNlists = nullptr;
         __block uint32_t        localNlistCount = 0;
+        const char*             localStrings = nullptr;
+        uint32_t                localStringsSize = 0;
+        // Compact locals are decoded in to these, so that they can be merged just like the nlist format
+        __block std::vector<macho_nlist<P>> compactLocalNlists;
+        __block std::vector<char>           compactLocalStrings;
         if ( localSymbolsCache.has_value() ) {
             const DyldSharedCache* localsCache = *localSymbolsCache;
 
-            macho_nlist<P>*         allLocalNlists = (macho_nlist<P>*)localsCache->getLocalNlistEntries();
-            localsCache->forEachLocalSymbolEntry(^(uint64_t dylibCacheVMOffset, uint32_t nlistStartIndex, uint32_t nlistCount, bool& stop){
-                if (dylibCacheVMOffset == textOffsetInCache) {
-                    localNlists     = &allLocalNlists[nlistStartIndex];
-                    localNlistCount = nlistCount;
-                    stop            = true;
+            if ( localsCache->getCompactLocalSymbolsInfo() != nullptr ) {
+                // Only this dylib's block is decoded
+                compactLocalStrings.push_back('\0');
+                bool validLocals = localsCache->forEachCompactLocalSymbol(textOffsetInCache, ^(const char* name, uint64_t n_value, uint8_t n_type,
+                                                                                              uint8_t n_sect, uint16_t n_desc, bool& stop) {
+                    macho_nlist<P> t;
+                    memset(&t, 0, sizeof(t));
+                    t.set_n_strx((uint32_t)compactLocalStrings.size());
+                    t.set_n_type(n_type);
+                    t.set_n_sect(n_sect);
+                    t.set_n_desc(n_desc);
+                    t.set_n_value(n_value);
+                    compactLocalStrings.insert(compactLocalStrings.end(), name, name + (strlen(name) + 1));
+                    compactLocalNlists.push_back(t);
+                });
+                if ( !validLocals ) {
+                    // Don't write out the symbols decoded before the bad one, as they'd look like the complete set
+                    fprintf(stderr, "Error: local symbols for dylib at cache offset 0x%llx are missing or malformed, so they are not extracted\n",
+                            textOffsetInCache);
+                    compactLocalNlists.clear();
+                    compactLocalStrings.resize(1);
                 }
-            });
+                localNlists      = compactLocalNlists.data();
+                localNlistCount  = (uint32_t)compactLocalNlists.size();
+                localStrings     = compactLocalStrings.data();
+                localStringsSize = (uint32_t)compactLocalStrings.size();
+            } else {
+                macho_nlist<P>*         allLocalNlists = (macho_nlist<P>*)localsCache->getLocalNlistEntries();
+                localsCache->forEachLocalSymbolEntry(^(uint64_t dylibCacheVMOffset, uint32_t nlistStartIndex, uint32_t nlistCount, bool& stop){
+                    if (dylibCacheVMOffset == textOffsetInCache) {
+                        localNlists     = &allLocalNlists[nlistStartIndex];
+                        localNlistCount = nlistCount;
+                        stop            = true;
+                    }
+                });
+                localStrings     = localsCache->getLocalStrings();
+                localStringsSize = localsCache->getLocalStringsSize();
+            }
         }
 
         // compute number of symbols in new symbol table
@@ -697,8 +732,6 @@ public:
         // local symbols are first in dylibs, if this cache has unmapped locals, insert them all first
         uint32_t undefSymbolShift = 0;
         if ( localNlistCount != 0 ) {
-            const DyldSharedCache* localsCache = *localSymbolsCache;
-            const char* localStrings = localsCache->getLocalStrings();
             undefSymbolShift = localNlistCount - dynamicSymTab->nlocalsym;
             // update load command to reflect new count of locals
             dynamicSymTab->ilocalsym = (uint32_t)newSymTab.size();
@@ -706,7 +739,7 @@ public:
             // copy local symbols
             for (uint32_t i=0; i < localNlistCount; ++i) {
                 const char* localName = &localStrings[localNlists[i].n_strx()];
-                if ( localName > localStrings + localsCache->getLocalStringsSize() )
+                if ( localName > localStrings + localStringsSize )
                     localName = "<corrupt local symbol name>";
                 macho_nlist<P> t = localNlists[i];
                 t.set_n_strx((uint32_t)newSymNames.size());
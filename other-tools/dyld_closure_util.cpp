@@ -73,6 +73,7 @@ static void usage()
     printf("    -no_at_paths                           # when building a closure, simulate security not allowing @path expansion\n");
     printf("    -no_fallback_paths                     # when building a closure, simulate security not allowing default fallback paths\n");
     printf("    -allow_insertion_failures              # when building a closure, simulate security allowing unloadable DYLD_INSERT_LIBRARIES to be ignored\n");
+    printf("    -parallel_objc                         # when building a closure, visit the objc images on multiple threads\n");
 }
 
 int main(int argc, const char* argv[])
@@ -86,6 +87,7 @@ int main(int argc, const char* argv[])
     const char*               printClosureFile = nullptr;
     bool                      listCacheClosures = false;
     bool                      printCachedDylibs = false;
+    bool                      parallelObjC = false;
     std::vector<const char*>  envArgs;
     char                      fsRootRealPath[PATH_MAX];
     char                      fsOverlayRealPath[PATH_MAX];
@@ -170,6 +172,9 @@ int main(int argc, const char* argv[])
             }
             envArgs.push_back(envArg);
         }
+        else if ( strcmp(arg, "-parallel_objc") == 0 ) {
+            parallelObjC = true;
+        }
         else {
             fprintf(stderr, "unknown option %s\n", arg);
             return 1;
@@ -270,7 +275,7 @@ int main(int argc, const char* argv[])
                 fprintf(stderr, "dyld_closure_util: can't build PrebuiltLoader for '%s': %s\n", inputMainExecutablePath, launchDiag.errorMessageCStr());
                 exit(1);
             }
-            const PrebuiltLoaderSet* prebuiltAppSet = PrebuiltLoaderSet::makeLaunchSet(launchDiag, state, missingPaths);
+            const PrebuiltLoaderSet* prebuiltAppSet = PrebuiltLoaderSet::makeLaunchSet(launchDiag, state, missingPaths, parallelObjC);
             if ( launchDiag.hasError() ) {
                 fprintf(stderr, "dyld_closure_util: can't build PrebuiltLoaderSet for '%s': %s\n", inputMainExecutablePath, launchDiag.errorMessageCStr());
                 exit(1);
@@ -26,7 +26,11 @@
 #include <stdio.h>
 #include <mach-o/nlist.h>
 #include <mach-o/stab.h>
+#include <dispatch/dispatch.h>
 
+#include <array>
+#include <atomic>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -81,29 +85,145 @@ static void usage()
         );
 }
 
-struct Entry { const char* symbolName; uint64_t value; uint8_t type; uint8_t sect; uint16_t desc; };
+struct Entry { const char* symbolName; uint64_t value; uint8_t type; uint8_t sect; uint16_t desc; uint64_t sortKey; };
+
+// Symbol tables smaller than this are sorted on one thread, as the cost of going parallel is more than the sort
+static const size_t kParallelSortChunkSize = 0x4000;
+
+// Stable LSD radix sort on Entry::sortKey, one byte at a time.  Bytes which are the same in every key are
+// skipped, so small addresses or short common prefixes don't cost a pass.  Each pass is parallel over chunks
+// of the table: every chunk counts its own digits, and the counts are prefix summed in chunk order, so each
+// chunk knows where to scatter its entries and the sort stays stable.
+static void radixSort(std::vector<Entry>& symbols)
+{
+    const size_t count = symbols.size();
+    if ( count < 2 )
+        return;
+
+    uint64_t allOr  = 0;
+    uint64_t allAnd = ~0ULL;
+    for ( const Entry& sym : symbols ) {
+        allOr  |= sym.sortKey;
+        allAnd &= sym.sortKey;
+    }
+    const uint64_t differingBits = allOr ^ allAnd;
+
+    const size_t chunkCount = (count + kParallelSortChunkSize - 1) / kParallelSortChunkSize;
+    std::vector<std::array<size_t, 256>> chunkOffsets(chunkCount);
+    std::vector<Entry>                   temp(count);
+    Entry*                               src     = symbols.data();
+    Entry*                               dst     = temp.data();
+    std::array<size_t, 256>*             offsets = chunkOffsets.data();
+    for ( uint32_t shift = 0; shift < 64; shift += 8 ) {
+        if ( ((differingBits >> shift) & 0xFF) == 0 )
+            continue;
+
+        dispatch_apply(chunkCount, DISPATCH_APPLY_AUTO, ^(size_t chunkIndex) {
+            std::array<size_t, 256>& counts = offsets[chunkIndex];
+            counts.fill(0);
+            size_t end = std::min(count, (chunkIndex + 1) * kParallelSortChunkSize);
+            for ( size_t i = chunkIndex * kParallelSortChunkSize; i != end; ++i )
+                ++counts[(src[i].sortKey >> shift) & 0xFF];
+        });
+
+        size_t total = 0;
+        for ( uint32_t digit = 0; digit != 256; ++digit ) {
+            for ( size_t chunkIndex = 0; chunkIndex != chunkCount; ++chunkIndex ) {
+                size_t digitCount = offsets[chunkIndex][digit];
+                offsets[chunkIndex][digit] = total;
+                total += digitCount;
+            }
+        }
+
+        dispatch_apply(chunkCount, DISPATCH_APPLY_AUTO, ^(size_t chunkIndex) {
+            std::array<size_t, 256>& nextIndex = offsets[chunkIndex];
+            size_t end = std::min(count, (chunkIndex + 1) * kParallelSortChunkSize);
+            for ( size_t i = chunkIndex * kParallelSortChunkSize; i != end; ++i )
+                dst[nextIndex[(src[i].sortKey >> shift) & 0xFF]++] = src[i];
+        });
+        std::swap(src, dst);
+    }
+
+    // an odd number of passes leaves the result in the temp buffer
+    if ( src != symbols.data() )
+        symbols.swap(temp);
+}
+
+// The first 8 chars of the name, big endian, so that comparing keys orders names the same as strcmp()
+static uint64_t namePrefixKey(const char* name)
+{
+    uint64_t key = 0;
+    for ( uint32_t i = 0; i != 8; ++i ) {
+        uint8_t c = (uint8_t)name[i];
+        key = (key << 8) | c;
+        if ( c == '\0' ) {
+            key <<= (8 * (7 - i));
+            break;
+        }
+    }
+    return key;
+}
+
+// After the radix sort, entries with the same key are in symbol table order, so sort them by name
+static void sortRunsByName(std::vector<Entry>& symbols)
+{
+    for ( auto runStart = symbols.begin(); runStart != symbols.end(); ) {
+        auto runEnd = runStart + 1;
+        while ( (runEnd != symbols.end()) && (runEnd->sortKey == runStart->sortKey) )
+            ++runEnd;
+        if ( (runEnd - runStart) > 1 ) {
+            std::stable_sort(runStart, runEnd, [](const Entry& l, const Entry& r) {
+                return (strcmp(l.symbolName, r.symbolName) < 0);
+            });
+        }
+        runStart = runEnd;
+    }
+}
 
 static void sortSymbols(std::vector<Entry>& symbols, SortOrder order)
 {
     switch ( order ) {
         case sortByName:
-            std::sort(symbols.begin(), symbols.end(), [](const Entry& l, const Entry& r) {
-                return (strcmp(l.symbolName, r.symbolName) < 0);
-            });
+            for ( Entry& sym : symbols )
+                sym.sortKey = namePrefixKey(sym.symbolName);
+            radixSort(symbols);
+            sortRunsByName(symbols);
             break;
         case sortByAddress:
-            std::sort(symbols.begin(), symbols.end(), [](const Entry& l, const Entry& r) {
-                if ( l.value != r.value ) {
-                    return (l.value < r.value);
-                }
-                return (strcmp(l.symbolName, r.symbolName) < 0);
-            });
+            for ( Entry& sym : symbols )
+                sym.sortKey = sym.value;
+            radixSort(symbols);
+            sortRunsByName(symbols);
             break;
         case sortSymbolOrder:
             break;
     }
 }
 
+__attribute__((format(printf, 2, 3)))
+static void appendFormat(std::string& out, const char* format, ...)
+{
+    char    buffer[1024];
+    va_list list;
+    va_start(list, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, list);
+    va_end(list);
+    if ( len < 0 )
+        return;
+    if ( (size_t)len < sizeof(buffer) ) {
+        out.append(buffer, len);
+        return;
+    }
+
+    // very long symbol name, so format again straight in to the output
+    size_t oldSize = out.size();
+    out.resize(oldSize + len + 1);
+    va_start(list, format);
+    vsnprintf(&out[oldSize], len + 1, format, list);
+    va_end(list);
+    out.resize(oldSize + len);
+}
+
 
 static bool isUndefinedSymbol(uint8_t n_type)
 {
@@ -131,7 +251,7 @@ SectionInfo::SectionInfo(std::string_view segName, std::string_view sectionName,
         this->code = 'S';
 }
 
-static void printSymbolRegular(const Entry& sym, const std::vector<SectionInfo>& sectionInfos)
+static void printSymbolRegular(std::string& out, const Entry& sym, const std::vector<SectionInfo>& sectionInfos)
 {
     char c = '?';
     switch (sym.type & N_TYPE) {
@@ -148,7 +268,7 @@ static void printSymbolRegular(const Entry& sym, const std::vector<SectionInfo>&
     if ( (sym.type & N_EXT) == 0 )
         c = tolower(c);
 
-    printf("%016llX %c %s\n", sym.value, c, sym.symbolName);
+    appendFormat(out, "%016llX %c %s\n", sym.value, c, sym.symbolName);
 }
 
 static const char* verboseSymbolSection(const Entry& sym, const std::vector<SectionInfo>& sectionInfos)
@@ -255,29 +375,132 @@ static const char* stabName(const Entry& sym)
 }
 
 
-static void printSymbolVerbose(const Entry& sym, const std::vector<SectionInfo>& sectionInfos, const std::vector<std::string>& imports, bool isObjectFile)
+static void printSymbolVerbose(std::string& out, const Entry& sym, const std::vector<SectionInfo>& sectionInfos, const std::vector<std::string>& imports, bool isObjectFile)
 {
     if ( sym.type & N_STAB ) {
-        printf("%016llx - %02x %04X %5s %s\n", sym.value, sym.sect, sym.desc, stabName(sym), sym.symbolName);
+        appendFormat(out, "%016llx - %02x %04X %5s %s\n", sym.value, sym.sect, sym.desc, stabName(sym), sym.symbolName);
     }
     else {
         const char* sectionStr = verboseSymbolSection(sym, sectionInfos);
         std::string flags      = verboseSymbolFlags(sym, sectionInfos, isObjectFile);
         if ( !isObjectFile && isUndefinedSymbol(sym.type) )
-            printf("                 (%s) %s%s (from %s)\n", sectionStr, flags.c_str(), sym.symbolName, verboseTwoLevelImport(sym, imports).c_str());
+            appendFormat(out, "                 (%s) %s%s (from %s)\n", sectionStr, flags.c_str(), sym.symbolName, verboseTwoLevelImport(sym, imports).c_str());
         else
-            printf("%016llx (%s) %s%s\n", sym.value, sectionStr, flags.c_str(), sym.symbolName);
+            appendFormat(out, "%016llx (%s) %s%s\n", sym.value, sectionStr, flags.c_str(), sym.symbolName);
     }
 }
 
-static void printSymbolNameOnly(const Entry& sym)
+static void printSymbolNameOnly(std::string& out, const Entry& sym)
 {
-     printf("%s\n", sym.symbolName);
+    out += sym.symbolName;
+    out += '\n';
 }
 
-static void printSymbolHex(const Entry& sym, const char* stringPool)
+static void printSymbolHex(std::string& out, const Entry& sym, const char* stringPool)
 {
-    printf("%016llx %02X %02x %04X %08X %s\n", sym.value, sym.type, sym.sect, sym.desc, (uint32_t)(sym.symbolName - stringPool), sym.symbolName);
+    appendFormat(out, "%016llx %02X %02x %04X %08X %s\n", sym.value, sym.type, sym.sect, sym.desc, (uint32_t)(sym.symbolName - stringPool), sym.symbolName);
+}
+
+static void printSlice(std::string& out, const char* path, const Header* header, size_t sliceLen, const PrintOptions& printOptions)
+{
+    appendFormat(out, "%s [%s]:\n", path, header->archName());
+    Image image((void*)header, sliceLen, (header->inDyldCache() ? Image::MappingKind::dyldLoadedPostFixups : Image::MappingKind::wholeSliceMapped));
+    if ( image.hasSymbolTable() ) {
+        // gather symbols
+        const NListSymbolTable& symTab = image.symbolTable();
+        __block std::vector<Entry> symbols;
+        symbols.reserve(symTab.totalCount());
+        symTab.forEachSymbol(^(const char* symbolName, uint64_t n_value, uint8_t n_type, uint8_t n_sect, uint16_t n_desc, uint32_t symbolIndex, bool& stop) {
+            if ( ((n_type & N_STAB) == 0) || printOptions.printSTABs )
+                symbols.push_back({symbolName, n_value, n_type, n_sect, n_desc, 0});
+        });
+        sortSymbols(symbols, printOptions.sort);
+
+        // build table of info about each section
+        __block std::vector<SectionInfo> sectionInfos;
+        header->forEachSection(^(const Header::SectionInfo& info, bool &stop) {
+            uint8_t sectionType = (info.flags & SECTION_TYPE);
+            sectionInfos.emplace_back(info.segmentName, info.sectionName, sectionType);
+        });
+
+        // build table of info about each imported dylib
+        __block std::vector<std::string> imports;
+        header->forEachLinkedDylib(^(const char* loadPath, mach_o::LinkedDylibAttributes, mach_o::Version32, mach_o::Version32,
+                                     bool synthesizedLink, bool& stop) {
+            if ( synthesizedLink )
+                return;
+            std::string leafName = loadPath;
+            if ( const char* lastSlash = strrchr(loadPath, '/') )
+                leafName = lastSlash+1;
+            size_t leafNameLen = leafName.size();
+            if ( (leafNameLen > 6) && (leafName.substr(leafNameLen-6) == ".dylib") )
+                imports.push_back(leafName.substr(0,leafNameLen-6));
+            else
+                imports.push_back(leafName);
+        });
+
+        // print each symbol
+        for (const Entry& sym : symbols) {
+            if ( printOptions.skipNonGlobals && ((sym.type & N_EXT) == 0) )
+                continue;
+            switch ( printOptions.show ) {
+                case showAll:
+                     break;
+                case showOnlyUndefines:
+                     if ( !isUndefinedSymbol(sym.type)  )
+                        continue;
+                     break;
+                case showNoUndefines:
+                     if ( isUndefinedSymbol(sym.type) )
+                        continue;
+                    break;
+            }
+
+            switch ( printOptions.format ) {
+                case formatRegular:
+                    printSymbolRegular(out, sym, sectionInfos);
+                    break;
+                case formatVerbose:
+                    printSymbolVerbose(out, sym, sectionInfos, imports, header->isObjectFile());
+                    break;
+                case formatNameOnly:
+                     printSymbolNameOnly(out, sym);
+                    break;
+               case formatHex:
+                    printSymbolHex(out, sym, symTab.stringPool());
+                    break;
+            }
+        }
+    }
+}
+
+//
+// Output for each file is buffered, and printed as soon as the output for all the files before it has been,
+// so that the output is in command line order no matter which file finishes first
+//
+struct OrderedOutput
+{
+                OrderedOutput(size_t count) : _buffers(count), _done(count, false) { }
+    void        finished(size_t index, std::string&& output);
+
+private:
+    std::mutex                  _lock;
+    std::vector<std::string>    _buffers;
+    std::vector<bool>           _done;
+    size_t                      _nextToPrint = 0;
+};
+
+void OrderedOutput::finished(size_t index, std::string&& output)
+{
+    std::lock_guard<std::mutex> guard(_lock);
+    _buffers[index] = std::move(output);
+    _done[index]    = true;
+    while ( (_nextToPrint < _done.size()) && _done[_nextToPrint] ) {
+        std::string& buffer = _buffers[_nextToPrint];
+        fwrite(buffer.data(), 1, buffer.size(), stdout);
+        std::string().swap(buffer);
+        ++_nextToPrint;
+    }
 }
 
 int main(int argc, const char* argv[])
@@ -348,78 +571,22 @@ int main(int argc, const char* argv[])
         return 0;
     }
 
-    __block bool sliceFound = false;
-    other_tools::forSelectedSliceInPaths(files, cmdLineArchs, ^(const char* path, const Header* header, size_t sliceLen) {
-        sliceFound = true;
-        printf("%s [%s]:\n", path, header->archName());
-        Image image((void*)header, sliceLen, (header->inDyldCache() ? Image::MappingKind::dyldLoadedPostFixups : Image::MappingKind::wholeSliceMapped));
-        if ( image.hasSymbolTable() ) {
-            // gather symbols
-            const NListSymbolTable& symTab = image.symbolTable();
-            __block std::vector<Entry> symbols;
-            symTab.forEachSymbol(^(const char* symbolName, uint64_t n_value, uint8_t n_type, uint8_t n_sect, uint16_t n_desc, uint32_t symbolIndex, bool& stop) {
-                if ( ((n_type & N_STAB) == 0) || printOptions.printSTABs )
-                    symbols.push_back({symbolName, n_value, n_type, n_sect, n_desc});
-            });
-            sortSymbols(symbols, printOptions.sort);
-
-            // build table of info about each section
-            __block std::vector<SectionInfo> sectionInfos;
-            header->forEachSection(^(const Header::SectionInfo& info, bool &stop) {
-                uint8_t sectionType = (info.flags & SECTION_TYPE);
-                sectionInfos.emplace_back(info.segmentName, info.sectionName, sectionType);
-            });
-
-            // build table of info about each imported dylib
-            __block std::vector<std::string> imports;
-            header->forEachLinkedDylib(^(const char* loadPath, mach_o::LinkedDylibAttributes, mach_o::Version32, mach_o::Version32,
-                                         bool synthesizedLink, bool& stop) {
-                if ( synthesizedLink )
-                    return;
-                std::string leafName = loadPath;
-                if ( const char* lastSlash = strrchr(loadPath, '/') )
-                    leafName = lastSlash+1;
-                size_t leafNameLen = leafName.size();
-                if ( (leafNameLen > 6) && (leafName.substr(leafNameLen-6) == ".dylib") )
-                    imports.push_back(leafName.substr(0,leafNameLen-6));
-                else
-                    imports.push_back(leafName);
-            });
-
-            // print each symbol
-            for (const Entry& sym : symbols) {
-                if ( printOptions.skipNonGlobals && ((sym.type & N_EXT) == 0) )
-                    continue;
-                switch ( printOptions.show ) {
-                    case showAll:
-                         break;
-                    case showOnlyUndefines:
-                         if ( !isUndefinedSymbol(sym.type)  )
-                            continue;
-                         break;
-                    case showNoUndefines:
-                         if ( isUndefinedSymbol(sym.type) )
-                            continue;
-                        break;
-                }
-
-                switch ( printOptions.format ) {
-                    case formatRegular:
-                        printSymbolRegular(sym, sectionInfos);
-                        break;
-                    case formatVerbose:
-                        printSymbolVerbose(sym, sectionInfos, imports, header->isObjectFile());
-                        break;
-                    case formatNameOnly:
-                         printSymbolNameOnly(sym);
-                        break;
-                   case formatHex:
-                        printSymbolHex(sym, symTab.stringPool());
-                        break;
-                }
-            }
-        }
+    // each file, and the slices and cache dylibs it contains, are processed in parallel
+    std::atomic<bool>           sliceFound = false;
+    std::atomic<bool>&          sliceFoundRef = sliceFound;
+    OrderedOutput               output(files.size());
+    OrderedOutput&              outputRef  = output;
+    const char**                filesArray = files.data();
+    std::vector<const char*>&   archs      = cmdLineArchs;
+    dispatch_apply(files.size(), DISPATCH_APPLY_AUTO, ^(size_t fileIndex) {
+        __block std::string fileOutput;
+        other_tools::forSelectedSliceInPaths(std::span(&filesArray[fileIndex], 1), archs, ^(const char* path, const Header* header, size_t sliceLen) {
+            sliceFoundRef = true;
+            printSlice(fileOutput, path, header, sliceLen, printOptions);
+        });
+        outputRef.finished(fileIndex, std::move(fileOutput));
     });
+    fflush(stdout);
 
     if ( !sliceFound && (files.size() == 1) ) {
         if ( cmdLineArchs.empty() )
@@ -0,0 +1,82 @@
+/* -*- mode: C++; c-basic-offset: 4; tab-width: 4 -*-
+ *
+ * Copyright (c) 2025 Apple Inc. All rights reserved.
+ *
+ * @APPLE_LICENSE_HEADER_START@
+ *
+ * This file contains Original Code and/or Modifications of Original Code
+ * as defined in and that are subject to the Apple Public Source License
+ * Version 2.0 (the 'License'). You may not use this file except in
+ * compliance with the License. Please obtain a copy of the License at
+ * http://www.opensource.apple.com/apsl/ and read it before using this
+ * file.
+ *
+ * The Original Code and all software distributed under the License are
+ * distributed on an 'AS IS' basis, WITHOUT WARRANTY OF ANY KIND, EITHER
+ * EXPRESS OR IMPLIED, AND APPLE HEREBY DISCLAIMS ALL SUCH WARRANTIES,
+ * INCLUDING WITHOUT LIMITATION, ANY WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, QUIET ENJOYMENT OR NON-INFRINGEMENT.
+ * Please see the License for the specific language governing rights and
+ * limitations under the License.
+ *
+ * @APPLE_LICENSE_HEADER_END@
+ */
+
+//
+// Aggregates the latency of each dyld API across dyld trace files, the same as dyld_usage -A.
+//
+// Unlike dyld_usage this only needs the C++ standard library, so traces collected from many devices
+// can be aggregated on any machine.  build-scripts/dyld_trace_aggregate-build.sh builds it.
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "DyldTraceFile.h"
+
+static void usage()
+{
+    fprintf(stderr, "Usage: dyld_trace_aggregate [-j] <trace-file> ...\n"
+                    "\t-j    print JSON instead of a table\n");
+}
+
+int main(int argc, const char* argv[])
+{
+    bool                     json = false;
+    std::vector<std::string> paths;
+    for ( int i = 1; i < argc; ++i ) {
+        const char* arg = argv[i];
+        if ( strcmp(arg, "-j") == 0 ) {
+            json = true;
+        }
+        else if ( arg[0] == '-' ) {
+            fprintf(stderr, "dyld_trace_aggregate: unknown option: %s\n", arg);
+            usage();
+            return 1;
+        }
+        else {
+            paths.push_back(arg);
+        }
+    }
+    if ( paths.empty() ) {
+        usage();
+        return 1;
+    }
+
+    std::vector<dyld_trace::FileError> errors;
+    dyld_trace::Aggregate aggregate = dyld_trace::aggregateTraceFiles(paths, errors);
+
+    std::ostringstream ostream;
+    if ( json )
+        dyld_trace::printAggregateJSON(aggregate, paths.size(), errors, ostream);
+    else
+        dyld_trace::printAggregateTable(aggregate, paths.size(), errors, ostream);
+    std::cout << ostream.str();
+
+    return (errors.size() == paths.size()) ? 1 : 0;
+}
@@ -44,9 +44,33 @@
 #include <sys/kdebug_private.h>
 
 #include "Tracing.h"
+#include "DyldTraceFile.h"
 
 #define DBG_FUNC_ALL    (DBG_FUNC_START | DBG_FUNC_END)
 
+// DyldTraceFile.h has its own copies of the kdebug values, so that it builds without the Darwin headers
+static constexpr bool traceFileEventIDsMatch()
+{
+    const uint32_t eventIDs[] = {
+        DBG_DYLD_TIMING_DLOPEN, DBG_DYLD_TIMING_DLOPEN_PREFLIGHT, DBG_DYLD_TIMING_DLSYM, DBG_DYLD_TIMING_DLADDR,
+        DBG_DYLD_TIMING_DLCLOSE, DBG_DYLD_TIMING_LAUNCH_EXECUTABLE, DBG_DYLD_TIMING_MAP_IMAGE, DBG_DYLD_TIMING_APPLY_FIXUPS,
+        DBG_DYLD_TIMING_ATTACH_CODESIGNATURE, DBG_DYLD_TIMING_BUILD_CLOSURE, DBG_DYLD_TIMING_VALIDATE_CLOSURE,
+        DBG_DYLD_TIMING_STATIC_INITIALIZER, DBG_DYLD_TIMING_FUNC_FOR_ADD_IMAGE, DBG_DYLD_TIMING_FUNC_FOR_REMOVE_IMAGE,
+        DBG_DYLD_TIMING_OBJC_INIT, DBG_DYLD_TIMING_OBJC_MAP,
+    };
+    if ( sizeof(eventIDs) / sizeof(eventIDs[0]) != dyld_trace::kAPICount )
+        return false;
+    for ( uint32_t i = 0; i != dyld_trace::kAPICount; ++i ) {
+        if ( dyld_trace::kAPIs[i].eventID != eventIDs[i] )
+            return false;
+    }
+    return true;
+}
+static_assert(traceFileEventIDsMatch(), "DyldTraceFile.h event IDs are out of sync with Tracing.h");
+static_assert((dyld_trace::kFuncStart == DBG_FUNC_START) && (dyld_trace::kFuncEnd == DBG_FUNC_END), "DyldTraceFile.h kdebug flags are wrong");
+static_assert(dyld_trace::kEventIDMask == KDBG_EVENTID_MASK, "DyldTraceFile.h kdebug event ID mask is wrong");
+static_assert(dyld_trace::kDyldClass == DBG_DYLD, "DyldTraceFile.h dyld kdebug class is wrong");
+
 
 /*
  * MAXCOLS controls when extra data kicks in.
@@ -61,15 +85,20 @@ bool wideflag = false;
 bool RAW_flag = false;
 bool JSON_flag = false;
 bool JSON_Tracing_flag = false;
+bool aggregate_flag = false;
+dyld_trace::TraceWriter traceWriter;
 dispatch_source_t sigwinch_source;
 static void
 exit_usage(void)
 {
-    fprintf(stderr, "Usage: dyld_usage [-e] [-f mode] [-t seconds] [-R rawfile [-S start_time] [-E end_time]] [pid | cmd [pid | cmd] ...]\n");
+    fprintf(stderr, "Usage: dyld_usage [-e] [-f mode] [-t seconds] [-x tracefile] [-R rawfile [-S start_time] [-E end_time]] [pid | cmd [pid | cmd] ...]\n");
+    fprintf(stderr, "       dyld_usage -A [-j] tracefile ...\n");
     fprintf(stderr, "  -e    exclude the specified list of pids from the sample\n");
     fprintf(stderr, "        and exclude dyld_usage by default\n");
     fprintf(stderr, "  -t    specifies timeout in seconds (for use in automated tools)\n");
     fprintf(stderr, "  -R    specifies a raw trace file to process\n");
+    fprintf(stderr, "  -x    also writes the dyld events to a dyld trace file, for use with -A\n");
+    fprintf(stderr, "  -A    aggregates the latency of each dyld API across the given dyld trace files\n");
     fprintf(stderr, "  pid   selects process(s) to sample\n");
     fprintf(stderr, "  cmd   selects process(s) matching command string to sample\n");
     fprintf(stderr, "By default (no options) the following processes are excluded from the output:\n");
@@ -114,6 +143,43 @@ mach_to_nano(uint64_t mach)
     return nanoseconds;
 }
 
+static void
+exportEvent(ktrace_event_t event)
+{
+    if (!traceWriter.isOpen())
+        return;
+    dyld_trace::Event traceEvent;
+    traceEvent.timestampNs = mach_to_nano(event->timestamp);
+    traceEvent.threadID = event->threadid;
+    traceEvent.arg1 = event->arg1;
+    traceEvent.arg2 = event->arg2;
+    traceEvent.arg3 = event->arg3;
+    traceEvent.arg4 = event->arg4;
+    traceEvent.debugID = event->debugid;
+    traceEvent.pid = (uint32_t)ktrace_get_pid_for_thread(s, event->threadid);
+    traceWriter.write(traceEvent);
+}
+
+static int
+aggregate_trace_files(int argc, char *argv[])
+{
+    if (argc == 0)
+        exit_usage();
+
+    std::vector<std::string> paths(argv, argv + argc);
+    std::vector<dyld_trace::FileError> errors;
+    dyld_trace::Aggregate aggregate = dyld_trace::aggregateTraceFiles(paths, errors);
+
+    std::ostringstream ostream;
+    if (JSON_flag)
+        dyld_trace::printAggregateJSON(aggregate, paths.size(), errors, ostream);
+    else
+        dyld_trace::printAggregateTable(aggregate, paths.size(), errors, ostream);
+    std::cout << ostream.str();
+
+    return (errors.size() == paths.size()) ? 1 : 0;
+}
+
 static
 std::string safeStringFromCString(const char *str) {
     if (str) {
@@ -717,6 +783,7 @@ static void
 setup_ktrace_callbacks(void)
 {
     ktrace_events_single(s, TRACEDBG_CODE(DBG_TRACE_STRING, TRACE_STRING_GLOBAL), ^(ktrace_event_t event){
+        exportEvent(event);
         char argChars[33] = {0};
         memset(&argChars[0], 0, 33);
         if ((event->debugid & DBG_FUNC_START) == DBG_FUNC_START) {
@@ -761,6 +828,7 @@ setup_ktrace_callbacks(void)
     ktrace_events_range(s, KDBG_EVENTID(DBG_DYLD, DBG_DYLD_INTERNAL_SUBCLASS, 0), KDBG_EVENTID(DBG_DYLD, DBG_DYLD_API_SUBCLASS+1, 0), ^(ktrace_event_t event){
         if ((event->debugid & KDBG_FUNC_MASK) == 0)
             return;
+        exportEvent(event);
         auto i = sOutputManager.sOutputRenders.find((size_t)(event->threadid));
         if (i == sOutputManager.sOutputRenders.end()) {
             i = sOutputManager.sOutputRenders.emplace(event->threadid, std::make_unique<output_renderer>(s, event)).first;
@@ -793,7 +861,7 @@ main(int argc, char *argv[])
     s = ktrace_session_create();
     assert(s);
 
-    while ((ch = getopt(argc, argv, "hjJeR:t:")) != -1) {
+    while ((ch = getopt(argc, argv, "hjJeAR:t:x:")) != -1) {
         switch (ch) {
             case 'j':
                 JSON_flag = true;
@@ -820,6 +888,17 @@ main(int argc, char *argv[])
                     exit(1);
                 }
                 break;
+            case 'x': {
+                std::string error;
+                if (!traceWriter.open(optarg, error)) {
+                    fprintf(stderr, "ERROR: %s\n", error.c_str());
+                    exit(1);
+                }
+                break;
+            }
+            case 'A':
+                aggregate_flag = true;
+                break;
             case 'h':
             default:
                 exit_usage();
@@ -829,6 +908,10 @@ main(int argc, char *argv[])
     argc -= optind;
     argv += optind;
 
+    // Aggregating trace files doesn't need ktrace, so don't need to be root either
+    if (aggregate_flag)
+        return aggregate_trace_files(argc, argv);
+
     if (time_limit_ns > 0) {
         if (RAW_flag) {
             fprintf(stderr, "NOTE: time limit ignored when a raw file is specified\n");
@@ -911,6 +994,7 @@ main(int argc, char *argv[])
     ktrace_set_signal_handler(s);
     ktrace_set_completion_handler(s, ^{
         sOutputManager.flush();
+        traceWriter.close();
         exit(0);
     });
 
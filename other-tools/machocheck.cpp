@@ -26,8 +26,17 @@
 #include <stdarg.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <uuid/uuid.h>
+#include <mach-o/dyld.h>
+#include <dispatch/dispatch.h>
 
 // STL
+#include <algorithm>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 // mach_o
@@ -47,12 +56,308 @@ using mach_o::Error;
 using mach_o::Universal;
 
 
+//
+// The verification cache lets incremental builds skip binaries which have not changed since the last run.
+// It is a text file.  The first line identifies the machocheck binary and the options used, as a change to
+// either can change the results.  Then for each file verified:
+//
+//      F<tab>path<tab>inode<tab>mtime-sec<tab>mtime-nsec<tab>size<tab>uuids
+//      E<tab>line to print to stdout                           (for each verifier error)
+//      W<tab>line to print to stderr                           (for each warning)
+//
+// Tabs, newlines, and backslashes in fields are escaped with backslashes.
+//
+// The key only covers the file itself.  So files whose results came from resolving symlinks elsewhere in the
+// dstroot (eg, an install name which is a symlink to the dylib) are left out of the cache, and always re-verified.
+//
+static const char* const kCacheMagic = "machocheck-cache-v1";
+
+struct FileIdentity
+{
+    uint64_t        inode       = 0;
+    int64_t         mtimeSec    = 0;
+    int64_t         mtimeNsec   = 0;
+    uint64_t        size        = 0;
+    std::string     uuids;          // UUID of each slice, comma separated
+
+    bool operator==(const FileIdentity& other) const = default;
+};
+
+struct FileResult
+{
+    bool                        found           = false;
+    bool                        usedSymlinks    = false;    // result depends on other files, so can't be cached
+    FileIdentity                identity;
+    std::vector<std::string>    errorLines;     // printed to stdout
+    std::vector<std::string>    warningLines;   // printed to stderr
+};
+
+static std::string escapeField(const std::string& str)
+{
+    std::string result;
+    for ( char c : str ) {
+        switch ( c ) {
+            case '\\':  result += "\\\\"; break;
+            case '\t':  result += "\\t";  break;
+            case '\n':  result += "\\n";  break;
+            default:    result += c;      break;
+        }
+    }
+    return result;
+}
+
+static std::string unescapeField(std::string_view str)
+{
+    std::string result;
+    for ( size_t i = 0; i < str.size(); ++i ) {
+        if ( (str[i] == '\\') && (i + 1 < str.size()) ) {
+            ++i;
+            switch ( str[i] ) {
+                case 't':   result += '\t';    break;
+                case 'n':   result += '\n';    break;
+                default:    result += str[i];  break;
+            }
+        }
+        else {
+            result += str[i];
+        }
+    }
+    return result;
+}
+
+static std::vector<std::string_view> splitFields(std::string_view line)
+{
+    std::vector<std::string_view> fields;
+    size_t start = 0;
+    while ( true ) {
+        size_t tab = line.find('\t', start);
+        if ( tab == std::string_view::npos ) {
+            fields.push_back(line.substr(start));
+            return fields;
+        }
+        fields.push_back(line.substr(start, tab - start));
+        start = tab + 1;
+    }
+}
+
+// The first line of the cache.  Any change to the machocheck binary or to the options invalidates the whole cache
+static std::string cacheHeader(CString verifierDstRoot, const std::vector<CString>& mergeRootPaths)
+{
+    uuid_t toolUUID;
+    uuid_string_t toolUUIDString = { };
+    if ( ((const Header*)_dyld_get_image_header(0))->getUuid(toolUUID) )
+        uuid_unparse_upper(toolUUID, toolUUIDString);
+
+    std::string header = std::string(kCacheMagic) + "\t" + toolUUIDString + "\t" + escapeField(std::string(verifierDstRoot));
+    for ( CString mergeRoot : mergeRootPaths )
+        header += "\t" + escapeField(std::string(mergeRoot));
+    return header;
+}
+
+static std::unordered_map<std::string, FileResult> readCache(const char* cachePath, const std::string& expectedHeader)
+{
+    std::unordered_map<std::string, FileResult> cache;
+    __block std::string contents;
+    if ( !other_tools::withReadOnlyMappedFile(cachePath, ^(std::span<const uint8_t> buffer) {
+        contents.assign((const char*)buffer.data(), buffer.size());
+    }) ) {
+        return cache;
+    }
+
+    std::string_view remaining = contents;
+    FileResult*      current   = nullptr;
+    bool             firstLine = true;
+    while ( !remaining.empty() ) {
+        size_t           newline = remaining.find('\n');
+        std::string_view line    = remaining.substr(0, newline);
+        remaining = (newline == std::string_view::npos) ? std::string_view() : remaining.substr(newline + 1);
+
+        if ( firstLine ) {
+            // a cache from a different machocheck or different options is ignored
+            if ( line != expectedHeader )
+                return cache;
+            firstLine = false;
+            continue;
+        }
+
+        std::vector<std::string_view> fields = splitFields(line);
+        if ( (fields[0] == "F") && (fields.size() == 7) ) {
+            FileResult& result = cache[unescapeField(fields[1])];
+            result.found              = true;
+            result.identity.inode     = strtoull(std::string(fields[2]).c_str(), nullptr, 10);
+            result.identity.mtimeSec  = strtoll(std::string(fields[3]).c_str(), nullptr, 10);
+            result.identity.mtimeNsec = strtoll(std::string(fields[4]).c_str(), nullptr, 10);
+            result.identity.size      = strtoull(std::string(fields[5]).c_str(), nullptr, 10);
+            result.identity.uuids     = std::string(fields[6]);
+            current = &result;
+        }
+        else if ( (fields[0] == "E") && (fields.size() == 2) && (current != nullptr) ) {
+            current->errorLines.push_back(unescapeField(fields[1]));
+        }
+        else if ( (fields[0] == "W") && (fields.size() == 2) && (current != nullptr) ) {
+            current->warningLines.push_back(unescapeField(fields[1]));
+        }
+        else if ( !line.empty() ) {
+            // corrupt cache, so start again
+            cache.clear();
+            return cache;
+        }
+    }
+    return cache;
+}
+
+static void writeCache(const char* cachePath, const std::string& header, const std::vector<std::string>& paths, const std::vector<FileResult>& results)
+{
+    // write to a temp file and rename, so that a failed run doesn't leave a partial cache
+    std::string tempPath = std::string(cachePath) + "-XXXXXX";
+    int fd = ::mkstemp(tempPath.data());
+    if ( fd == -1 ) {
+        fprintf(stderr, "could not write verification cache %s\n", cachePath);
+        return;
+    }
+    FILE* file = ::fdopen(fd, "w");
+    fprintf(file, "%s\n", header.c_str());
+    for ( size_t i = 0; i != paths.size(); ++i ) {
+        const FileResult& result = results[i];
+        if ( !result.found || result.usedSymlinks )
+            continue;
+        fprintf(file, "F\t%s\t%llu\t%lld\t%lld\t%llu\t%s\n", escapeField(paths[i]).c_str(),
+                (unsigned long long)result.identity.inode, (long long)result.identity.mtimeSec, (long long)result.identity.mtimeNsec,
+                (unsigned long long)result.identity.size, result.identity.uuids.c_str());
+        for ( const std::string& line : result.errorLines )
+            fprintf(file, "E\t%s\n", escapeField(line).c_str());
+        for ( const std::string& line : result.warningLines )
+            fprintf(file, "W\t%s\n", escapeField(line).c_str());
+    }
+    bool written = (::fclose(file) == 0);
+    if ( !written || (::rename(tempPath.c_str(), cachePath) != 0) ) {
+        ::unlink(tempPath.c_str());
+        fprintf(stderr, "could not write verification cache %s\n", cachePath);
+    }
+}
+
+// Finds all the regular files in the dstroot.  Each level of the tree is read in parallel.  Symlinks are
+// not followed, as the file will be found through its real path
+static void walkDstRoot(CString verifierDstRoot, std::vector<std::string>& paths)
+{
+    std::vector<std::string> dirs = { std::string(verifierDstRoot) };
+    while ( !dirs.empty() ) {
+        std::vector<std::vector<std::string>> subDirs(dirs.size());
+        std::vector<std::vector<std::string>> files(dirs.size());
+
+        const std::string*        dirPaths    = dirs.data();
+        std::vector<std::string>* subDirPaths = subDirs.data();
+        std::vector<std::string>* filePaths   = files.data();
+        dispatch_apply(dirs.size(), DISPATCH_APPLY_AUTO, ^(size_t index) {
+            DIR* dir = ::opendir(dirPaths[index].c_str());
+            if ( dir == nullptr )
+                return;
+            while ( dirent* entry = ::readdir(dir) ) {
+                if ( (strcmp(entry->d_name, ".") == 0) || (strcmp(entry->d_name, "..") == 0) )
+                    continue;
+                std::string path = dirPaths[index] + "/" + entry->d_name;
+                if ( entry->d_type == DT_DIR )
+                    subDirPaths[index].push_back(path);
+                else if ( entry->d_type == DT_REG )
+                    filePaths[index].push_back(path);
+            }
+            ::closedir(dir);
+        });
+
+        dirs.clear();
+        for ( size_t i = 0; i != subDirs.size(); ++i ) {
+            dirs.insert(dirs.end(), subDirs[i].begin(), subDirs[i].end());
+            paths.insert(paths.end(), files[i].begin(), files[i].end());
+        }
+    }
+}
+
+static std::string uuidsForFile(std::span<const uint8_t> buffer)
+{
+    __block std::string uuids;
+    auto addUUID = ^(const Header* header) {
+        uuid_t uuid;
+        uuid_string_t uuidString = { };
+        if ( header->getUuid(uuid) )
+            uuid_unparse_upper(uuid, uuidString);
+        if ( !uuids.empty() )
+            uuids += ",";
+        uuids += uuidString;
+    };
+    if ( const Universal* uni = Universal::isUniversal(buffer) ) {
+        uni->forEachSlice(^(Universal::Slice slice, bool& stopSlice) {
+            if ( const Header* header = Header::isMachO(slice.buffer) )
+                addUUID(header);
+        });
+    }
+    else if ( const Header* header = Header::isMachO(buffer) ) {
+        addUUID(header);
+    }
+    return uuids;
+}
+
+static FileResult verifyFile(const std::string& path, CString verifierDstRoot, const std::vector<CString>& mergeRootPaths,
+                             const std::unordered_map<std::string, FileResult>& cache)
+{
+    __block FileResult result;
+    struct stat statBuf;
+    if ( ::stat(path.c_str(), &statBuf) != 0 )
+        return result;
+    result.identity.inode     = statBuf.st_ino;
+    result.identity.mtimeSec  = statBuf.st_mtimespec.tv_sec;
+    result.identity.mtimeNsec = statBuf.st_mtimespec.tv_nsec;
+    result.identity.size      = statBuf.st_size;
+
+    // Can't map empty files, but they aren't mach-o either
+    if ( statBuf.st_size == 0 ) {
+        result.found = true;
+        return result;
+    }
+
+    CString pathStr = path.c_str();
+    auto    cached  = cache.find(path);
+    result.found = other_tools::withReadOnlyMappedFile(path.c_str(), ^(std::span<const uint8_t> buffer) {
+        // The UUIDs only need the load commands, so this is much cheaper than verifying
+        result.identity.uuids = uuidsForFile(buffer);
+        if ( (cached != cache.end()) && (cached->second.identity == result.identity) ) {
+            result.errorLines   = cached->second.errorLines;
+            result.warningLines = cached->second.warningLines;
+            return;
+        }
+
+        __block std::vector<VerifierError> errors;
+        __block bool                       usedSymlinks = false;
+        if ( const Universal* uni = Universal::isUniversal(buffer) ) {
+            uni->forEachSlice(^(Universal::Slice slice, bool& stopSlice) {
+                const char* sliceArchName = slice.arch.name();
+                if ( Header::isMachO(slice.buffer) ) {
+                    os_macho_verifier(pathStr, slice.buffer, verifierDstRoot, mergeRootPaths, errors, &usedSymlinks);
+                }
+                else {
+                    result.warningLines.push_back(std::string(sliceArchName) + " slice in " + path + " is not a mach-o");
+                }
+            });
+        }
+        else if ( Header::isMachO(buffer) ) {
+            os_macho_verifier(pathStr, buffer, verifierDstRoot, mergeRootPaths, errors, &usedSymlinks);
+        }
+        result.usedSymlinks = usedSymlinks;
+        for ( const VerifierError& err : errors ) {
+            // formatted output the verifier perl script expects
+            result.errorLines.push_back(std::string(err.verifierErrorName) + "\tfatal\t" + err.message.message());
+        }
+    });
+    return result;
+}
+
 
 int main(int argc, const char* argv[])
 {
-    std::vector<CString> paths;
-    std::vector<CString> mergeRootPaths;
-    CString              verifierDstRoot = NULL;
+    std::vector<std::string> paths;
+    std::vector<CString>     mergeRootPaths;
+    CString                  verifierDstRoot = NULL;
+    const char*              cachePath       = nullptr;
+    bool                     walkDstRootDir  = false;
     for (int i=1; i < argc; ++i) {
         CString arg = argv[i];
         if ( arg[0] == '-' ) {
@@ -78,13 +383,19 @@ int main(int argc, const char* argv[])
                 if ( mergeRoot != "/" )
                     mergeRootPaths.push_back(mergeRoot);
             }
+            else if ( arg == "-verifier_cache" ) {
+                cachePath = argv[++i];
+            }
+            else if ( arg == "-walk_dstroot" ) {
+                walkDstRootDir = true;
+            }
             else {
                 fprintf(stderr, "unknown option: %s\n", arg.c_str());
                 exit(1);
             }
         }
         else {
-            paths.push_back(arg);
+            paths.push_back(std::string(arg));
         }
     }
 
@@ -94,35 +405,41 @@ int main(int argc, const char* argv[])
     }
 
 
-    for (CString path : paths) {
-        __block std::vector<VerifierError> errors;
-        bool found = other_tools::withReadOnlyMappedFile(path.c_str(), ^(std::span<const uint8_t> buffer) {
-            if ( const Universal* uni = Universal::isUniversal(buffer) ) {
-                uni->forEachSlice(^(Universal::Slice slice, bool& stopSlice) {
-                    const char* sliceArchName = slice.arch.name();
-                    if ( Header::isMachO(slice.buffer) ) {
-                        os_macho_verifier(path, slice.buffer, verifierDstRoot, mergeRootPaths, errors);
-                    }
-                    else {
-                        fprintf(stderr, "%s slice in %s is not a mach-o\n", sliceArchName, path.c_str());
-                    }
-                });
-            }
-            else if ( Header::isMachO(buffer) ) {
-                os_macho_verifier(path, buffer, verifierDstRoot, mergeRootPaths, errors);
-            }
-        });
-        if ( found ) {
-            for ( const VerifierError& err : errors ) {
-                // print formatted output the verifier perl script expects
-                printf("%s\tfatal\t%s\n", err.verifierErrorName.c_str(), err.message.message());
-            }
-        }
-        else {
-            fprintf(stderr, "file %s not found\n", path.c_str());
+    if ( walkDstRootDir )
+        walkDstRoot(verifierDstRoot, paths);
+
+    // output is in path order, regardless of the order files were given or found in
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+
+    std::string                                 header = cacheHeader(verifierDstRoot, mergeRootPaths);
+    std::unordered_map<std::string, FileResult> cache;
+    if ( cachePath != nullptr )
+        cache = readCache(cachePath, header);
+
+    std::vector<FileResult> results(paths.size());
+    FileResult*             resultsArray = results.data();
+    const std::string*      pathsArray   = paths.data();
+    const auto&             cacheRef     = cache;
+    const auto&             mergeRoots   = mergeRootPaths;
+    dispatch_apply(paths.size(), DISPATCH_APPLY_AUTO, ^(size_t index) {
+        resultsArray[index] = verifyFile(pathsArray[index], verifierDstRoot, mergeRoots, cacheRef);
+    });
+
+    if ( cachePath != nullptr )
+        writeCache(cachePath, header, paths, results);
+
+    for ( size_t i = 0; i != paths.size(); ++i ) {
+        const FileResult& result = results[i];
+        if ( !result.found ) {
+            fprintf(stderr, "file %s not found\n", paths[i].c_str());
             return 1;
         }
-     }
+        for ( const std::string& line : result.warningLines )
+            fprintf(stderr, "%s\n", line.c_str());
+        for ( const std::string& line : result.errorLines )
+            printf("%s\n", line.c_str());
+    }
 
     return 0;
 }
@@ -131,4 +448,3 @@ int main(int argc, const char* argv[])
 
 
 
-
@@ -93,7 +93,8 @@ static bool debugVariantPath(CString path)
     return false;
 }
 
-static void verifyOSDylibInstallName(const Image& image, CString installLocationInDstRoot, CString verifierDstRoot, std::vector<VerifierError>& errors)
+static void verifyOSDylibInstallName(const Image& image, CString installLocationInDstRoot, CString verifierDstRoot, std::vector<VerifierError>& errors,
+                                     bool* usedSymlinks)
 {
     // Don't allow @rpath to be used as -install_name for OS dylibs
     CString installName = image.header()->installName();
@@ -110,6 +111,8 @@ static void verifyOSDylibInstallName(const Image& image, CString installLocation
         if ( installLocationInDstRoot != installName ) {
             // see if install name is a symlink to actual file
             bool symlinkToDylib = false;
+            if ( usedSymlinks != nullptr )
+                *usedSymlinks = true;
             char absDstRootPath[PATH_MAX];
             if ( ::realpath(verifierDstRoot.c_str(), absDstRootPath) != nullptr ) {
                 char fullInstallNamePath[PATH_MAX];
@@ -224,10 +227,11 @@ static void verifyiOSMac(const Image& image, CString installLocationInDstRoot, s
     }
 }
 
-static void checkDylib(const Image& image, CString installLocationInDstRoot, CString verifierDstRoot, std::vector<VerifierError>& errors)
+static void checkDylib(const Image& image, CString installLocationInDstRoot, CString verifierDstRoot, std::vector<VerifierError>& errors,
+                       bool* usedSymlinks)
 {
     if ( Header::isSharedCacheEligiblePath(installLocationInDstRoot.c_str()) ) {
-        verifyOSDylibInstallName(image, installLocationInDstRoot, verifierDstRoot, errors);
+        verifyOSDylibInstallName(image, installLocationInDstRoot, verifierDstRoot, errors, usedSymlinks);
         verifyOSDylibNoRpaths(image, errors);
         verifyOSDylibDoesNotExportMain(image, errors);
         verifyOSDylibNotMergeable(image, errors);
@@ -236,7 +240,8 @@ static void checkDylib(const Image& image, CString installLocationInDstRoot, CSt
 
 // used by machocheck tool and by unit tests
 void os_macho_verifier(CString path, std::span<const uint8_t> buffer, CString verifierDstRoot,
-                       const std::vector<CString>& mergeRootPaths, std::vector<VerifierError>& errors)
+                       const std::vector<CString>& mergeRootPaths, std::vector<VerifierError>& errors,
+                       bool* usedSymlinks)
 {
     Image image(buffer.data(), buffer.size(), Image::MappingKind::wholeSliceMapped);
     if ( Error err = image.validate() ) {
@@ -258,7 +263,7 @@ void os_macho_verifier(CString path, std::span<const uint8_t> buffer, CString ve
         CString installLocationInDstRoot = path.substr(verifierDstRoot.size());
         if ( image.header()->isDylib() ) {
             if ( mergeRootPaths.empty() ) {
-                checkDylib(image, installLocationInDstRoot, verifierDstRoot, errors);
+                checkDylib(image, installLocationInDstRoot, verifierDstRoot, errors, usedSymlinks);
             }
             else {
                 // merge roots are when the project puts the binary in $DSTROOT/usr/lib,
@@ -267,7 +272,7 @@ void os_macho_verifier(CString path, std::span<const uint8_t> buffer, CString ve
                     char fullerPath[PATH_MAX];
                     strlcpy(fullerPath, mergeRoot.c_str(), PATH_MAX);
                     strlcat(fullerPath, installLocationInDstRoot.c_str(), PATH_MAX);
-                    checkDylib(image, fullerPath, verifierDstRoot, errors);
+                    checkDylib(image, fullerPath, verifierDstRoot, errors, usedSymlinks);
                 }
             }
         }
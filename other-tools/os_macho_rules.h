@@ -66,9 +66,14 @@ struct VerifierError
  * @param errors
  *      For each error found in file, a VerifierError is added to this vector.
  *
+ * @param usedSymlinks
+ *      If not null, set to true when a rule resolved symlinks in $DSTROOT, so the result
+ *      depends on more than the content of this file.
+ *
  */
 void os_macho_verifier(CString path, std::span<const uint8_t> buffer, CString verifierDstRoot,
-                       const std::vector<CString>& mergeRootPaths, std::vector<VerifierError>& errors);
+                       const std::vector<CString>& mergeRootPaths, std::vector<VerifierError>& errors,
+                       bool* usedSymlinks = nullptr);
 
 
 